@@ -20,13 +20,16 @@
 // limitations under the License.
 
 #include <iostream>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
 #include "thirdparty/spdlog/spdlog.h"
 
 #include "app/Version.hh"
+#include "io/StrProfile.hh"
 #include "merge/MergeWorkflow.hh"
+#include "merge/QueryWorkflow.hh"
 #include "profile/ProfileWorkflow.hh"
 
 namespace po = boost::program_options;
@@ -36,7 +39,9 @@ using std::string;
 enum class Workflow
 {
     kProfile,
-    kMerge
+    kMerge,
+    kConvert,
+    kQuery
 };
 
 int readBaselineOptions(int argc, char** argv)
@@ -46,7 +51,9 @@ int readBaselineOptions(int argc, char** argv)
         + "\n\nUsage: ExpansionHunterDenovo <command> [options]\n\n"
         + "Commands:\n"
         + " profile  Compute genome-wide STR profile\n"
-        + " merge    Generate multisample STR profile from single-sample profiles";
+        + " merge    Generate multisample STR profile from single-sample profiles\n"
+        + " convert  Convert single-sample STR profile between JSON and binary formats\n"
+        + " query    Extract counts for selected regions, motifs, or samples from multisample store";
 
     po::options_description options("Available commands");
     options.add_options()
@@ -86,19 +93,36 @@ int runProfileWorkflow(int argc, char** argv)
     int minMapqOfAnchorRead = 50;
     int maxMapqOfInrepeatRead = 40;
     bool enableReadLog = false;
+    string profileFormatEncoding = "json";
+    ProfileWorkflowOptions workflowOptions;
 
     // clang-format off
     po::options_description options("Available options");
     options.add_options()
         ("help", "Print help message")
-        ("reads", po::value<string>(&pathToReads)->required(), "BAM or CRAM file with aligned reads")
-        ("reference", po::value<string>(&pathToReference)->required(), "FASTA file with reference assembly")
+        ("reads", po::value<string>(&pathToReads), "BAM or CRAM file with aligned reads")
+        ("reference", po::value<string>(&pathToReference), "FASTA file with reference assembly")
         ("output-prefix", po::value<string>(&outputPrefix)->required(), "Prefix for the output files")
         ("min-unit-len", po::value<int>(&shortestUnitToConsider)->default_value(shortestUnitToConsider), "Shortest repeat unit to consider")
         ("max-unit-len", po::value<int>(&longestUnitToConsider)->default_value(longestUnitToConsider), "Longest repeat unit to consider")
         ("min-anchor-mapq", po::value<int>(&minMapqOfAnchorRead)->default_value(minMapqOfAnchorRead), "Minimum MAPQ of an anchor read")
         ("max-irr-mapq", po::value<int>(&maxMapqOfInrepeatRead)->default_value(maxMapqOfInrepeatRead), "Maximum MAPQ of an in-repeat read")
-        ("log-reads", po::bool_switch(&enableReadLog), "Log informative reads");
+        ("log-reads", po::bool_switch(&enableReadLog), "Log informative reads")
+        ("profile-format", po::value<string>(&profileFormatEncoding)->default_value(profileFormatEncoding), "Format of the STR profile (json or binary)")
+        ("bin-size", po::value<int>(&workflowOptions.binSize)->default_value(workflowOptions.binSize), "Also record anchored IRR counts in reference bins of this size (0 disables binning)")
+        ("profile-bundle", po::value<string>(&workflowOptions.pathToProfileBundle), "Append the STR profile to this bundle instead of writing a profile file")
+        ("sample-id", po::value<string>(&workflowOptions.sampleId), "Id of the sample in the profile bundle (defaults to the file name of the output prefix)")
+        ("cache-dir", po::value<string>(&workflowOptions.pathToCache), "Directory with outputs of earlier runs that are reused if the reads and parameters match")
+        ("fingerprint-content", po::bool_switch(&workflowOptions.hashInputContent), "Include a checksum of the entire file with reads in its fingerprint")
+        ("write-sidecar", po::bool_switch(&workflowOptions.writeSidecar), "Also write a sidecar of informative reads for recomputing the profile with other thresholds")
+        ("from-sidecar", po::value<string>(&workflowOptions.pathToInputSidecar), "Recompute the profile from this sidecar instead of reading --reads and --reference")
+        ("checkpoint-interval", po::value<int>(&workflowOptions.checkpointInterval)->default_value(workflowOptions.checkpointInterval), "Seconds between checkpoints of the analysis, which is also checkpointed on SIGTERM (0 disables checkpoints)")
+        ("resume", po::bool_switch(&workflowOptions.resume), "Continue the analysis from the checkpoint of an interrupted run if there is one")
+        ("evidence-bam", po::bool_switch(&workflowOptions.writeEvidenceBam), "Also write an indexed bamlet with the alignments of informative fragments")
+        ("threads", po::value<int>(&workflowOptions.numThreads)->default_value(workflowOptions.numThreads), "Number of threads compressing the evidence bamlet, the locus table, and the profile")
+        ("compress-locus-table", po::bool_switch(&workflowOptions.compressLocusTable), "Write the locus table sorted by position, compressed with BGZF, and indexed with tabix")
+        ("compress-profile", po::bool_switch(&workflowOptions.compressProfile), "Write the STR profile compressed with BGZF")
+        ("index-stats", po::bool_switch(&workflowOptions.estimateStatsFromIndex), "Estimate depth and read length from the index and the first reads instead of from all reads");
     // clang-format on
 
     po::variables_map optionsMap;
@@ -127,12 +151,19 @@ int runProfileWorkflow(int argc, char** argv)
         return 1;
     }
 
+    if (workflowOptions.pathToInputSidecar.empty() && (pathToReads.empty() || pathToReference.empty()))
+    {
+        std::cerr << "Options --reads and --reference are required unless --from-sidecar is set" << std::endl;
+        return 1;
+    }
+
     spdlog::info("Starting {} profile workflow", kProgramVersion);
 
     Interval motifSizeRange(shortestUnitToConsider, longestUnitToConsider);
+    workflowOptions.profileFormat = decodeStrProfileFormat(profileFormatEncoding);
     ProfileWorkflowParameters params(
         outputPrefix, enableReadLog, pathToReads, pathToReference, motifSizeRange, minMapqOfAnchorRead,
-        maxMapqOfInrepeatRead);
+        maxMapqOfInrepeatRead, workflowOptions);
 
     return runProfileWorkflow(params);
 }
@@ -146,6 +177,8 @@ int runMergeWorkflow(int argc, char** argv)
     string outputPrefix;
     int shortestUnitToConsider = 2;
     int longestUnitToConsider = 20;
+    int memoryBudgetInMb = 0;
+    MergeWorkflowOptions workflowOptions;
 
     // clang-format off
     po::options_description options("Available options");
@@ -154,8 +187,19 @@ int runMergeWorkflow(int argc, char** argv)
         ("reference", po::value<string>(&pathToReference)->required(), "FASTA file with reference assembly")
         ("manifest", po::value<string>(&pathToManifest)->required(), "TSV with sample names and absolute paths")
         ("output-prefix", po::value<string>(&outputPrefix)->required(), "Prefix for the output files")
+        ("base", po::value<string>(&workflowOptions.pathToBaseProfile), "Existing multisample profile to add the samples to")
         ("min-unit-len", po::value<int>(&shortestUnitToConsider)->default_value(shortestUnitToConsider), "Shortest repeat unit to consider")
-        ("max-unit-len", po::value<int>(&longestUnitToConsider)->default_value(longestUnitToConsider), "Longest repeat unit to consider");
+        ("max-unit-len", po::value<int>(&longestUnitToConsider)->default_value(longestUnitToConsider), "Longest repeat unit to consider")
+        ("threads", po::value<int>(&workflowOptions.threadCount)->default_value(workflowOptions.threadCount), "Number of threads loading profiles and scoring outliers")
+        ("memory-budget-mb", po::value<int>(&memoryBudgetInMb)->default_value(memoryBudgetInMb), "Memory for regions above which they are spilled to disk (0 keeps all regions in memory)")
+        ("use-bins", po::bool_switch(&workflowOptions.useBins), "Merge binned anchored IRR counts instead of clustering regions")
+        ("target-regions", po::value<string>(&workflowOptions.pathToTargetRegions), "BED file with target regions; regions not overlapping them are dropped while profiles are loaded")
+        ("output-store", po::bool_switch(&workflowOptions.writeStore), "Also write multisample store for fast queries")
+        ("output-arrow", po::bool_switch(&workflowOptions.writeArrowTables), "Also write sample, locus, and count tables in Arrow IPC format")
+        ("outlier-output", po::bool_switch(&workflowOptions.writeOutlierTables), "Also run outlier analysis and write locus and motif tables")
+        ("casecontrol-output", po::bool_switch(&workflowOptions.writeCaseControlTables), "Also run case-control analysis and write locus and motif tables")
+        ("min-inrepeat-reads", po::value<int>(&workflowOptions.minInrepeatReads)->default_value(workflowOptions.minInrepeatReads), "Minimal normalized count of anchored IRRs of regions in case-control analysis")
+        ("min-inrepeat-read-pairs", po::value<int>(&workflowOptions.minInrepeatReadPairs)->default_value(workflowOptions.minInrepeatReadPairs), "Minimal normalized count of IRR pairs of motifs in case-control analysis");
     // clang-format on
 
     po::variables_map optionsMap;
@@ -186,11 +230,115 @@ int runMergeWorkflow(int argc, char** argv)
 
     spdlog::info("Starting {} profile workflow", kProgramVersion);
 
+    if (memoryBudgetInMb < 0)
+    {
+        std::cerr << "Memory budget cannot be negative" << std::endl;
+        return 1;
+    }
+
+    workflowOptions.memoryBudget = static_cast<size_t>(memoryBudgetInMb) * 1024 * 1024;
     MergeWorkflowParameters params(
-        pathToReference, outputPrefix, pathToManifest, shortestUnitToConsider, longestUnitToConsider);
+        pathToReference, outputPrefix, pathToManifest, shortestUnitToConsider, longestUnitToConsider, workflowOptions);
     return runMergeWorkflow(params);
 }
 
+int runConvertWorkflow(int argc, char** argv)
+{
+    string helpHeader = "Usage: ExpansionHunterDenovo convert [options]\n\n";
+
+    string inputPath;
+    string outputPath;
+
+    // clang-format off
+    po::options_description options("Available options");
+    options.add_options()
+        ("help", "Print help message")
+        ("input", po::value<string>(&inputPath)->required(), "STR profile in JSON or binary format")
+        ("output", po::value<string>(&outputPath)->required(), "Output path for the profile in the other format");
+    // clang-format on
+
+    po::variables_map optionsMap;
+
+    if (argc == 1)
+    {
+        std::cerr << helpHeader << options << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).run(), optionsMap);
+
+        if (optionsMap.count("help"))
+        {
+            std::cerr << helpHeader << options << std::endl;
+            return 0;
+        }
+
+        po::notify(optionsMap);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    const StrProfileFormat inputFormat = detectStrProfileFormat(inputPath);
+    const StrProfileFormat outputFormat
+        = inputFormat == StrProfileFormat::kJson ? StrProfileFormat::kBinary : StrProfileFormat::kJson;
+
+    spdlog::info("Converting {} to {}", inputPath, outputPath);
+    writeStrProfile(loadStrProfile(inputPath), outputFormat, outputPath);
+    spdlog::info("Done");
+    return 0;
+}
+
+int runQueryWorkflow(int argc, char** argv)
+{
+    string helpHeader = "Usage: ExpansionHunterDenovo query [options]\n\n";
+
+    QueryWorkflowParameters params;
+
+    // clang-format off
+    po::options_description options("Available options");
+    options.add_options()
+        ("help", "Print help message")
+        ("store", po::value<string>(&params.pathToStore)->required(), "Multisample store generated by merge")
+        ("output", po::value<string>(&params.pathToOutput)->required(), "Output path for the selected counts in multisample profile format")
+        ("motif", po::value<std::vector<string>>(&params.motifs)->multitoken(), "Motifs to report (all motifs by default)")
+        ("region", po::value<std::vector<string>>(&params.regionEncodings)->multitoken(), "Regions to report, e.g. chr1:1000-2000 (all regions by default)")
+        ("sample", po::value<std::vector<string>>(&params.sampleIds)->multitoken(), "Samples to report (all samples by default)");
+    // clang-format on
+
+    po::variables_map optionsMap;
+
+    if (argc == 1)
+    {
+        std::cerr << helpHeader << options << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).run(), optionsMap);
+
+        if (optionsMap.count("help"))
+        {
+            std::cerr << helpHeader << options << std::endl;
+            return 0;
+        }
+
+        po::notify(optionsMap);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return runQueryWorkflow(params);
+}
+
 int main(int argc, char** argv)
 {
     try
@@ -209,6 +357,14 @@ int main(int argc, char** argv)
         {
             return runMergeWorkflow(argc - 1, argv + 1);
         }
+        else if (command == "convert")
+        {
+            return runConvertWorkflow(argc - 1, argv + 1);
+        }
+        else if (command == "query")
+        {
+            return runQueryWorkflow(argc - 1, argv + 1);
+        }
         else
         {
             return readBaselineOptions(argc, argv);
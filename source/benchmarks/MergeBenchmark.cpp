@@ -0,0 +1,243 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Times the stages of the merge workflow on synthetic cohorts of increasing size. For each cohort size, the wall
+// time and the peak resident set size of loading sample profiles, normalizing the merged regions, and writing the
+// multisample profile are reported as a TSV table.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include "benchmarks/SyntheticCohort.hh"
+#include "merge/MultisampleProfile.hh"
+#include "merge/MultisampleProfileWriter.hh"
+#include "merge/SampleProfileLoader.hh"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+using std::string;
+using std::vector;
+
+// Peak RSS is tracked per phase by resetting the high-water mark of the process; kernels that do not support the
+// reset report the peak since the start of the process instead
+static void resetPeakRss()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+static long getPeakRssInKb()
+{
+    std::ifstream status("/proc/self/status");
+    string field;
+    while (status >> field)
+    {
+        if (field == "VmHWM:")
+        {
+            long peakRss = 0;
+            status >> peakRss;
+            return peakRss;
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Accumulates wall time and peak RSS over the (possibly interleaved) intervals of a phase
+class PhaseMeter
+{
+public:
+    explicit PhaseMeter(string name)
+        : name_(std::move(name))
+    {
+    }
+
+    void start()
+    {
+        resetPeakRss();
+        startTime_ = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        elapsed_ += std::chrono::steady_clock::now() - startTime_;
+        peakRssInKb_ = std::max(peakRssInKb_, getPeakRssInKb());
+    }
+
+    void report(int numSamples) const
+    {
+        std::cout << numSamples << "\t" << name_ << "\t" << std::fixed << std::setprecision(3) << elapsed_.count()
+                  << "\t" << std::setprecision(1) << peakRssInKb_ / 1024.0 << std::endl;
+    }
+
+private:
+    string name_;
+    std::chrono::steady_clock::time_point startTime_;
+    std::chrono::duration<double> elapsed_ { 0 };
+    long peakRssInKb_ = 0;
+};
+
+// Mirrors the in-memory merge: profiles are loaded one by one and the merged regions are normalized periodically
+static void runBenchmark(
+    const Manifest& manifest, const ReferenceContigInfo& contigInfo, const string& pathToOutput, int numSamples)
+{
+    const int kNormalizationStride = 50;
+    const ProfileLoadingParameters loadingParameters(2, 20);
+    ProfileBundleCache bundles;
+
+    PhaseMeter loadMeter("load");
+    PhaseMeter normalizeMeter("normalize");
+    PhaseMeter writeMeter("write");
+
+    MultisampleAnchoredIrrProfile anchoredIrrProfile;
+    MultisampleIrrPairProfile irrPairProfile;
+    SampleIdToSampleParameters parametersForSamples;
+    int sampleCount = 0;
+    for (const auto& sampleInfo : manifest)
+    {
+        loadMeter.start();
+        auto sampleProfile = loadSampleProfile(sampleInfo, contigInfo, loadingParameters, bundles);
+        addAnchoredIrrProfile(sampleProfile->anchoredIrrProfile, anchoredIrrProfile);
+        for (const auto& motifAndCounts : sampleProfile->irrPairProfile)
+        {
+            irrPairProfile[motifAndCounts.first].insert(motifAndCounts.second.begin(), motifAndCounts.second.end());
+        }
+        const auto& sampleParameters = sampleProfile->parametersForSamples;
+        parametersForSamples.insert(sampleParameters.begin(), sampleParameters.end());
+        sampleProfile.reset();
+        loadMeter.stop();
+
+        if (++sampleCount % kNormalizationStride == 0)
+        {
+            normalizeMeter.start();
+            normalize(anchoredIrrProfile);
+            normalizeMeter.stop();
+        }
+    }
+    normalizeMeter.start();
+    normalize(anchoredIrrProfile);
+    normalizeMeter.stop();
+
+    writeMeter.start();
+    vector<Motif> motifs;
+    for (const auto& motifAndRegions : anchoredIrrProfile)
+    {
+        motifs.push_back(motifAndRegions.first);
+    }
+    for (const auto& motifAndCounts : irrPairProfile)
+    {
+        motifs.push_back(motifAndCounts.first);
+    }
+    std::sort(motifs.begin(), motifs.end());
+    motifs.erase(std::unique(motifs.begin(), motifs.end()), motifs.end());
+
+    std::ofstream profileFile(pathToOutput);
+    MultisampleProfileWriter writer(contigInfo, profileFile);
+    for (const auto& motif : motifs)
+    {
+        const auto irrPairCounts = irrPairProfile.find(motif);
+        const auto regionsWithIrrAnchors = anchoredIrrProfile.find(motif);
+        writer.addMotif(
+            motif, irrPairCounts != irrPairProfile.end() ? &irrPairCounts->second : nullptr,
+            regionsWithIrrAnchors != anchoredIrrProfile.end() ? &regionsWithIrrAnchors->second : nullptr);
+    }
+    writer.finish(parametersForSamples);
+    profileFile.close();
+    writeMeter.stop();
+
+    loadMeter.report(numSamples);
+    normalizeMeter.report(numSamples);
+    writeMeter.report(numSamples);
+}
+
+int main(int argc, char** argv)
+{
+    vector<int> sampleCounts = { 100, 1000, 10000 };
+    SyntheticCohortParameters cohortParameters;
+    string formatEncoding = "json";
+    string workDirectory = "merge_benchmark";
+    bool keepFiles = false;
+
+    // clang-format off
+    po::options_description options("Available options");
+    options.add_options()
+        ("help", "Print help message")
+        ("samples", po::value<vector<int>>(&sampleCounts)->multitoken(), "Cohort sizes to benchmark (default: 100 1000 10000)")
+        ("motifs", po::value<int>(&cohortParameters.numMotifs)->default_value(cohortParameters.numMotifs), "Number of motifs per sample")
+        ("regions-per-motif", po::value<int>(&cohortParameters.numRegionsPerMotif)->default_value(cohortParameters.numRegionsPerMotif), "Number of regions with anchored IRRs per motif and sample")
+        ("shared-fraction", po::value<double>(&cohortParameters.sharedRegionFraction)->default_value(cohortParameters.sharedRegionFraction), "Fraction of regions at loci shared by the cohort")
+        ("format", po::value<string>(&formatEncoding)->default_value(formatEncoding), "Format of the sample profiles (json or binary)")
+        ("seed", po::value<unsigned>(&cohortParameters.seed)->default_value(cohortParameters.seed), "Seed of the cohort generator")
+        ("work-dir", po::value<string>(&workDirectory)->default_value(workDirectory), "Directory for the generated profiles")
+        ("keep-files", po::bool_switch(&keepFiles), "Keep the generated profiles and multisample profiles");
+    // clang-format on
+
+    try
+    {
+        po::variables_map optionsMap;
+        po::store(po::command_line_parser(argc, argv).options(options).run(), optionsMap);
+        if (optionsMap.count("help"))
+        {
+            std::cerr << "Usage: MergeBenchmark [options]\n\n" << options << std::endl;
+            return 0;
+        }
+        po::notify(optionsMap);
+        cohortParameters.format = decodeStrProfileFormat(formatEncoding);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    const ReferenceContigInfo contigInfo = generateSyntheticContigs(cohortParameters.numContigs);
+    std::cout << "samples\tphase\twall_time_s\tpeak_rss_mb" << std::endl;
+    for (int numSamples : sampleCounts)
+    {
+        const string cohortDirectory = workDirectory + "/cohort" + std::to_string(numSamples);
+        fs::create_directories(cohortDirectory);
+
+        cohortParameters.numSamples = numSamples;
+        const Manifest manifest = generateSyntheticCohort(cohortParameters, contigInfo, cohortDirectory);
+        runBenchmark(manifest, contigInfo, cohortDirectory + ".multisample_profile.json", numSamples);
+
+        if (!keepFiles)
+        {
+            fs::remove_all(cohortDirectory);
+            fs::remove(cohortDirectory + ".multisample_profile.json");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Times the per-read stage of the profile workflow (streaming, decoding, and classifying primary reads) and counts
+// the heap allocations it performs. Once the first reads have grown the reusable buffers, reads must be processed
+// without allocating; the benchmark fails if they are not.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "io/HtsFileStreamer.hh"
+#include "profile/ReadClassification.hh"
+#include "profile/SampleRunStats.hh"
+
+namespace po = boost::program_options;
+
+using std::string;
+
+static std::atomic<bool> isCountingAllocations(false);
+static std::atomic<int64_t> numAllocations(0);
+
+void* operator new(size_t numBytes)
+{
+    if (isCountingAllocations)
+    {
+        ++numAllocations;
+    }
+
+    void* ptr = std::malloc(numBytes == 0 ? 1 : numBytes);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void* operator new[](size_t numBytes) { return operator new(numBytes); }
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+
+// The sized and aligned forms must be replaced too, otherwise they would release memory from the replaced operator new
+// with the allocator of the standard library
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+#endif
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t numBytes, std::align_val_t alignment)
+{
+    if (isCountingAllocations)
+    {
+        ++numAllocations;
+    }
+
+    const auto alignmentInBytes = static_cast<size_t>(alignment);
+    const size_t paddedNumBytes = (numBytes + alignmentInBytes - 1) / alignmentInBytes * alignmentInBytes;
+    void* ptr = std::aligned_alloc(alignmentInBytes, paddedNumBytes == 0 ? alignmentInBytes : paddedNumBytes);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+void* operator new[](size_t numBytes, std::align_val_t alignment) { return operator new(numBytes, alignment); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+#endif
+
+struct PassResult
+{
+    int64_t numReads = 0;
+    int64_t numSteadyStateReads = 0;
+    int64_t numSteadyStateAllocations = 0;
+    std::chrono::duration<double> elapsed { 0 };
+};
+
+// Mirrors the main loop of the profile workflow up to the pair collector; as in the workflow, the read and the motif
+// are reused across reads (and here also across passes). Allocations are counted once the warm-up reads, which may
+// span several passes, are processed.
+static PassResult runPass(
+    const string& pathToReads, const string& pathToReference, const Interval& motifSizeRange, Read& read,
+    string& motif, int64_t& numWarmUpReadsLeft)
+{
+    const int kMaxMapqOfInrepeatRead = 40;
+    const int kMinMapqOfAnchorRead = 50;
+
+    HtsFileStreamer readStreamer(pathToReads, pathToReference);
+    SampleRunStatsCalculator statsCalculator(readStreamer.contigInfo());
+    PassResult result;
+
+    numAllocations = 0;
+    isCountingAllocations = numWarmUpReadsLeft == 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    while (readStreamer.trySeekingToNextPrimaryAlignment())
+    {
+        statsCalculator.inspect(readStreamer.currentReadContigId(), readStreamer.currentReadLength());
+        readStreamer.decodeRead(read);
+        classifyRead(motifSizeRange, kMaxMapqOfInrepeatRead, kMinMapqOfAnchorRead, read, motif);
+
+        ++result.numReads;
+        if (isCountingAllocations)
+        {
+            ++result.numSteadyStateReads;
+        }
+        else if (--numWarmUpReadsLeft == 0)
+        {
+            isCountingAllocations = true;
+        }
+    }
+    isCountingAllocations = false;
+    result.elapsed = std::chrono::steady_clock::now() - startTime;
+    result.numSteadyStateAllocations = numAllocations;
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    string pathToReads;
+    string pathToReference;
+    int shortestUnitToConsider = 2;
+    int longestUnitToConsider = 20;
+    int64_t numWarmUpReads = 10000;
+    int numPasses = 1;
+
+    // clang-format off
+    po::options_description options("Available options");
+    options.add_options()
+        ("help", "Print help message")
+        ("reads", po::value<string>(&pathToReads)->required(), "BAM or CRAM file with aligned reads")
+        ("reference", po::value<string>(&pathToReference)->default_value(pathToReference), "FASTA file with reference assembly (required for CRAM files)")
+        ("min-unit-len", po::value<int>(&shortestUnitToConsider)->default_value(shortestUnitToConsider), "Shortest repeat unit to consider")
+        ("max-unit-len", po::value<int>(&longestUnitToConsider)->default_value(longestUnitToConsider), "Longest repeat unit to consider")
+        ("warm-up-reads", po::value<int64_t>(&numWarmUpReads)->default_value(numWarmUpReads), "Number of reads processed before allocations are counted, possibly over several passes")
+        ("passes", po::value<int>(&numPasses)->default_value(numPasses), "Number of passes over the file");
+    // clang-format on
+
+    try
+    {
+        po::variables_map optionsMap;
+        po::store(po::command_line_parser(argc, argv).options(options).run(), optionsMap);
+        if (optionsMap.count("help"))
+        {
+            std::cerr << "Usage: ProfileLoopBenchmark [options]\n\n" << options << std::endl;
+            return 0;
+        }
+        po::notify(optionsMap);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    const Interval motifSizeRange(shortestUnitToConsider, longestUnitToConsider);
+    Read read;
+    string motif;
+    int64_t numWarmUpReadsLeft = numWarmUpReads;
+    int64_t totalSteadyStateReads = 0;
+    int64_t totalSteadyStateAllocations = 0;
+    std::cout << "pass\treads\twall_time_s\treads_per_s\tsteady_state_reads\tsteady_state_allocations" << std::endl;
+    for (int pass = 1; pass <= numPasses; ++pass)
+    {
+        const PassResult result
+            = runPass(pathToReads, pathToReference, motifSizeRange, read, motif, numWarmUpReadsLeft);
+        totalSteadyStateReads += result.numSteadyStateReads;
+        totalSteadyStateAllocations += result.numSteadyStateAllocations;
+        std::cout << pass << "\t" << result.numReads << "\t" << std::fixed << std::setprecision(3)
+                  << result.elapsed.count() << "\t" << std::setprecision(0) << result.numReads / result.elapsed.count()
+                  << "\t" << result.numSteadyStateReads << "\t" << result.numSteadyStateAllocations << std::endl;
+    }
+
+    if (totalSteadyStateReads == 0)
+    {
+        std::cerr << "No reads were processed after the warm-up; consider more passes" << std::endl;
+    }
+    else if (totalSteadyStateAllocations != 0)
+    {
+        std::cerr << "Steady-state reads performed " << totalSteadyStateAllocations << " heap allocations" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
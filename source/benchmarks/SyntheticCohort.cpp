@@ -0,0 +1,134 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmarks/SyntheticCohort.hh"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::string;
+using std::to_string;
+using std::vector;
+
+static const int64_t kContigSize = 50000000;
+static const int kReadLength = 150;
+static const int kMaxLocusJitter = 100;
+
+ReferenceContigInfo generateSyntheticContigs(int numContigs)
+{
+    vector<pair<string, int64_t>> namesAndSizes;
+    for (int contigIndex = 0; contigIndex != numContigs; ++contigIndex)
+    {
+        namesAndSizes.emplace_back("chr" + to_string(contigIndex + 1), kContigSize);
+    }
+
+    return ReferenceContigInfo(namesAndSizes);
+}
+
+static vector<string> generateMotifs(int numMotifs, std::mt19937& generator)
+{
+    static const char kBases[] = { 'A', 'C', 'G', 'T' };
+    std::uniform_int_distribution<int> lengthDistribution(2, 6);
+    std::uniform_int_distribution<int> baseDistribution(0, 3);
+
+    std::set<string> motifs;
+    while (static_cast<int>(motifs.size()) != numMotifs)
+    {
+        string motif(lengthDistribution(generator), 'A');
+        for (char& base : motif)
+        {
+            base = kBases[baseDistribution(generator)];
+        }
+        motifs.insert(motif);
+    }
+
+    return vector<string>(motifs.begin(), motifs.end());
+}
+
+Manifest generateSyntheticCohort(
+    const SyntheticCohortParameters& parameters, const ReferenceContigInfo& contigInfo, const string& directory)
+{
+    std::mt19937 generator(parameters.seed);
+    const vector<string> motifs = generateMotifs(parameters.numMotifs, generator);
+
+    std::uniform_int_distribution<int> contigDistribution(0, contigInfo.numContigs() - 1);
+    std::uniform_int_distribution<int64_t> positionDistribution(0, kContigSize - 1000);
+    std::uniform_int_distribution<int> jitterDistribution(-kMaxLocusJitter, kMaxLocusJitter);
+    std::uniform_int_distribution<int> lengthDistribution(kReadLength, 4 * kReadLength);
+    std::uniform_int_distribution<int> countDistribution(1, 20);
+    std::uniform_int_distribution<int> pairCountDistribution(0, 5);
+    std::uniform_real_distribution<double> depthDistribution(20.0, 50.0);
+    std::uniform_real_distribution<double> unitDistribution(0.0, 1.0);
+
+    // Loci shared by the cohort are fixed per motif; samples observe them at slightly different positions
+    vector<vector<GenomicRegion>> sharedLoci(motifs.size());
+    for (auto& loci : sharedLoci)
+    {
+        for (int locusIndex = 0; locusIndex != parameters.numRegionsPerMotif; ++locusIndex)
+        {
+            const int64_t start = positionDistribution(generator);
+            loci.emplace_back(contigDistribution(generator), start, start + kReadLength);
+        }
+    }
+
+    const string extension = parameters.format == StrProfileFormat::kBinary ? ".str_profile.bin" : ".str_profile.json";
+    Manifest manifest;
+    for (int sampleIndex = 0; sampleIndex != parameters.numSamples; ++sampleIndex)
+    {
+        StrProfile profile(contigInfo);
+        profile.readLength = kReadLength;
+        profile.depth = depthDistribution(generator);
+
+        for (size_t motifIndex = 0; motifIndex != motifs.size(); ++motifIndex)
+        {
+            MotifRecord& record = profile.motifRecords[motifs[motifIndex]];
+            record.irrPairCount = pairCountDistribution(generator);
+            for (int regionIndex = 0; regionIndex != parameters.numRegionsPerMotif; ++regionIndex)
+            {
+                int contigId = contigDistribution(generator);
+                int64_t start = positionDistribution(generator);
+                if (unitDistribution(generator) < parameters.sharedRegionFraction)
+                {
+                    const GenomicRegion& locus = sharedLoci[motifIndex][regionIndex];
+                    contigId = locus.contigId();
+                    start = std::max<int64_t>(0, locus.start() + jitterDistribution(generator));
+                }
+
+                const int count = countDistribution(generator);
+                record.regionsWithIrrAnchors.emplace_back(
+                    contigId, start, start + lengthDistribution(generator), CountFeature(count));
+                record.anchoredIrrCount += count;
+            }
+            std::sort(record.regionsWithIrrAnchors.begin(), record.regionsWithIrrAnchors.end());
+        }
+
+        const string sampleId = "sample" + to_string(sampleIndex);
+        const string path = directory + "/" + sampleId + extension;
+        writeStrProfile(profile, parameters.format, path);
+        manifest.emplace_back(sampleId, sampleIndex % 2 == 0 ? SampleStatus::kCase : SampleStatus::kControl, path);
+    }
+
+    return manifest;
+}
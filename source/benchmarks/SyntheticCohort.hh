@@ -0,0 +1,49 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "io/StrProfile.hh"
+#include "merge/Manifest.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Shape of a synthetic cohort of single-sample STR profiles
+struct SyntheticCohortParameters
+{
+    int numSamples = 100;
+    int numContigs = 22;
+    int numMotifs = 20;
+    int numRegionsPerMotif = 10;
+    // Fraction of regions of each sample drawn from loci shared by the cohort; the remaining regions are placed at
+    // random and rarely overlap regions of other samples
+    double sharedRegionFraction = 0.5;
+    StrProfileFormat format = StrProfileFormat::kJson;
+    unsigned seed = 1;
+};
+
+ReferenceContigInfo generateSyntheticContigs(int numContigs);
+
+// Writes a profile for each sample to the directory and returns the manifest of the cohort; cohorts generated with
+// the same parameters are identical
+Manifest generateSyntheticCohort(
+    const SyntheticCohortParameters& parameters, const ReferenceContigInfo& contigInfo, const std::string& directory);
@@ -0,0 +1,133 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/BinaryCoding.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+using std::string;
+
+void BinaryEncoder::writeVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+}
+
+void BinaryEncoder::writeSignedVarint(int64_t value)
+{
+    const uint64_t zigzagEncoding = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    writeVarint(zigzagEncoding);
+}
+
+void BinaryEncoder::writeFixed64(uint64_t value)
+{
+    for (int byteIndex = 0; byteIndex != 8; ++byteIndex)
+    {
+        buffer_.push_back(static_cast<char>((value >> (8 * byteIndex)) & 0xff));
+    }
+}
+
+void BinaryEncoder::writeDouble(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeFixed64(bits);
+}
+
+void BinaryEncoder::writeString(const string& value)
+{
+    writeVarint(value.size());
+    buffer_.append(value);
+}
+
+void BinaryEncoder::writeBytes(const char* bytes, size_t numBytes) { buffer_.append(bytes, numBytes); }
+
+void BinaryDecoder::assertAvailable(size_t numBytes) const
+{
+    if (static_cast<size_t>(end_ - position_) < numBytes)
+    {
+        throw std::runtime_error("Unexpected end of binary data");
+    }
+}
+
+uint64_t BinaryDecoder::readVarint()
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        assertAvailable(1);
+        const auto byte = static_cast<uint8_t>(*position_++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+
+    throw std::runtime_error("Malformed varint in binary data");
+}
+
+int64_t BinaryDecoder::readSignedVarint()
+{
+    const uint64_t zigzagEncoding = readVarint();
+    return static_cast<int64_t>(zigzagEncoding >> 1) ^ -static_cast<int64_t>(zigzagEncoding & 1);
+}
+
+uint64_t BinaryDecoder::readFixed64()
+{
+    assertAvailable(8);
+    uint64_t value = 0;
+    for (int byteIndex = 0; byteIndex != 8; ++byteIndex)
+    {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(*position_++)) << (8 * byteIndex);
+    }
+
+    return value;
+}
+
+double BinaryDecoder::readDouble()
+{
+    const uint64_t bits = readFixed64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+string BinaryDecoder::readString()
+{
+    const uint64_t length = readVarint();
+    assertAvailable(length);
+    string value(position_, length);
+    position_ += length;
+    return value;
+}
+
+void BinaryDecoder::readBytes(char* bytes, size_t numBytes)
+{
+    assertAvailable(numBytes);
+    std::memcpy(bytes, position_, numBytes);
+    position_ += numBytes;
+}
@@ -0,0 +1,73 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Primitives for compact binary files: unsigned integers are stored as LEB128 varints, signed integers are
+// zigzag-encoded first, fixed-width integers and doubles are stored in eight little-endian bytes, and strings are
+// prefixed by their length.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class BinaryEncoder
+{
+public:
+    void writeVarint(uint64_t value);
+    void writeSignedVarint(int64_t value);
+    void writeFixed64(uint64_t value);
+    void writeDouble(double value);
+    void writeString(const std::string& value);
+    void writeBytes(const char* bytes, size_t numBytes);
+
+    const std::string& buffer() const { return buffer_; }
+    void clear() { buffer_.clear(); }
+
+private:
+    std::string buffer_;
+};
+
+class BinaryDecoder
+{
+public:
+    BinaryDecoder(const char* begin, const char* end)
+        : position_(begin)
+        , end_(end)
+    {
+    }
+
+    uint64_t readVarint();
+    int64_t readSignedVarint();
+    uint64_t readFixed64();
+    double readDouble();
+    std::string readString();
+    void readBytes(char* bytes, size_t numBytes);
+
+    bool atEnd() const { return position_ == end_; }
+    size_t numRemainingBytes() const { return end_ - position_; }
+
+private:
+    void assertAvailable(size_t numBytes) const;
+
+    const char* position_;
+    const char* end_;
+};
@@ -0,0 +1,92 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/JsonStreamWriter.hh"
+
+#include <stdexcept>
+
+#include "thirdparty/nlohmann_json/json.hpp"
+
+using std::string;
+
+void JsonStreamWriter::startObject()
+{
+    out_ << '{';
+    memberCounts_.push_back(0);
+}
+
+void JsonStreamWriter::endObject()
+{
+    if (memberCounts_.empty())
+    {
+        throw std::logic_error("Attempting to close JSON object that was not opened");
+    }
+
+    const int memberCount = memberCounts_.back();
+    memberCounts_.pop_back();
+
+    if (memberCount != 0)
+    {
+        out_ << '\n' << string(indent_ * memberCounts_.size(), ' ');
+    }
+    out_ << '}';
+}
+
+void JsonStreamWriter::key(const string& name)
+{
+    if (memberCounts_.empty())
+    {
+        throw std::logic_error("JSON key " + name + " must be written inside of an object");
+    }
+
+    if (memberCounts_.back()++ != 0)
+    {
+        out_ << ',';
+    }
+
+    out_ << '\n' << string(indent_ * memberCounts_.size(), ' ');
+    writeString(name);
+    out_ << ": ";
+}
+
+void JsonStreamWriter::value(int64_t number) { out_ << number; }
+
+void JsonStreamWriter::value(double number) { out_ << nlohmann::json(number).dump(); }
+
+void JsonStreamWriter::value(const string& text) { writeString(text); }
+
+void JsonStreamWriter::null() { out_ << "null"; }
+
+void JsonStreamWriter::writeString(const string& text)
+{
+    // Strings that do not need escaping are the common case and are written as is
+    for (const char character : text)
+    {
+        const auto code = static_cast<unsigned char>(character);
+        if (code < 0x20 || 0x7f <= code || character == '"' || character == '\\')
+        {
+            out_ << nlohmann::json(text).dump();
+            return;
+        }
+    }
+
+    out_ << '"' << text << '"';
+}
@@ -0,0 +1,59 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Writes JSON directly to an output stream without building a document in memory. The output is formatted
+// identically to nlohmann::json::dump with the same indentation provided that object keys are written in sorted
+// order.
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class JsonStreamWriter
+{
+public:
+    JsonStreamWriter(std::ostream& out, int indent)
+        : out_(out)
+        , indent_(indent)
+    {
+    }
+
+    void startObject();
+    void endObject();
+    void key(const std::string& name);
+
+    void value(int number) { value(static_cast<int64_t>(number)); }
+    void value(int64_t number);
+    void value(double number);
+    void value(const std::string& text);
+    void null();
+
+private:
+    void writeString(const std::string& text);
+
+    std::ostream& out_;
+    int indent_;
+    // Number of members written so far to each open object
+    std::vector<int> memberCounts_;
+};
@@ -0,0 +1,88 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Hands out indexes of work items to threads
+class WorkQueue
+{
+public:
+    explicit WorkQueue(size_t numItems)
+        : nextItem_(0)
+        , numItems_(numItems)
+    {
+    }
+
+    bool tryClaim(size_t& item)
+    {
+        item = nextItem_++;
+        return item < numItems_;
+    }
+
+private:
+    std::atomic<size_t> nextItem_;
+    size_t numItems_;
+};
+
+// Runs worker(queue) on up to threadCount threads, including the calling thread, until all items are claimed; the
+// first error raised by a worker is rethrown once all threads finish
+template <typename Worker> void processOnThreads(size_t numItems, int threadCount, Worker worker)
+{
+    WorkQueue queue(numItems);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    const auto runWorker = [&]() {
+        try
+        {
+            worker(queue);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            error = error ? error : std::current_exception();
+        }
+    };
+
+    const size_t numThreads = std::min(static_cast<size_t>(std::max(threadCount, 1)), std::max(numItems, size_t(1)));
+    std::vector<std::thread> threads;
+    for (size_t threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+    {
+        threads.emplace_back(runWorker);
+    }
+    runWorker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,99 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// Fixed buffer for short-lived containers on hot paths. Allocations are carved out of the buffer and released all at
+// once when the arena goes out of scope; requests that do not fit fall back to the heap.
+class ScratchArena
+{
+public:
+    static const size_t kCapacity = 2048;
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    void* allocate(size_t numBytes)
+    {
+        const size_t kAlignment = alignof(std::max_align_t);
+        const size_t start = (numBytesUsed_ + kAlignment - 1) / kAlignment * kAlignment;
+        if (start + numBytes > kCapacity)
+        {
+            return ::operator new(numBytes);
+        }
+
+        numBytesUsed_ = start + numBytes;
+        return buffer_ + start;
+    }
+
+    void deallocate(void* ptr)
+    {
+        if (ptr < static_cast<void*>(buffer_) || ptr >= static_cast<void*>(buffer_ + kCapacity))
+        {
+            ::operator delete(ptr);
+        }
+    }
+
+private:
+    alignas(std::max_align_t) char buffer_[kCapacity];
+    size_t numBytesUsed_ = 0;
+};
+
+// Standard allocator interface to a scratch arena
+template <typename T> class ScratchAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ScratchAllocator(ScratchArena& arena)
+        : arena_(&arena)
+    {
+    }
+
+    template <typename U>
+    ScratchAllocator(const ScratchAllocator<U>& other)
+        : arena_(other.arena())
+    {
+    }
+
+    T* allocate(size_t numItems) { return static_cast<T*>(arena_->allocate(numItems * sizeof(T))); }
+    void deallocate(T* ptr, size_t) { arena_->deallocate(ptr); }
+
+    ScratchArena* arena() const { return arena_; }
+
+private:
+    ScratchArena* arena_;
+};
+
+template <typename T, typename U> bool operator==(const ScratchAllocator<T>& left, const ScratchAllocator<U>& right)
+{
+    return left.arena() == right.arena();
+}
+
+template <typename T, typename U> bool operator!=(const ScratchAllocator<T>& left, const ScratchAllocator<U>& right)
+{
+    return !(left == right);
+}
@@ -25,7 +25,14 @@ using std::string;
 
 string reverseComplement(const string& bases)
 {
-    string bases_rc = bases;
+    string bases_rc;
+    reverseComplement(bases, bases_rc);
+    return bases_rc;
+}
+
+void reverseComplement(const string& bases, string& bases_rc)
+{
+    bases_rc.resize(bases.length());
     string::reverse_iterator bases_rc_iter = bases_rc.rbegin();
 
     char complemented_base = ' ';
@@ -50,6 +57,4 @@ string reverseComplement(const string& bases)
         }
         *bases_rc_iter++ = complemented_base;
     }
-
-    return bases_rc;
 }
@@ -25,3 +25,5 @@
 
 // The standard reverse complement operation; non-core nucletode bases are converted to Ns
 std::string reverseComplement(const std::string& sequence);
+// Same as above but writes into a caller-owned string so that its storage can be reused across calls
+void reverseComplement(const std::string& sequence, std::string& sequenceRc);
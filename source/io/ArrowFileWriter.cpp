@@ -0,0 +1,460 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/ArrowFileWriter.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using std::string;
+using std::vector;
+
+static const char kArrowMagic[] = { 'A', 'R', 'R', 'O', 'W', '1' };
+static const int16_t kMetadataVersion = 4; // Arrow metadata version 5
+static const int16_t kDoublePrecision = 2;
+
+// Values of the Type union of the Arrow schema
+static const uint8_t kIntType = 2;
+static const uint8_t kFloatingPointType = 3;
+static const uint8_t kUtf8Type = 5;
+
+// Values of the MessageHeader union
+static const uint8_t kSchemaHeader = 1;
+static const uint8_t kRecordBatchHeader = 3;
+
+// Builds a FlatBuffer back to front as the reference implementation does: objects are referred to by their distance
+// from the end of the buffer, and nested objects must be created before the tables that refer to them
+class FlatBufferBuilder
+{
+public:
+    template <typename T> void addScalar(int fieldId, T value)
+    {
+        align(sizeof(T));
+        pushScalar(value);
+        recordField(fieldId);
+    }
+
+    void addOffset(int fieldId, uint32_t offset)
+    {
+        align(sizeof(uint32_t));
+        pushScalar<uint32_t>(size() + sizeof(uint32_t) - offset);
+        recordField(fieldId);
+    }
+
+    void startTable()
+    {
+        fieldLocations_.clear();
+        tableStart_ = size();
+    }
+
+    uint32_t endTable()
+    {
+        align(sizeof(int32_t));
+        pushScalar<int32_t>(0);
+        const uint32_t tableOffset = size();
+
+        for (size_t fieldId = fieldLocations_.size(); fieldId != 0; --fieldId)
+        {
+            const uint32_t location = fieldLocations_[fieldId - 1];
+            pushScalar<uint16_t>(location == 0 ? 0 : tableOffset - location);
+        }
+        pushScalar<uint16_t>(tableOffset - tableStart_);
+        pushScalar<uint16_t>((fieldLocations_.size() + 2) * sizeof(uint16_t));
+
+        // The table refers to its vtable by a signed offset pointing backwards in the final buffer
+        patchScalar<int32_t>(tableOffset, size() - tableOffset);
+        return tableOffset;
+    }
+
+    uint32_t createString(const string& value)
+    {
+        preAlign(value.size() + 1, sizeof(uint32_t));
+        bytes_.push_back('\0');
+        bytes_.append(value.rbegin(), value.rend());
+        pushScalar<uint32_t>(value.size());
+        return size();
+    }
+
+    uint32_t createOffsetVector(const vector<uint32_t>& offsets)
+    {
+        preAlign(offsets.size() * sizeof(uint32_t), sizeof(uint32_t));
+        for (auto offset = offsets.rbegin(); offset != offsets.rend(); ++offset)
+        {
+            pushScalar<uint32_t>(size() + sizeof(uint32_t) - *offset);
+        }
+        pushScalar<uint32_t>(offsets.size());
+        return size();
+    }
+
+    // Structs are given as their little-endian encodings laid out one after another
+    uint32_t createStructVector(const string& structs, size_t numStructs, size_t alignment)
+    {
+        preAlign(structs.size(), sizeof(uint32_t));
+        preAlign(structs.size(), alignment);
+        bytes_.append(structs.rbegin(), structs.rend());
+        pushScalar<uint32_t>(numStructs);
+        return size();
+    }
+
+    string finish(uint32_t rootOffset)
+    {
+        preAlign(sizeof(uint32_t), minAlignment_);
+        pushScalar<uint32_t>(size() + sizeof(uint32_t) - rootOffset);
+        return string(bytes_.rbegin(), bytes_.rend());
+    }
+
+private:
+    uint32_t size() const { return bytes_.size(); }
+
+    // Bytes are stored in reverse order, so pushing a value places it in front of the values pushed before it
+    template <typename T> void pushScalar(T value)
+    {
+        char encoding[sizeof(T)];
+        std::memcpy(encoding, &value, sizeof(T));
+        bytes_.append(std::reverse_iterator<char*>(encoding + sizeof(T)), std::reverse_iterator<char*>(encoding));
+    }
+
+    template <typename T> void patchScalar(uint32_t offset, T value)
+    {
+        char encoding[sizeof(T)];
+        std::memcpy(encoding, &value, sizeof(T));
+        for (size_t byteIndex = 0; byteIndex != sizeof(T); ++byteIndex)
+        {
+            bytes_[offset - 1 - byteIndex] = encoding[byteIndex];
+        }
+    }
+
+    void recordField(int fieldId)
+    {
+        if (fieldLocations_.size() <= static_cast<size_t>(fieldId))
+        {
+            fieldLocations_.resize(fieldId + 1, 0);
+        }
+        fieldLocations_[fieldId] = size();
+    }
+
+    void preAlign(size_t numBytes, size_t alignment)
+    {
+        minAlignment_ = std::max(minAlignment_, alignment);
+        while ((size() + numBytes) % alignment != 0)
+        {
+            bytes_.push_back('\0');
+        }
+    }
+
+    void align(size_t alignment) { preAlign(0, alignment); }
+
+    string bytes_;
+    size_t minAlignment_ = 1;
+    uint32_t tableStart_ = 0;
+    vector<uint32_t> fieldLocations_;
+};
+
+template <typename T> static void appendScalar(T value, string& buffer)
+{
+    char encoding[sizeof(T)];
+    std::memcpy(encoding, &value, sizeof(T));
+    buffer.append(encoding, sizeof(T));
+}
+
+static uint32_t addSchema(const vector<ArrowField>& fields, FlatBufferBuilder& builder)
+{
+    vector<uint32_t> fieldOffsets;
+    for (const auto& field : fields)
+    {
+        const uint32_t nameOffset = builder.createString(field.name);
+        const uint32_t childrenOffset = builder.createOffsetVector({});
+
+        builder.startTable();
+        uint8_t typeCode = kUtf8Type;
+        if (field.type == ArrowType::kInt32 || field.type == ArrowType::kInt64)
+        {
+            typeCode = kIntType;
+            builder.addScalar<int32_t>(0, field.type == ArrowType::kInt32 ? 32 : 64);
+            builder.addScalar<uint8_t>(1, 1);
+        }
+        else if (field.type == ArrowType::kFloat64)
+        {
+            typeCode = kFloatingPointType;
+            builder.addScalar<int16_t>(0, kDoublePrecision);
+        }
+        const uint32_t typeOffset = builder.endTable();
+
+        builder.startTable();
+        builder.addOffset(0, nameOffset);
+        builder.addScalar<uint8_t>(1, field.isNullable);
+        builder.addScalar<uint8_t>(2, typeCode);
+        builder.addOffset(3, typeOffset);
+        builder.addOffset(5, childrenOffset);
+        fieldOffsets.push_back(builder.endTable());
+    }
+    const uint32_t fieldsOffset = builder.createOffsetVector(fieldOffsets);
+
+    builder.startTable();
+    builder.addScalar<int16_t>(0, 0);
+    builder.addOffset(1, fieldsOffset);
+    return builder.endTable();
+}
+
+static string encodeMessage(uint8_t headerType, uint32_t headerOffset, int64_t bodyLength, FlatBufferBuilder& builder)
+{
+    builder.startTable();
+    builder.addScalar<int16_t>(0, kMetadataVersion);
+    builder.addScalar<uint8_t>(1, headerType);
+    builder.addOffset(2, headerOffset);
+    builder.addScalar<int64_t>(3, bodyLength);
+    return builder.finish(builder.endTable());
+}
+
+ArrowFileWriter::ArrowFileWriter(const string& path, vector<ArrowField> fields, size_t numRowsPerBatch)
+    : path_(path)
+    , file_(path, std::ios::binary)
+    , fields_(std::move(fields))
+    , numRowsPerBatch_(numRowsPerBatch)
+    , columns_(fields_.size())
+{
+    if (!file_)
+    {
+        throw std::runtime_error("Unable to write to " + path);
+    }
+
+    static const char kPadding[2] = {};
+    file_.write(kArrowMagic, sizeof(kArrowMagic));
+    file_.write(kPadding, sizeof(kPadding));
+
+    FlatBufferBuilder builder;
+    const uint32_t schemaOffset = addSchema(fields_, builder);
+    writeMessage(encodeMessage(kSchemaHeader, schemaOffset, 0, builder), "");
+    resetColumns();
+}
+
+void ArrowFileWriter::resetColumns()
+{
+    for (size_t columnIndex = 0; columnIndex != columns_.size(); ++columnIndex)
+    {
+        Column& column = columns_[columnIndex];
+        column.validity.clear();
+        column.offsets.clear();
+        column.values.clear();
+        column.numNulls = 0;
+        if (fields_[columnIndex].type == ArrowType::kUtf8)
+        {
+            appendScalar<int32_t>(0, column.offsets);
+        }
+    }
+    numRows_ = 0;
+}
+
+ArrowFileWriter::Column& ArrowFileWriter::startValue(ArrowType type, bool isValid)
+{
+    const ArrowField& field = fields_[columnIndex_];
+    if (field.type != type || (!isValid && !field.isNullable))
+    {
+        throw std::logic_error("Unexpected value of column " + field.name + " of " + path_);
+    }
+
+    Column& column = columns_[columnIndex_];
+    if (field.isNullable)
+    {
+        if (numRows_ % 8 == 0)
+        {
+            column.validity.push_back('\0');
+        }
+        if (isValid)
+        {
+            column.validity.back() = static_cast<char>(column.validity.back() | (1 << (numRows_ % 8)));
+        }
+        else
+        {
+            ++column.numNulls;
+        }
+    }
+
+    return column;
+}
+
+void ArrowFileWriter::endValue()
+{
+    if (++columnIndex_ != columns_.size())
+    {
+        return;
+    }
+
+    columnIndex_ = 0;
+    if (static_cast<size_t>(++numRows_) == numRowsPerBatch_)
+    {
+        writeRecordBatch();
+    }
+}
+
+void ArrowFileWriter::appendInt32(int32_t value)
+{
+    appendScalar(value, startValue(ArrowType::kInt32, true).values);
+    endValue();
+}
+
+void ArrowFileWriter::appendInt64(int64_t value)
+{
+    appendScalar(value, startValue(ArrowType::kInt64, true).values);
+    endValue();
+}
+
+void ArrowFileWriter::appendFloat64(double value)
+{
+    appendScalar(value, startValue(ArrowType::kFloat64, true).values);
+    endValue();
+}
+
+void ArrowFileWriter::appendUtf8(const string& value)
+{
+    Column& column = startValue(ArrowType::kUtf8, true);
+    column.values += value;
+    appendScalar<int32_t>(column.values.size(), column.offsets);
+    endValue();
+}
+
+void ArrowFileWriter::appendNull()
+{
+    const ArrowType type = fields_[columnIndex_].type;
+    Column& column = startValue(type, false);
+    if (type == ArrowType::kUtf8)
+    {
+        appendScalar<int32_t>(column.values.size(), column.offsets);
+    }
+    else
+    {
+        column.values.append(type == ArrowType::kInt32 ? sizeof(int32_t) : sizeof(int64_t), '\0');
+    }
+    endValue();
+}
+
+void ArrowFileWriter::writeRecordBatch()
+{
+    string body;
+    string nodes;
+    string buffers;
+    const auto addBuffer = [&body, &buffers](const string& buffer) {
+        appendScalar<int64_t>(body.size(), buffers);
+        appendScalar<int64_t>(buffer.size(), buffers);
+        body += buffer;
+        body.append((8 - body.size() % 8) % 8, '\0');
+    };
+
+    for (size_t columnIndex = 0; columnIndex != columns_.size(); ++columnIndex)
+    {
+        const Column& column = columns_[columnIndex];
+        appendScalar<int64_t>(numRows_, nodes);
+        appendScalar<int64_t>(column.numNulls, nodes);
+
+        // Validity bitmaps may be omitted if a column has no nulls
+        addBuffer(column.numNulls != 0 ? column.validity : string());
+        if (fields_[columnIndex].type == ArrowType::kUtf8)
+        {
+            addBuffer(column.offsets);
+        }
+        addBuffer(column.values);
+    }
+
+    FlatBufferBuilder builder;
+    const uint32_t nodesOffset = builder.createStructVector(nodes, columns_.size(), 8);
+    const uint32_t buffersOffset = builder.createStructVector(buffers, buffers.size() / 16, 8);
+    builder.startTable();
+    builder.addScalar<int64_t>(0, numRows_);
+    builder.addOffset(1, nodesOffset);
+    builder.addOffset(2, buffersOffset);
+    const uint32_t recordBatchOffset = builder.endTable();
+
+    recordBatches_.push_back(
+        writeMessage(encodeMessage(kRecordBatchHeader, recordBatchOffset, body.size(), builder), body));
+    resetColumns();
+}
+
+ArrowFileWriter::Block ArrowFileWriter::writeMessage(const string& metadata, const string& body)
+{
+    const auto paddedLength = static_cast<int32_t>((metadata.size() + 7) / 8 * 8);
+    static const char kPadding[8] = {};
+
+    Block block;
+    block.offset = file_.tellp();
+    block.metadataLength = paddedLength + 8;
+    block.bodyLength = body.size();
+
+    string prefix;
+    appendScalar<uint32_t>(0xffffffff, prefix);
+    appendScalar<int32_t>(paddedLength, prefix);
+    file_.write(prefix.data(), prefix.size());
+    file_.write(metadata.data(), metadata.size());
+    file_.write(kPadding, paddedLength - metadata.size());
+    file_.write(body.data(), body.size());
+    return block;
+}
+
+void ArrowFileWriter::finish()
+{
+    if (columnIndex_ != 0)
+    {
+        throw std::logic_error("Last row of " + path_ + " is incomplete");
+    }
+
+    // A table without rows is written as a single empty record batch
+    if (numRows_ != 0 || recordBatches_.empty())
+    {
+        writeRecordBatch();
+    }
+
+    string endOfStream;
+    appendScalar<uint32_t>(0xffffffff, endOfStream);
+    appendScalar<int32_t>(0, endOfStream);
+    file_.write(endOfStream.data(), endOfStream.size());
+
+    string blocks;
+    for (const auto& block : recordBatches_)
+    {
+        appendScalar<int64_t>(block.offset, blocks);
+        appendScalar<int32_t>(block.metadataLength, blocks);
+        appendScalar<int32_t>(0, blocks);
+        appendScalar<int64_t>(block.bodyLength, blocks);
+    }
+
+    FlatBufferBuilder builder;
+    const uint32_t schemaOffset = addSchema(fields_, builder);
+    const uint32_t dictionariesOffset = builder.createStructVector("", 0, 8);
+    const uint32_t recordBatchesOffset = builder.createStructVector(blocks, recordBatches_.size(), 8);
+    builder.startTable();
+    builder.addScalar<int16_t>(0, kMetadataVersion);
+    builder.addOffset(1, schemaOffset);
+    builder.addOffset(2, dictionariesOffset);
+    builder.addOffset(3, recordBatchesOffset);
+    const string footer = builder.finish(builder.endTable());
+
+    string trailer;
+    appendScalar<int32_t>(footer.size(), trailer);
+    trailer.append(kArrowMagic, sizeof(kArrowMagic));
+    file_.write(footer.data(), footer.size());
+    file_.write(trailer.data(), trailer.size());
+
+    file_.close();
+    if (!file_)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
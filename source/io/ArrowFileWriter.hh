@@ -0,0 +1,102 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Minimal writer of tables in Arrow IPC file format (Feather version 2) that can be memory-mapped by Arrow readers.
+// Only flat columns of 32-bit and 64-bit integers, doubles, and UTF-8 strings are supported. Rows are buffered and
+// written as record batches, so tables of any size are written with bounded memory.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class ArrowType
+{
+    kInt32,
+    kInt64,
+    kFloat64,
+    kUtf8
+};
+
+struct ArrowField
+{
+    ArrowField(std::string name, ArrowType type, bool isNullable = false)
+        : name(std::move(name))
+        , type(type)
+        , isNullable(isNullable)
+    {
+    }
+
+    std::string name;
+    ArrowType type;
+    bool isNullable;
+};
+
+class ArrowFileWriter
+{
+public:
+    ArrowFileWriter(const std::string& path, std::vector<ArrowField> fields, size_t numRowsPerBatch = 1 << 16);
+
+    // Each row is written by appending exactly one value to every column in the order of the fields
+    void appendInt32(int32_t value);
+    void appendInt64(int64_t value);
+    void appendFloat64(double value);
+    void appendUtf8(const std::string& value);
+    void appendNull();
+
+    void finish();
+
+private:
+    // Buffers of the values of a column in the current record batch
+    struct Column
+    {
+        std::string validity;
+        std::string offsets;
+        std::string values;
+        int64_t numNulls = 0;
+    };
+
+    // Location of a record batch in the file
+    struct Block
+    {
+        int64_t offset;
+        int32_t metadataLength;
+        int64_t bodyLength;
+    };
+
+    Column& startValue(ArrowType type, bool isValid);
+    void endValue();
+    void resetColumns();
+    void writeRecordBatch();
+    Block writeMessage(const std::string& metadata, const std::string& body);
+
+    std::string path_;
+    std::ofstream file_;
+    std::vector<ArrowField> fields_;
+    size_t numRowsPerBatch_;
+    std::vector<Column> columns_;
+    size_t columnIndex_ = 0;
+    int64_t numRows_ = 0;
+    std::vector<Block> recordBatches_;
+};
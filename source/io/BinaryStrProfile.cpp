@@ -0,0 +1,301 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/BinaryStrProfile.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "common/BinaryCoding.hh"
+
+using std::pair;
+using std::string;
+using std::to_string;
+using std::vector;
+
+static const char kMagic[] = { 'E', 'H', 'D', 'N', 'S', 'T', 'R', 'B' };
+// Version 2 adds binned anchored IRR counts and version 3 the input fingerprint; profiles are written in the lowest
+// version that holds their content
+static const uint64_t kFormatVersion = 1;
+static const uint64_t kBinnedFormatVersion = 2;
+static const uint64_t kFingerprintedFormatVersion = 3;
+static const size_t kMaxPackedMotifLength = 32;
+
+bool hasBinaryStrProfileMagic(const char* bytes, size_t numBytes)
+{
+    return numBytes >= sizeof(kMagic) && std::memcmp(bytes, kMagic, sizeof(kMagic)) == 0;
+}
+
+static int encodeBase(char base)
+{
+    switch (base)
+    {
+    case 'A':
+        return 0;
+    case 'C':
+        return 1;
+    case 'G':
+        return 2;
+    case 'T':
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+static void writeMotif(const string& motif, BinaryEncoder& encoder)
+{
+    uint64_t packedMotif = 0;
+    bool isPackable = !motif.empty() && motif.length() <= kMaxPackedMotifLength;
+    for (size_t index = 0; isPackable && index != motif.length(); ++index)
+    {
+        const int baseCode = encodeBase(motif[index]);
+        isPackable = baseCode != -1;
+        packedMotif = (packedMotif << 2) | static_cast<uint64_t>(baseCode);
+    }
+
+    encoder.writeVarint((motif.length() << 1) | (isPackable ? 1 : 0));
+    if (isPackable)
+    {
+        encoder.writeVarint(packedMotif);
+    }
+    else
+    {
+        encoder.writeBytes(motif.data(), motif.length());
+    }
+}
+
+static string readMotif(BinaryDecoder& decoder)
+{
+    const uint64_t header = decoder.readVarint();
+    const uint64_t motifLength = header >> 1;
+    const bool isPacked = header & 1;
+
+    if (!isPacked)
+    {
+        string motif(motifLength, 'N');
+        decoder.readBytes(&motif[0], motifLength);
+        return motif;
+    }
+
+    if (motifLength > kMaxPackedMotifLength)
+    {
+        throw std::runtime_error("Invalid length of packed motif " + to_string(motifLength));
+    }
+
+    static const char kBases[] = { 'A', 'C', 'G', 'T' };
+    uint64_t packedMotif = decoder.readVarint();
+    string motif(motifLength, 'N');
+    for (size_t index = motifLength; index != 0; --index)
+    {
+        motif[index - 1] = kBases[packedMotif & 3];
+        packedMotif >>= 2;
+    }
+
+    return motif;
+}
+
+static void
+writeRegions(const vector<RegionWithCount>& regions, const vector<int>& dictionaryIndexes, BinaryEncoder& encoder)
+{
+    encoder.writeVarint(regions.size());
+    uint64_t previousContigCode = 0;
+    int64_t previousStart = 0;
+    for (const auto& region : regions)
+    {
+        const uint64_t contigCode = region.contigId() == -1 ? 0 : dictionaryIndexes[region.contigId()] + 1;
+        if (contigCode != previousContigCode)
+        {
+            previousStart = 0;
+        }
+
+        encoder.writeVarint(contigCode);
+        encoder.writeSignedVarint(region.start() - previousStart);
+        encoder.writeSignedVarint(region.end() - region.start());
+        encoder.writeVarint(region.feature().value());
+
+        previousContigCode = contigCode;
+        previousStart = region.start();
+    }
+}
+
+static void readRegions(BinaryDecoder& decoder, uint64_t numContigs, vector<RegionWithCount>& regions)
+{
+    const uint64_t numRegions = decoder.readVarint();
+    // Counts read from the file are not trusted for allocation; each region takes at least four bytes
+    const size_t kMinEncodedRegionSize = 4;
+    regions.reserve(std::min<uint64_t>(numRegions, decoder.numRemainingBytes() / kMinEncodedRegionSize));
+    uint64_t previousContigCode = 0;
+    int64_t previousStart = 0;
+    for (uint64_t regionIndex = 0; regionIndex != numRegions; ++regionIndex)
+    {
+        const uint64_t contigCode = decoder.readVarint();
+        if (contigCode > numContigs)
+        {
+            throw std::runtime_error("Invalid contig index in binary STR profile");
+        }
+
+        if (contigCode != previousContigCode)
+        {
+            previousStart = 0;
+        }
+
+        const int64_t start = previousStart + decoder.readSignedVarint();
+        const int64_t end = start + decoder.readSignedVarint();
+        const auto count = static_cast<int>(decoder.readVarint());
+        const int contigId = static_cast<int>(contigCode) - 1;
+        regions.emplace_back(contigId, start, end, CountFeature(count));
+
+        previousContigCode = contigCode;
+        previousStart = start;
+    }
+}
+
+string encodeAsBinary(const StrProfile& profile)
+{
+    // Only contigs that contain regions are kept in the dictionary
+    vector<int> dictionaryIndexes(profile.contigInfo.numContigs(), -1);
+    vector<int> referencedContigIds;
+    const auto addContigsToDictionary = [&](const vector<RegionWithCount>& regions) {
+        for (const auto& region : regions)
+        {
+            if (region.contigId() != -1 && dictionaryIndexes[region.contigId()] == -1)
+            {
+                dictionaryIndexes[region.contigId()] = referencedContigIds.size();
+                referencedContigIds.push_back(region.contigId());
+            }
+        }
+    };
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        addContigsToDictionary(motifAndRecord.second.regionsWithIrrAnchors);
+        addContigsToDictionary(motifAndRecord.second.irrAnchorBins);
+    }
+
+    uint64_t version = kFormatVersion;
+    if (!profile.inputFingerprint.empty())
+    {
+        version = kFingerprintedFormatVersion;
+    }
+    else if (profile.binSize != 0)
+    {
+        version = kBinnedFormatVersion;
+    }
+
+    const bool hasBins = version >= kBinnedFormatVersion;
+    BinaryEncoder encoder;
+    encoder.writeBytes(kMagic, sizeof(kMagic));
+    encoder.writeVarint(version);
+
+    encoder.writeVarint(profile.readLength);
+    encoder.writeDouble(profile.depth);
+    if (hasBins)
+    {
+        encoder.writeVarint(profile.binSize);
+    }
+    if (version >= kFingerprintedFormatVersion)
+    {
+        encoder.writeString(profile.inputFingerprint);
+    }
+
+    encoder.writeVarint(referencedContigIds.size());
+    for (int contigId : referencedContigIds)
+    {
+        encoder.writeString(profile.contigInfo.getContigName(contigId));
+        encoder.writeVarint(profile.contigInfo.getContigSize(contigId));
+    }
+
+    encoder.writeVarint(profile.motifRecords.size());
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        const MotifRecord& record = motifAndRecord.second;
+        writeMotif(motifAndRecord.first, encoder);
+        encoder.writeVarint(record.anchoredIrrCount);
+        encoder.writeVarint(record.irrPairCount);
+        writeRegions(record.regionsWithIrrAnchors, dictionaryIndexes, encoder);
+        if (hasBins)
+        {
+            writeRegions(record.irrAnchorBins, dictionaryIndexes, encoder);
+        }
+    }
+
+    return encoder.buffer();
+}
+
+StrProfile decodeFromBinary(const string& bytes)
+{
+    if (!hasBinaryStrProfileMagic(bytes.data(), bytes.size()))
+    {
+        throw std::runtime_error("Data does not start with a binary STR profile header");
+    }
+
+    BinaryDecoder decoder(bytes.data() + sizeof(kMagic), bytes.data() + bytes.size());
+    const uint64_t version = decoder.readVarint();
+    if (version < kFormatVersion || version > kFingerprintedFormatVersion)
+    {
+        throw std::runtime_error("Unsupported version of binary STR profile format " + to_string(version));
+    }
+
+    const auto readLength = static_cast<int>(decoder.readVarint());
+    const double depth = decoder.readDouble();
+    const bool hasBins = version >= kBinnedFormatVersion;
+    const int binSize = hasBins ? static_cast<int>(decoder.readVarint()) : 0;
+    string inputFingerprint = version >= kFingerprintedFormatVersion ? decoder.readString() : string();
+
+    const uint64_t numContigs = decoder.readVarint();
+    vector<pair<string, int64_t>> contigNamesAndSizes;
+    for (uint64_t contigIndex = 0; contigIndex != numContigs; ++contigIndex)
+    {
+        string contigName = decoder.readString();
+        const auto contigSize = static_cast<int64_t>(decoder.readVarint());
+        contigNamesAndSizes.emplace_back(std::move(contigName), contigSize);
+    }
+
+    StrProfile profile(ReferenceContigInfo(std::move(contigNamesAndSizes)));
+    profile.readLength = readLength;
+    profile.depth = depth;
+    profile.binSize = binSize;
+    profile.inputFingerprint = std::move(inputFingerprint);
+
+    const uint64_t numMotifs = decoder.readVarint();
+    for (uint64_t motifIndex = 0; motifIndex != numMotifs; ++motifIndex)
+    {
+        const string motif = readMotif(decoder);
+        MotifRecord& record = profile.motifRecords[motif];
+        record.anchoredIrrCount = static_cast<int>(decoder.readVarint());
+        record.irrPairCount = static_cast<int>(decoder.readVarint());
+        readRegions(decoder, numContigs, record.regionsWithIrrAnchors);
+        if (hasBins)
+        {
+            readRegions(decoder, numContigs, record.irrAnchorBins);
+        }
+    }
+
+    if (!decoder.atEnd())
+    {
+        throw std::runtime_error("Unexpected trailing data in binary STR profile");
+    }
+
+    return profile;
+}
@@ -0,0 +1,45 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compact binary encoding of single-sample STR profiles. The file consists of
+//
+//   - an 8-byte magic string followed by the format version,
+//   - the run statistics (read length and depth), starting with version 2, the size of anchored IRR bins, and,
+//     starting with version 3, the fingerprint of the input file,
+//   - a dictionary of the contigs referenced by the profile (name and size of each contig),
+//   - a record for each motif containing the motif, the anchored IRR and IRR pair counts, the regions with anchored
+//     IRRs, and, starting with version 2, the bins with anchored IRRs.
+//
+// Motifs consisting of core bases are packed into a varint two bits per base. Each region is stored as the index of
+// its contig in the dictionary (0 for unaligned regions), start relative to the previous region on the same contig,
+// length, and count; bins are stored in the same way.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "io/StrProfile.hh"
+
+bool hasBinaryStrProfileMagic(const char* bytes, size_t numBytes);
+
+std::string encodeAsBinary(const StrProfile& profile);
+StrProfile decodeFromBinary(const std::string& bytes);
@@ -0,0 +1,152 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/CompressedFile.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+extern "C"
+{
+#include "htslib/bgzf.h"
+#include "htslib/hts.h"
+}
+
+using std::string;
+
+static const size_t kReadChunkSize = 1 << 20;
+
+DecompressionThreadPool::DecompressionThreadPool(int numThreads)
+    : poolPtr_(hts_tpool_init(numThreads))
+{
+    if (!poolPtr_)
+    {
+        throw std::runtime_error("Failed to start " + std::to_string(numThreads) + " decompression threads");
+    }
+}
+
+DecompressionThreadPool::~DecompressionThreadPool() { hts_tpool_destroy(poolPtr_); }
+
+bool hasGzipMagic(const char* bytes, size_t numBytes)
+{
+    return numBytes >= 2 && static_cast<unsigned char>(bytes[0]) == 0x1f
+        && static_cast<unsigned char>(bytes[1]) == 0x8b;
+}
+
+static bool isCompressedFile(const string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    char magic[2];
+    file.read(magic, sizeof(magic));
+    return hasGzipMagic(magic, file.gcount());
+}
+
+// Reads decompressed contents of the file until the given number of bytes is reached or the file ends
+static string readCompressedFile(const string& path, size_t maxNumBytes, const DecompressionThreadPool* threadPool)
+{
+    BGZF* filePtr = bgzf_open(path.c_str(), "r");
+    if (!filePtr)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    // Plain gzip files consist of a single stream that can only be decompressed sequentially
+    if (threadPool && bgzf_compression(filePtr) == bgzf && bgzf_thread_pool(filePtr, threadPool->pool(), 0) != 0)
+    {
+        bgzf_close(filePtr);
+        throw std::runtime_error("Failed to start decompression of " + path);
+    }
+
+    string contents;
+    ssize_t numBytesRead = 0;
+    do
+    {
+        const size_t numBytesToRead = std::min(kReadChunkSize, maxNumBytes - contents.size());
+        const size_t previousSize = contents.size();
+        contents.resize(previousSize + numBytesToRead);
+        numBytesRead = bgzf_read(filePtr, &contents[previousSize], numBytesToRead);
+        contents.resize(previousSize + std::max<ssize_t>(numBytesRead, 0));
+    } while (numBytesRead > 0 && contents.size() < maxNumBytes);
+
+    bgzf_close(filePtr);
+    if (numBytesRead < 0)
+    {
+        throw std::runtime_error("Failed to decompress " + path);
+    }
+
+    return contents;
+}
+
+string readLeadingBytes(const string& path, size_t numBytes)
+{
+    if (isCompressedFile(path))
+    {
+        return readCompressedFile(path, numBytes, nullptr);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    string bytes(numBytes, '\0');
+    file.read(&bytes[0], numBytes);
+    bytes.resize(file.gcount());
+    return bytes;
+}
+
+string readFileContents(const string& path, const DecompressionThreadPool* threadPool)
+{
+    if (isCompressedFile(path))
+    {
+        return readCompressedFile(path, string::npos, threadPool);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void writeBgzfFile(const string& path, const string& contents, int numThreads)
+{
+    BGZF* filePtr = bgzf_open(path.c_str(), "w");
+    if (!filePtr)
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+
+    if (numThreads > 1 && bgzf_mt(filePtr, numThreads, 256) != 0)
+    {
+        bgzf_close(filePtr);
+        throw std::runtime_error("Failed to start compression threads for " + path);
+    }
+
+    const auto numBytesWritten = bgzf_write(filePtr, contents.data(), contents.size());
+    const bool isWritten = numBytesWritten == static_cast<ssize_t>(contents.size());
+    if (bgzf_close(filePtr) != 0 || !isWritten)
+    {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
@@ -0,0 +1,61 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reading and writing of files that may be compressed with gzip. Compressed files are recognized by their magic bytes
+// and written in BGZF, the blocked gzip format of htslib, which can be compressed and decompressed on many threads
+// and is read by any gzip decompressor.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+extern "C"
+{
+#include "htslib/thread_pool.h"
+}
+
+// Threads shared by readers of BGZF-compressed files
+class DecompressionThreadPool
+{
+public:
+    explicit DecompressionThreadPool(int numThreads);
+    ~DecompressionThreadPool();
+
+    DecompressionThreadPool(const DecompressionThreadPool&) = delete;
+    DecompressionThreadPool& operator=(const DecompressionThreadPool&) = delete;
+
+    hts_tpool* pool() const { return poolPtr_; }
+
+private:
+    hts_tpool* poolPtr_;
+};
+
+bool hasGzipMagic(const char* bytes, size_t numBytes);
+
+// Reads up to the given number of leading bytes of the file, decompressing them if the file is compressed
+std::string readLeadingBytes(const std::string& path, size_t numBytes);
+
+// Reads the entire file, decompressing it if it is compressed; BGZF blocks are decompressed on the threads of the pool
+// if one is given
+std::string readFileContents(const std::string& path, const DecompressionThreadPool* threadPool = nullptr);
+
+void writeBgzfFile(const std::string& path, const std::string& contents, int numThreads = 1);
@@ -0,0 +1,518 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/EvidenceBamWriter.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+#include "thirdparty/spdlog/spdlog.h"
+
+#include "io/HtsHelpers.hh"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+static const uint16_t kMateFlags = BAM_FREAD1 | BAM_FREAD2;
+
+EvidenceBamWriter::EvidenceBamWriter(
+    string pathToReads, string pathToReference, const bam_hdr_t* header, string pathToEvidenceBam, int numThreads,
+    size_t memoryBudget)
+    : pathToReads_(std::move(pathToReads))
+    , pathToReference_(std::move(pathToReference))
+    , header_(bam_hdr_dup(header))
+    , pathToEvidenceBam_(std::move(pathToEvidenceBam))
+    , pathToSpilledIrrs_(pathToEvidenceBam_ + ".irrs.tmp")
+    , numThreads_(numThreads)
+    , memoryBudget_(memoryBudget)
+{
+    if (!header_)
+    {
+        throw std::runtime_error("Failed to copy header of " + pathToReads_);
+    }
+}
+
+EvidenceBamWriter::~EvidenceBamWriter()
+{
+    for (auto& nameAndRecord : pendingIrrs_)
+    {
+        bam_destroy1(nameAndRecord.second);
+    }
+
+    for (bam1_t* record : records_)
+    {
+        bam_destroy1(record);
+    }
+
+    removeTemporaryFiles();
+    bam_hdr_destroy(header_);
+}
+
+static bam1_t* copyRecord(const bam1_t* alignment)
+{
+    bam1_t* record = bam_dup1(alignment);
+    if (!record)
+    {
+        throw std::runtime_error("Failed to copy alignment record");
+    }
+
+    return record;
+}
+
+static size_t sizeOfRecord(const bam1_t* record) { return sizeof(bam1_t) + record->m_data; }
+
+// Unplaced reads go last as required for indexing
+static bool isBefore(const bam1_t* record, const bam1_t* other)
+{
+    const auto contigIndex = static_cast<uint32_t>(record->core.tid);
+    const auto otherContigIndex = static_cast<uint32_t>(other->core.tid);
+    return contigIndex != otherContigIndex ? contigIndex < otherContigIndex : record->core.pos < other->core.pos;
+}
+
+static htsFile* openBam(const string& path, const char* mode, const bam_hdr_t* header)
+{
+    htsFile* filePtr = sam_open(path.c_str(), mode);
+    if (!filePtr)
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+
+    if (sam_hdr_write(filePtr, header) != 0)
+    {
+        hts_close(filePtr);
+        throw std::runtime_error("Failed to write " + path);
+    }
+
+    return filePtr;
+}
+
+// Closes a file written by openBam(); isWritten tells whether all records were written
+static void closeBam(htsFile* filePtr, const string& path, bool isWritten)
+{
+    if (hts_close(filePtr) != 0 || !isWritten)
+    {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+void EvidenceBamWriter::add(const bam1_t* alignment, ReadType readType, boost::optional<ReadType> mateType)
+{
+    if (readType == ReadType::kIrrRead && !mateType)
+    {
+        bam1_t* record = copyRecord(alignment);
+        if (!pendingIrrs_.emplace(bam_get_qname(record), record).second)
+        {
+            bam_destroy1(record);
+            return;
+        }
+
+        pendingIrrBytes_ += sizeOfRecord(record);
+        if (pendingIrrBytes_ >= memoryBudget_)
+        {
+            spillPendingIrrs();
+        }
+        return;
+    }
+
+    if (!mateType)
+    {
+        return;
+    }
+
+    bool isInformative = false;
+    if (readType == ReadType::kIrrRead)
+    {
+        isInformative = *mateType != ReadType::kOtherRead;
+    }
+    else if (readType == ReadType::kAnchorRead)
+    {
+        isInformative = *mateType == ReadType::kIrrRead;
+    }
+    if (*mateType == ReadType::kIrrRead)
+    {
+        auto pendingIrr = pendingIrrs_.find(bam_get_qname(alignment));
+        auto spilledIrr = spilledIrrs_.find(bam_get_qname(alignment));
+        if (pendingIrr != pendingIrrs_.end())
+        {
+            pendingIrrBytes_ -= sizeOfRecord(pendingIrr->second);
+            if (isInformative)
+            {
+                addRecord(pendingIrr->second);
+            }
+            else
+            {
+                bam_destroy1(pendingIrr->second);
+            }
+            pendingIrrs_.erase(pendingIrr);
+        }
+        else if (spilledIrr != spilledIrrs_.end())
+        {
+            if (isInformative)
+            {
+                spilledIrr->second = true;
+            }
+            else
+            {
+                spilledIrrs_.erase(spilledIrr);
+            }
+        }
+    }
+
+    if (!isInformative)
+    {
+        return;
+    }
+
+    addRecord(copyRecord(alignment));
+    if (*mateType == ReadType::kAnchorRead)
+    {
+        AnchorRequest request;
+        request.fragName = bam_get_qname(alignment);
+        request.contigId = alignment->core.mtid;
+        request.position = alignment->core.mpos;
+        request.irrMateFlags = alignment->core.flag & kMateFlags;
+        anchorRequests_.push_back(std::move(request));
+    }
+}
+
+void EvidenceBamWriter::addRecord(bam1_t* record)
+{
+    records_.push_back(record);
+    recordBytes_ += sizeOfRecord(record);
+    ++numRecords_;
+
+    if (recordBytes_ >= memoryBudget_)
+    {
+        spillRecords();
+    }
+}
+
+void EvidenceBamWriter::spillRecords()
+{
+    const string chunkPath = pathToEvidenceBam_ + ".chunk" + to_string(chunkPaths_.size()) + ".tmp";
+    spdlog::info("Writing {} bytes of alignments to {}", recordBytes_, chunkPath);
+
+    std::sort(records_.begin(), records_.end(), isBefore);
+    chunkPaths_.push_back(chunkPath);
+    htsFile* chunkFilePtr = openBam(chunkPath, "wb1", header_);
+    bool isWritten = true;
+    for (bam1_t* record : records_)
+    {
+        isWritten = isWritten && sam_write1(chunkFilePtr, header_, record) >= 0;
+        bam_destroy1(record);
+    }
+    records_.clear();
+    recordBytes_ = 0;
+    closeBam(chunkFilePtr, chunkPath, isWritten);
+}
+
+void EvidenceBamWriter::spillPendingIrrs()
+{
+    spdlog::info("Writing {} bytes of in-repeat reads to {}", pendingIrrBytes_, pathToSpilledIrrs_);
+
+    if (!spilledIrrFilePtr_)
+    {
+        spilledIrrFilePtr_ = openBam(pathToSpilledIrrs_, "wb1", header_);
+    }
+
+    bool isWritten = true;
+    for (auto& nameAndRecord : pendingIrrs_)
+    {
+        isWritten = isWritten && sam_write1(spilledIrrFilePtr_, header_, nameAndRecord.second) >= 0;
+        bam_destroy1(nameAndRecord.second);
+        spilledIrrs_.emplace(nameAndRecord.first, false);
+    }
+    pendingIrrs_.clear();
+    pendingIrrBytes_ = 0;
+
+    if (!isWritten)
+    {
+        throw std::runtime_error("Failed to write " + pathToSpilledIrrs_);
+    }
+}
+
+void EvidenceBamWriter::readBackSpilledIrrs()
+{
+    if (!spilledIrrFilePtr_)
+    {
+        return;
+    }
+
+    htsFile* filePtr = spilledIrrFilePtr_;
+    spilledIrrFilePtr_ = nullptr;
+    closeBam(filePtr, pathToSpilledIrrs_, true);
+
+    filePtr = sam_open(pathToSpilledIrrs_.c_str(), "r");
+    bam_hdr_t* headerPtr = filePtr ? sam_hdr_read(filePtr) : nullptr;
+    if (!headerPtr)
+    {
+        if (filePtr)
+        {
+            hts_close(filePtr);
+        }
+        throw std::runtime_error("Failed to read " + pathToSpilledIrrs_);
+    }
+
+    bam1_t* alignment = bam_init1();
+    int readStatus;
+    while ((readStatus = sam_read1(filePtr, headerPtr, alignment)) >= 0)
+    {
+        const auto spilledIrr = spilledIrrs_.find(bam_get_qname(alignment));
+        if (spilledIrr != spilledIrrs_.end() && spilledIrr->second)
+        {
+            addRecord(copyRecord(alignment));
+        }
+    }
+
+    bam_destroy1(alignment);
+    bam_hdr_destroy(headerPtr);
+    hts_close(filePtr);
+    std::remove(pathToSpilledIrrs_.c_str());
+    spilledIrrs_.clear();
+
+    if (readStatus < -1)
+    {
+        throw std::runtime_error("Failed to read " + pathToSpilledIrrs_);
+    }
+}
+
+void EvidenceBamWriter::fetchRequestedAnchors()
+{
+    if (anchorRequests_.empty())
+    {
+        return;
+    }
+
+    htsFile* filePtr = sam_open(pathToReads_.c_str(), "r");
+    if (!filePtr)
+    {
+        throw std::runtime_error("Failed to read BAM file " + pathToReads_);
+    }
+    const string referenceIndex = pathToReference_ + ".fai";
+    hts_set_fai_filename(filePtr, referenceIndex.c_str());
+
+    hts_idx_t* indexPtr = sam_index_load(filePtr, pathToReads_.c_str());
+    if (!indexPtr)
+    {
+        spdlog::warn(
+            "{} is not indexed; {} anchors of IRRs are missing from {}", pathToReads_, anchorRequests_.size(),
+            pathToEvidenceBam_);
+        hts_close(filePtr);
+        return;
+    }
+
+    int numMissingAnchors = 0;
+    bam1_t* alignment = bam_init1();
+    for (const auto& request : anchorRequests_)
+    {
+        bool foundAnchor = false;
+        hts_itr_t* iteratorPtr = nullptr;
+        if (request.contigId >= 0)
+        {
+            iteratorPtr = sam_itr_queryi(indexPtr, request.contigId, request.position, request.position + 1);
+        }
+        while (iteratorPtr && !foundAnchor && sam_itr_next(filePtr, iteratorPtr, alignment) >= 0)
+        {
+            foundAnchor = alignment->core.pos == request.position && isPrimaryAlignment(alignment)
+                && (alignment->core.flag & kMateFlags) != request.irrMateFlags
+                && request.fragName == bam_get_qname(alignment);
+        }
+        if (iteratorPtr)
+        {
+            hts_itr_destroy(iteratorPtr);
+        }
+
+        if (foundAnchor)
+        {
+            addRecord(copyRecord(alignment));
+        }
+        else
+        {
+            ++numMissingAnchors;
+        }
+    }
+
+    bam_destroy1(alignment);
+    hts_idx_destroy(indexPtr);
+    hts_close(filePtr);
+
+    if (numMissingAnchors != 0)
+    {
+        spdlog::warn("Failed to fetch {} anchors of IRRs from {}", numMissingAnchors, pathToReads_);
+    }
+}
+
+// Sequentially reads a chunk written by EvidenceBamWriter::spillRecords()
+class ChunkReader
+{
+public:
+    explicit ChunkReader(const string& path)
+        : path_(path)
+        , filePtr_(sam_open(path.c_str(), "r"))
+        , headerPtr_(filePtr_ ? sam_hdr_read(filePtr_) : nullptr)
+        , record_(bam_init1())
+    {
+        if (!headerPtr_)
+        {
+            throw std::runtime_error("Failed to read " + path_);
+        }
+        advance();
+    }
+
+    ~ChunkReader()
+    {
+        bam_destroy1(record_);
+        if (headerPtr_)
+        {
+            bam_hdr_destroy(headerPtr_);
+        }
+        if (filePtr_)
+        {
+            hts_close(filePtr_);
+        }
+    }
+
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    bool atEnd() const { return atEnd_; }
+    const bam1_t* record() const { return record_; }
+
+    void advance()
+    {
+        const int readStatus = sam_read1(filePtr_, headerPtr_, record_);
+        if (readStatus < -1)
+        {
+            throw std::runtime_error("Failed to read " + path_);
+        }
+        atEnd_ = readStatus == -1;
+    }
+
+private:
+    string path_;
+    htsFile* filePtr_;
+    bam_hdr_t* headerPtr_;
+    bam1_t* record_;
+    bool atEnd_ = false;
+};
+
+void EvidenceBamWriter::mergeChunks()
+{
+    vector<std::unique_ptr<ChunkReader>> readers;
+    for (const auto& chunkPath : chunkPaths_)
+    {
+        readers.emplace_back(new ChunkReader(chunkPath));
+    }
+
+    auto isAfter = [&readers](size_t left, size_t right) {
+        return isBefore(readers[right]->record(), readers[left]->record());
+    };
+    std::priority_queue<size_t, vector<size_t>, decltype(isAfter)> queue(isAfter);
+    for (size_t readerIndex = 0; readerIndex != readers.size(); ++readerIndex)
+    {
+        if (!readers[readerIndex]->atEnd())
+        {
+            queue.push(readerIndex);
+        }
+    }
+
+    htsFile* filePtr = openEvidenceBam();
+    bool isWritten = true;
+    while (isWritten && !queue.empty())
+    {
+        const size_t readerIndex = queue.top();
+        queue.pop();
+        ChunkReader& reader = *readers[readerIndex];
+        isWritten = sam_write1(filePtr, header_, reader.record()) >= 0;
+
+        reader.advance();
+        if (!reader.atEnd())
+        {
+            queue.push(readerIndex);
+        }
+    }
+
+    closeBam(filePtr, pathToEvidenceBam_, isWritten);
+}
+
+htsFile* EvidenceBamWriter::openEvidenceBam()
+{
+    htsFile* filePtr = openBam(pathToEvidenceBam_, "wb", header_);
+    if (numThreads_ > 1 && hts_set_threads(filePtr, numThreads_) != 0)
+    {
+        spdlog::warn("Failed to start {} compression threads for {}", numThreads_, pathToEvidenceBam_);
+    }
+
+    return filePtr;
+}
+
+void EvidenceBamWriter::finish()
+{
+    fetchRequestedAnchors();
+    readBackSpilledIrrs();
+
+    // Bamlets that fit into the memory budget are written without temporary chunks
+    if (chunkPaths_.empty())
+    {
+        std::sort(records_.begin(), records_.end(), isBefore);
+        htsFile* filePtr = openEvidenceBam();
+        bool isWritten = true;
+        for (size_t recordIndex = 0; isWritten && recordIndex != records_.size(); ++recordIndex)
+        {
+            isWritten = sam_write1(filePtr, header_, records_[recordIndex]) >= 0;
+        }
+        closeBam(filePtr, pathToEvidenceBam_, isWritten);
+    }
+    else
+    {
+        if (!records_.empty())
+        {
+            spillRecords();
+        }
+        mergeChunks();
+        removeTemporaryFiles();
+    }
+
+    if (sam_index_build3(pathToEvidenceBam_.c_str(), nullptr, 0, numThreads_) != 0)
+    {
+        throw std::runtime_error("Failed to index " + pathToEvidenceBam_);
+    }
+}
+
+void EvidenceBamWriter::removeTemporaryFiles()
+{
+    if (spilledIrrFilePtr_)
+    {
+        hts_close(spilledIrrFilePtr_);
+        spilledIrrFilePtr_ = nullptr;
+        std::remove(pathToSpilledIrrs_.c_str());
+    }
+
+    for (const auto& chunkPath : chunkPaths_)
+    {
+        std::remove(chunkPath.c_str());
+    }
+    chunkPaths_.clear();
+}
@@ -0,0 +1,108 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Writer of a bamlet with the alignments of informative fragments: IRR pairs and anchored IRRs. In-repeat reads are
+// held until their mates are seen; anchors that were streamed before their in-repeat mates are fetched from the
+// indexed input once all reads are processed. The records are written coordinate-sorted with multithreaded BGZF
+// compression and the bamlet is indexed.
+//
+// Memory is bounded by a budget: once the buffered records exceed it, they are sorted and spilled to a temporary
+// chunk, and the chunks are combined by a multi-way merge at the end. In-repeat reads waiting for their mates are
+// spilled to a temporary file as well and only their names are kept, like the pending reads of the pair collector;
+// the records of those whose mates turn out to be informative are read back at the end.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+extern "C"
+{
+#include "htslib/hts.h"
+#include "htslib/sam.h"
+}
+
+#include "profile/PairCollector.hh"
+
+const size_t kDefaultEvidenceBamMemoryBudget = 64 * 1024 * 1024;
+
+class EvidenceBamWriter
+{
+public:
+    EvidenceBamWriter(
+        std::string pathToReads, std::string pathToReference, const bam_hdr_t* header, std::string pathToEvidenceBam,
+        int numThreads, size_t memoryBudget = kDefaultEvidenceBamMemoryBudget);
+    ~EvidenceBamWriter();
+
+    EvidenceBamWriter(const EvidenceBamWriter&) = delete;
+    EvidenceBamWriter& operator=(const EvidenceBamWriter&) = delete;
+
+    // Takes a primary alignment together with its type and the type of its previously added mate, if any, as
+    // determined by the pair collector
+    void add(const bam1_t* alignment, ReadType readType, boost::optional<ReadType> mateType);
+
+    // Fetches the outstanding anchors and writes and indexes the bamlet
+    void finish();
+
+    int64_t numRecords() const { return numRecords_; }
+
+private:
+    struct AnchorRequest
+    {
+        std::string fragName;
+        int contigId;
+        int position;
+        uint16_t irrMateFlags;
+    };
+
+    void addRecord(bam1_t* record);
+    void spillRecords();
+    void spillPendingIrrs();
+    void readBackSpilledIrrs();
+    void fetchRequestedAnchors();
+    void mergeChunks();
+    htsFile* openEvidenceBam();
+    void removeTemporaryFiles();
+
+    std::string pathToReads_;
+    std::string pathToReference_;
+    bam_hdr_t* header_ = nullptr;
+    std::string pathToEvidenceBam_;
+    std::string pathToSpilledIrrs_;
+    int numThreads_;
+    size_t memoryBudget_;
+
+    std::unordered_map<std::string, bam1_t*> pendingIrrs_;
+    size_t pendingIrrBytes_ = 0;
+    // Names of the spilled in-repeat reads mapped to whether their mates were informative
+    std::unordered_map<std::string, bool> spilledIrrs_;
+    htsFile* spilledIrrFilePtr_ = nullptr;
+    std::vector<AnchorRequest> anchorRequests_;
+
+    std::vector<bam1_t*> records_;
+    size_t recordBytes_ = 0;
+    int64_t numRecords_ = 0;
+    std::vector<std::string> chunkPaths_;
+};
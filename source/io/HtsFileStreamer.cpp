@@ -25,6 +25,11 @@
 
 //#include "boost/filesystem.hpp"
 
+extern "C"
+{
+#include "htslib/bgzf.h"
+}
+
 #include "io/HtsHelpers.hh"
 
 using std::string;
@@ -66,6 +71,35 @@ void HtsFileStreamer::loadHeader()
 
 void HtsFileStreamer::prepareForStreamingAlignments() { htsAlignmentPtr_ = bam_init1(); }
 
+string HtsFileStreamer::headerText() const { return string(htsHeaderPtr_->text, htsHeaderPtr_->l_text); }
+
+std::vector<int64_t> HtsFileStreamer::loadIndexedReadCounts() const
+{
+    if (htsFilePtr_->format.format == cram)
+    {
+        return {};
+    }
+
+    hts_idx_t* indexPtr = sam_index_load(htsFilePtr_, htsFilePath_.c_str());
+    if (!indexPtr)
+    {
+        return {};
+    }
+
+    // Contigs without reads have no statistics and are left with zero counts
+    std::vector<int64_t> readCounts;
+    for (int contigId = 0; contigId != contigInfo_.numContigs(); ++contigId)
+    {
+        uint64_t numMappedReads = 0;
+        uint64_t numUnmappedReads = 0;
+        hts_idx_get_stat(indexPtr, contigId, &numMappedReads, &numUnmappedReads);
+        readCounts.push_back(static_cast<int64_t>(numMappedReads + numUnmappedReads));
+    }
+
+    hts_idx_destroy(indexPtr);
+    return readCounts;
+}
+
 bool HtsFileStreamer::trySeekingToNextPrimaryAlignment()
 {
     if (status_ != Status::kStreamingReads)
@@ -77,6 +111,7 @@ bool HtsFileStreamer::trySeekingToNextPrimaryAlignment()
 
     while ((returnCode = sam_read1(htsFilePtr_, htsHeaderPtr_, htsAlignmentPtr_)) >= 0)
     {
+        ++numRecordsRead_;
         if (isPrimaryAlignment(htsAlignmentPtr_))
             return true;
     }
@@ -91,6 +126,41 @@ bool HtsFileStreamer::trySeekingToNextPrimaryAlignment()
     return false;
 }
 
+HtsStreamPosition HtsFileStreamer::position() const
+{
+    HtsStreamPosition position;
+    if (htsFilePtr_->format.format == bam)
+    {
+        position.virtualOffset = bgzf_tell(htsFilePtr_->fp.bgzf);
+    }
+    position.numRecordsRead = numRecordsRead_;
+    return position;
+}
+
+void HtsFileStreamer::restorePosition(const HtsStreamPosition& position)
+{
+    if (htsFilePtr_->format.format == bam && position.virtualOffset != -1)
+    {
+        if (bgzf_seek(htsFilePtr_->fp.bgzf, position.virtualOffset, SEEK_SET) != 0)
+        {
+            throw std::runtime_error("Failed to seek to offset " + std::to_string(position.virtualOffset) + " of "
+                                     + htsFilePath_);
+        }
+        numRecordsRead_ = position.numRecordsRead;
+        return;
+    }
+
+    while (numRecordsRead_ != position.numRecordsRead)
+    {
+        if (sam_read1(htsFilePtr_, htsHeaderPtr_, htsAlignmentPtr_) < 0)
+        {
+            throw std::runtime_error("Failed to skip to record " + std::to_string(position.numRecordsRead) + " of "
+                                     + htsFilePath_);
+        }
+        ++numRecordsRead_;
+    }
+}
+
 int HtsFileStreamer::currentReadContigId() const { return htsAlignmentPtr_->core.tid; }
 int HtsFileStreamer::currentReadPosition() const { return htsAlignmentPtr_->core.pos; }
 int HtsFileStreamer::currentMateContigId() const { return htsAlignmentPtr_->core.mtid; }
@@ -104,6 +174,8 @@ bool HtsFileStreamer::isStreamingAlignedReads() const
 
 Read HtsFileStreamer::decodeRead() const { return decodeHtsRead(htsAlignmentPtr_); }
 
+void HtsFileStreamer::decodeRead(Read& read) const { decodeHtsRead(htsAlignmentPtr_, read); }
+
 HtsFileStreamer::~HtsFileStreamer()
 {
     bam_destroy1(htsAlignmentPtr_);
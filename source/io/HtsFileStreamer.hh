@@ -34,6 +34,14 @@ extern "C"
 #include "reads/Read.hh"
 #include "region/ReferenceContigInfo.hh"
 
+// Position in the stream of records; BAM files are positioned by the BGZF virtual offset of the next record while
+// other files are positioned by skipping the records that were read before
+struct HtsStreamPosition
+{
+    int64_t virtualOffset = -1;
+    int64_t numRecordsRead = 0;
+};
+
 class HtsFileStreamer
 {
 public:
@@ -49,9 +57,20 @@ public:
     ~HtsFileStreamer();
 
     const ReferenceContigInfo& contigInfo() const { return contigInfo_; }
+    std::string headerText() const;
+    const bam_hdr_t* header() const { return htsHeaderPtr_; }
+
+    // Numbers of alignments placed on each contig according to the index of the file, counting secondary and
+    // supplementary alignments too; empty if the file is not indexed or the index does not record read counts, as is
+    // the case for CRAM indexes
+    std::vector<int64_t> loadIndexedReadCounts() const;
 
     bool trySeekingToNextPrimaryAlignment();
 
+    HtsStreamPosition position() const;
+    // Continues streaming from a position of a streamer of the same file
+    void restorePosition(const HtsStreamPosition& position);
+
     int currentReadContigId() const;
     int currentReadPosition() const;
     int currentReadLength() const;
@@ -61,6 +80,8 @@ public:
     bool isStreamingAlignedReads() const;
 
     Read decodeRead() const;
+    void decodeRead(Read& read) const;
+    const bam1_t* currentAlignment() const { return htsAlignmentPtr_; }
 
 private:
     enum class Status
@@ -77,6 +98,7 @@ private:
     std::string referencePath_;
     ReferenceContigInfo contigInfo_;
     Status status_ = Status::kStreamingReads;
+    int64_t numRecordsRead_ = 0;
 
     htsFile* htsFilePtr_ = nullptr;
     bam1_t* htsAlignmentPtr_ = nullptr;
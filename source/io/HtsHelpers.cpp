@@ -27,9 +27,8 @@ using std::pair;
 using std::string;
 using std::vector;
 
-string decodeQuals(bam1_t* htsAlignPtr)
+static void decodeQuals(bam1_t* htsAlignPtr, string& quals)
 {
-    string quals;
     uint8_t* htsQualsPtr = bam_get_qual(htsAlignPtr);
     const int readLength = htsAlignPtr->core.l_qseq;
     quals.resize(readLength);
@@ -38,13 +37,10 @@ string decodeQuals(bam1_t* htsAlignPtr)
     {
         quals[index] = static_cast<char>(33 + htsQualsPtr[index]);
     }
-
-    return quals;
 }
 
-string decodeBases(bam1_t* htsAlignPtr)
+static void decodeBases(bam1_t* htsAlignPtr, string& bases)
 {
-    string bases;
     uint8_t* htsSeqPtr = bam_get_seq(htsAlignPtr);
     const int32_t readLength = htsAlignPtr->core.l_qseq;
     bases.resize(readLength);
@@ -53,25 +49,26 @@ string decodeBases(bam1_t* htsAlignPtr)
     {
         bases[index] = seq_nt16_str[bam_seqi(htsSeqPtr, index)];
     }
-
-    return bases;
 }
 
 Read decodeHtsRead(bam1_t* htsAlignPtr)
 {
     Read read;
+    decodeHtsRead(htsAlignPtr, read);
+    return read;
+}
 
-    read.bases = decodeBases(htsAlignPtr);
+void decodeHtsRead(bam1_t* htsAlignPtr, Read& read)
+{
+    decodeBases(htsAlignPtr, read.bases);
     read.flag = htsAlignPtr->core.flag;
     read.mapq = htsAlignPtr->core.qual;
-    read.name = bam_get_qname(htsAlignPtr);
+    read.name.assign(bam_get_qname(htsAlignPtr));
     read.pos = htsAlignPtr->core.pos;
-    read.quals = decodeQuals(htsAlignPtr);
+    decodeQuals(htsAlignPtr, read.quals);
     read.contigId = htsAlignPtr->core.tid;
     read.mateContigId = htsAlignPtr->core.mtid;
     read.matePos = htsAlignPtr->core.mpos;
-
-    return read;
 }
 
 bool isPrimaryAlignment(bam1_t* htsAlignPtr)
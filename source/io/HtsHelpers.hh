@@ -32,4 +32,6 @@ extern "C"
 
 bool isPrimaryAlignment(bam1_t* htsAlignPtr);
 Read decodeHtsRead(bam1_t* htsAlignPtr);
+// Decodes the alignment into an existing read reusing the storage of its fields
+void decodeHtsRead(bam1_t* htsAlignPtr, Read& read);
 ReferenceContigInfo decodeContigInfo(bam_hdr_t* htsHeaderPtr);
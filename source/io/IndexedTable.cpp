@@ -0,0 +1,84 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/IndexedTable.hh"
+
+#include <stdexcept>
+
+extern "C"
+{
+#include "htslib/tbx.h"
+}
+
+using std::string;
+
+IndexedTableWriter::IndexedTableWriter(string path, int numThreads)
+    : path_(std::move(path))
+{
+    filePtr_ = bgzf_open(path_.c_str(), "w");
+    if (!filePtr_)
+    {
+        throw std::runtime_error("Failed to open " + path_ + " for writing");
+    }
+
+    if (numThreads > 1 && bgzf_mt(filePtr_, numThreads, 256) != 0)
+    {
+        throw std::runtime_error("Failed to start compression threads for " + path_);
+    }
+}
+
+IndexedTableWriter::~IndexedTableWriter()
+{
+    if (filePtr_)
+    {
+        bgzf_close(filePtr_);
+    }
+}
+
+void IndexedTableWriter::write(const char* data, size_t numBytes)
+{
+    if (bgzf_write(filePtr_, data, numBytes) != static_cast<ssize_t>(numBytes))
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+void IndexedTableWriter::close()
+{
+    const int returnCode = bgzf_close(filePtr_);
+    filePtr_ = nullptr;
+    if (returnCode != 0)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+
+    indexTable(path_);
+}
+
+void indexTable(const string& path)
+{
+    tbx_conf_t config = tbx_conf_bed;
+    config.line_skip = 1;
+    if (tbx_index_build(path.c_str(), 0, &config) != 0)
+    {
+        throw std::runtime_error("Failed to index " + path);
+    }
+}
@@ -0,0 +1,55 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tab-separated tables compressed with BGZF and indexed with tabix. The first three columns of each row hold the
+// contig and the 0-based start and exclusive end of a region, the rows are sorted by contig and start, and the table
+// starts with a single header line.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+extern "C"
+{
+#include "htslib/bgzf.h"
+}
+
+class IndexedTableWriter
+{
+public:
+    IndexedTableWriter(std::string path, int numThreads = 1);
+    ~IndexedTableWriter();
+
+    IndexedTableWriter(const IndexedTableWriter&) = delete;
+    IndexedTableWriter& operator=(const IndexedTableWriter&) = delete;
+
+    void write(const char* data, size_t numBytes);
+    // Closes the table and writes its index to <path>.tbi
+    void close();
+
+private:
+    std::string path_;
+    BGZF* filePtr_ = nullptr;
+};
+
+// Writes the index of an existing table
+void indexTable(const std::string& path);
@@ -0,0 +1,424 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/ProfileBundle.hh"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "common/BinaryCoding.hh"
+
+using std::map;
+using std::string;
+using std::vector;
+
+static const char kMagic[] = { 'E', 'H', 'D', 'N', 'B', 'N', 'D', 'L' };
+static const char kTrailerMagic[] = { 'E', 'H', 'D', 'N', 'B', 'I', 'D', 'X' };
+static const uint64_t kFormatVersion = 1;
+static const uint64_t kHeaderSize = 16;
+static const uint64_t kTrailerSize = 32;
+// Bounds the size of record headers read while scanning the records
+static const size_t kMaxSampleIdLength = 1024;
+static const size_t kMaxRecordHeaderSize = kMaxSampleIdLength + 32;
+
+// Closes the file descriptor when going out of scope unless it was released
+class ScopedFileDescriptor
+{
+public:
+    explicit ScopedFileDescriptor(int fileDescriptor)
+        : fileDescriptor_(fileDescriptor)
+    {
+    }
+
+    ~ScopedFileDescriptor()
+    {
+        if (fileDescriptor_ != -1)
+        {
+            close(fileDescriptor_);
+        }
+    }
+
+    ScopedFileDescriptor(const ScopedFileDescriptor&) = delete;
+    ScopedFileDescriptor& operator=(const ScopedFileDescriptor&) = delete;
+
+    int get() const { return fileDescriptor_; }
+    int release()
+    {
+        const int fileDescriptor = fileDescriptor_;
+        fileDescriptor_ = -1;
+        return fileDescriptor;
+    }
+
+private:
+    int fileDescriptor_;
+};
+
+struct BundleIndex
+{
+    map<string, ProfileBundleEntry> entries;
+    // End of the last record; the index starts here
+    uint64_t recordsEnd = kHeaderSize;
+};
+
+bool hasProfileBundleMagic(const char* bytes, size_t numBytes)
+{
+    return numBytes >= sizeof(kMagic) && std::memcmp(bytes, kMagic, sizeof(kMagic)) == 0;
+}
+
+static uint32_t computeChecksum(const char* bytes, size_t numBytes)
+{
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    while (numBytes != 0)
+    {
+        const auto chunkSize = static_cast<uInt>(std::min<size_t>(numBytes, 1 << 30));
+        checksum = crc32(checksum, reinterpret_cast<const Bytef*>(bytes), chunkSize);
+        bytes += chunkSize;
+        numBytes -= chunkSize;
+    }
+
+    return static_cast<uint32_t>(checksum);
+}
+
+static void readFully(int fileDescriptor, char* bytes, size_t numBytes, uint64_t offset, const string& path)
+{
+    while (numBytes != 0)
+    {
+        const ssize_t numBytesRead = pread(fileDescriptor, bytes, numBytes, offset);
+        if (numBytesRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numBytesRead <= 0)
+        {
+            throw std::runtime_error("Unable to read " + path);
+        }
+
+        bytes += numBytesRead;
+        numBytes -= numBytesRead;
+        offset += numBytesRead;
+    }
+}
+
+static void writeFully(int fileDescriptor, const char* bytes, size_t numBytes, uint64_t offset, const string& path)
+{
+    while (numBytes != 0)
+    {
+        const ssize_t numBytesWritten = pwrite(fileDescriptor, bytes, numBytes, offset);
+        if (numBytesWritten == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numBytesWritten <= 0)
+        {
+            throw std::runtime_error("Failed to write " + path + " (" + strerror(errno) + ")");
+        }
+
+        bytes += numBytesWritten;
+        numBytes -= numBytesWritten;
+        offset += numBytesWritten;
+    }
+}
+
+static uint64_t getFileSize(int fileDescriptor, const string& path)
+{
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0)
+    {
+        throw std::runtime_error("Unable to access " + path + " (" + strerror(errno) + ")");
+    }
+
+    return fileStatus.st_size;
+}
+
+static void lockFile(int fileDescriptor, int operation, const string& path)
+{
+    while (flock(fileDescriptor, operation) != 0)
+    {
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("Unable to lock " + path + " (" + strerror(errno) + ")");
+        }
+    }
+}
+
+static string encodeIndex(const map<string, ProfileBundleEntry>& entries)
+{
+    BinaryEncoder encoder;
+    encoder.writeVarint(entries.size());
+    for (const auto& sampleIdAndEntry : entries)
+    {
+        encoder.writeString(sampleIdAndEntry.first);
+        encoder.writeVarint(sampleIdAndEntry.second.offset);
+        encoder.writeVarint(sampleIdAndEntry.second.size);
+        encoder.writeVarint(sampleIdAndEntry.second.checksum);
+    }
+
+    return encoder.buffer();
+}
+
+// Reads the index located by the trailer; returns false if the trailer or the index is missing or damaged
+static bool tryReadingIndex(int fileDescriptor, uint64_t fileSize, const string& path, BundleIndex& index)
+{
+    if (fileSize < kHeaderSize + kTrailerSize)
+    {
+        return false;
+    }
+
+    char trailer[kTrailerSize];
+    readFully(fileDescriptor, trailer, kTrailerSize, fileSize - kTrailerSize, path);
+    if (std::memcmp(trailer + kTrailerSize - sizeof(kTrailerMagic), kTrailerMagic, sizeof(kTrailerMagic)) != 0)
+    {
+        return false;
+    }
+
+    BinaryDecoder trailerDecoder(trailer, trailer + kTrailerSize);
+    const uint64_t indexOffset = trailerDecoder.readFixed64();
+    const uint64_t indexSize = trailerDecoder.readFixed64();
+    const uint64_t indexChecksum = trailerDecoder.readFixed64();
+    if (indexOffset < kHeaderSize || indexOffset > fileSize || indexSize != fileSize - kTrailerSize - indexOffset)
+    {
+        return false;
+    }
+
+    string indexEncoding(indexSize, '\0');
+    readFully(fileDescriptor, &indexEncoding[0], indexSize, indexOffset, path);
+    if (computeChecksum(indexEncoding.data(), indexEncoding.size()) != indexChecksum)
+    {
+        return false;
+    }
+
+    BinaryDecoder decoder(indexEncoding.data(), indexEncoding.data() + indexEncoding.size());
+    const uint64_t numEntries = decoder.readVarint();
+    for (uint64_t entryIndex = 0; entryIndex != numEntries; ++entryIndex)
+    {
+        const string sampleId = decoder.readString();
+        ProfileBundleEntry entry;
+        entry.offset = decoder.readVarint();
+        entry.size = decoder.readVarint();
+        entry.checksum = static_cast<uint32_t>(decoder.readVarint());
+        if (entry.offset < kHeaderSize || entry.offset > indexOffset || entry.size > indexOffset - entry.offset)
+        {
+            throw std::runtime_error("Profile bundle " + path + " has an invalid index");
+        }
+        index.entries[sampleId] = entry;
+    }
+    index.recordsEnd = indexOffset;
+
+    return true;
+}
+
+// Rebuilds the index from the records preceding the first incomplete or damaged record
+static BundleIndex scanRecords(int fileDescriptor, uint64_t fileSize, const string& path)
+{
+    BundleIndex index;
+    string recordHeader;
+    string profileEncoding;
+    while (index.recordsEnd < fileSize)
+    {
+        recordHeader.resize(std::min<uint64_t>(kMaxRecordHeaderSize, fileSize - index.recordsEnd));
+        readFully(fileDescriptor, &recordHeader[0], recordHeader.size(), index.recordsEnd, path);
+
+        string sampleId;
+        ProfileBundleEntry entry;
+        try
+        {
+            BinaryDecoder decoder(recordHeader.data(), recordHeader.data() + recordHeader.size());
+            sampleId = decoder.readString();
+            entry.size = decoder.readVarint();
+            entry.checksum = static_cast<uint32_t>(decoder.readVarint());
+        }
+        catch (const std::runtime_error&)
+        {
+            break;
+        }
+
+        BinaryEncoder headerEncoder;
+        headerEncoder.writeString(sampleId);
+        headerEncoder.writeVarint(entry.size);
+        headerEncoder.writeVarint(entry.checksum);
+        entry.offset = index.recordsEnd + headerEncoder.buffer().size();
+        if (sampleId.empty() || entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        {
+            break;
+        }
+
+        profileEncoding.resize(entry.size);
+        readFully(fileDescriptor, &profileEncoding[0], entry.size, entry.offset, path);
+        if (computeChecksum(profileEncoding.data(), profileEncoding.size()) != entry.checksum)
+        {
+            break;
+        }
+
+        index.entries[sampleId] = entry;
+        index.recordsEnd = entry.offset + entry.size;
+    }
+
+    return index;
+}
+
+static BundleIndex loadIndex(int fileDescriptor, uint64_t fileSize, const string& path)
+{
+    char header[kHeaderSize];
+    if (fileSize < kHeaderSize)
+    {
+        throw std::runtime_error(path + " is not a profile bundle");
+    }
+    readFully(fileDescriptor, header, kHeaderSize, 0, path);
+    if (!hasProfileBundleMagic(header, kHeaderSize))
+    {
+        throw std::runtime_error(path + " is not a profile bundle");
+    }
+
+    BinaryDecoder decoder(header + sizeof(kMagic), header + kHeaderSize);
+    const uint64_t version = decoder.readFixed64();
+    if (version != kFormatVersion)
+    {
+        throw std::runtime_error("Unsupported version of profile bundle format " + std::to_string(version));
+    }
+
+    BundleIndex index;
+    if (!tryReadingIndex(fileDescriptor, fileSize, path, index))
+    {
+        index = scanRecords(fileDescriptor, fileSize, path);
+    }
+
+    return index;
+}
+
+void appendToProfileBundle(const string& path, const string& sampleId, const string& profileEncoding)
+{
+    if (sampleId.empty() || sampleId.length() > kMaxSampleIdLength)
+    {
+        throw std::invalid_argument("Sample id '" + sampleId + "' cannot be stored in a profile bundle");
+    }
+
+    ScopedFileDescriptor bundleFile(open(path.c_str(), O_RDWR | O_CREAT, 0644));
+    if (bundleFile.get() == -1)
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing (" + strerror(errno) + ")");
+    }
+    lockFile(bundleFile.get(), LOCK_EX, path);
+
+    const uint64_t fileSize = getFileSize(bundleFile.get(), path);
+    BundleIndex index;
+    if (fileSize == 0)
+    {
+        BinaryEncoder headerEncoder;
+        headerEncoder.writeBytes(kMagic, sizeof(kMagic));
+        headerEncoder.writeFixed64(kFormatVersion);
+        writeFully(bundleFile.get(), headerEncoder.buffer().data(), kHeaderSize, 0, path);
+    }
+    else
+    {
+        index = loadIndex(bundleFile.get(), fileSize, path);
+    }
+
+    // Drops the index as well as any incomplete record left by an interrupted append
+    if (ftruncate(bundleFile.get(), index.recordsEnd) != 0)
+    {
+        throw std::runtime_error("Failed to truncate " + path + " (" + strerror(errno) + ")");
+    }
+
+    ProfileBundleEntry entry;
+    entry.size = profileEncoding.size();
+    entry.checksum = computeChecksum(profileEncoding.data(), profileEncoding.size());
+
+    BinaryEncoder encoder;
+    encoder.writeString(sampleId);
+    encoder.writeVarint(entry.size);
+    encoder.writeVarint(entry.checksum);
+    entry.offset = index.recordsEnd + encoder.buffer().size();
+    encoder.writeBytes(profileEncoding.data(), profileEncoding.size());
+    index.entries[sampleId] = entry;
+
+    const uint64_t indexOffset = index.recordsEnd + encoder.buffer().size();
+    const string indexEncoding = encodeIndex(index.entries);
+    encoder.writeBytes(indexEncoding.data(), indexEncoding.size());
+    encoder.writeFixed64(indexOffset);
+    encoder.writeFixed64(indexEncoding.size());
+    encoder.writeFixed64(computeChecksum(indexEncoding.data(), indexEncoding.size()));
+    encoder.writeBytes(kTrailerMagic, sizeof(kTrailerMagic));
+
+    writeFully(bundleFile.get(), encoder.buffer().data(), encoder.buffer().size(), index.recordsEnd, path);
+    if (fsync(bundleFile.get()) != 0)
+    {
+        throw std::runtime_error("Failed to write " + path + " (" + strerror(errno) + ")");
+    }
+}
+
+ProfileBundleReader::ProfileBundleReader(const string& path)
+    : path_(path)
+{
+    ScopedFileDescriptor bundleFile(open(path.c_str(), O_RDONLY));
+    if (bundleFile.get() == -1)
+    {
+        throw std::runtime_error("Unable to read " + path + " (" + strerror(errno) + ")");
+    }
+
+    // Records preceding the index are never modified, so the lock is only needed while the index is read
+    lockFile(bundleFile.get(), LOCK_SH, path);
+    entries_ = loadIndex(bundleFile.get(), getFileSize(bundleFile.get(), path), path).entries;
+    lockFile(bundleFile.get(), LOCK_UN, path);
+
+    fileDescriptor_ = bundleFile.release();
+}
+
+ProfileBundleReader::~ProfileBundleReader() { close(fileDescriptor_); }
+
+vector<string> ProfileBundleReader::sampleIds() const
+{
+    vector<string> sampleIds;
+    sampleIds.reserve(entries_.size());
+    for (const auto& sampleIdAndEntry : entries_)
+    {
+        sampleIds.push_back(sampleIdAndEntry.first);
+    }
+
+    return sampleIds;
+}
+
+string ProfileBundleReader::readProfile(const string& sampleId) const
+{
+    const auto entryIterator = entries_.find(sampleId);
+    if (entryIterator == entries_.end())
+    {
+        throw std::runtime_error("Profile bundle " + path_ + " does not contain sample " + sampleId);
+    }
+
+    const ProfileBundleEntry& entry = entryIterator->second;
+    string profileEncoding(entry.size, '\0');
+    readFully(fileDescriptor_, &profileEncoding[0], entry.size, entry.offset, path_);
+    if (computeChecksum(profileEncoding.data(), profileEncoding.size()) != entry.checksum)
+    {
+        throw std::runtime_error("Profile of sample " + sampleId + " in bundle " + path_ + " is corrupted");
+    }
+
+    return profileEncoding;
+}
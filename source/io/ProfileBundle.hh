@@ -0,0 +1,76 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Archive of single-sample STR profiles that profile runs append to and the merge workflow reads by sample id, so a
+// cohort can be stored in one file rather than a file per sample. The archive consists of
+//
+//   - a 16-byte header with the magic string and the format version,
+//   - a record for each appended profile holding the sample id, the size and CRC32 checksum of the profile, and the
+//     profile itself encoded as in a standalone profile file,
+//   - an index locating the latest profile of each sample,
+//   - a 32-byte trailer with the offset, size, and checksum of the index followed by another magic string.
+//
+// Appends are serialized by an exclusive lock on the file. Each append truncates the index, writes the new record
+// followed by the updated index, and syncs the file. If an append is interrupted, the index is rebuilt by scanning
+// the records, so the archive keeps every profile that was written completely.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct ProfileBundleEntry
+{
+    uint64_t offset;
+    uint64_t size;
+    uint32_t checksum;
+};
+
+bool hasProfileBundleMagic(const char* bytes, size_t numBytes);
+
+// Appends a profile to the bundle at the given path creating the bundle if it does not exist; the profile replaces an
+// earlier profile of the same sample
+void appendToProfileBundle(const std::string& path, const std::string& sampleId, const std::string& profileEncoding);
+
+class ProfileBundleReader
+{
+public:
+    explicit ProfileBundleReader(const std::string& path);
+    ~ProfileBundleReader();
+
+    ProfileBundleReader(const ProfileBundleReader&) = delete;
+    ProfileBundleReader& operator=(const ProfileBundleReader&) = delete;
+
+    const std::string& path() const { return path_; }
+    std::vector<std::string> sampleIds() const;
+    bool contains(const std::string& sampleId) const { return entries_.find(sampleId) != entries_.end(); }
+
+    // Returns the profile of the given sample as it was appended; can be called from multiple threads
+    std::string readProfile(const std::string& sampleId) const;
+
+private:
+    std::string path_;
+    int fileDescriptor_;
+    std::map<std::string, ProfileBundleEntry> entries_;
+};
@@ -0,0 +1,290 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/StrProfile.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "io/BinaryStrProfile.hh"
+#include "io/CompressedFile.hh"
+
+using Json = nlohmann::json;
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+StrProfileFormat decodeStrProfileFormat(const string& encoding)
+{
+    if (encoding == "json")
+    {
+        return StrProfileFormat::kJson;
+    }
+    else if (encoding == "binary")
+    {
+        return StrProfileFormat::kBinary;
+    }
+    else
+    {
+        throw std::runtime_error(encoding + " is not a valid profile format");
+    }
+}
+
+vector<RegionWithCount> computeIrrAnchorBins(const vector<RegionWithCount>& anchorRegions, int binSize)
+{
+    vector<pair<int, int64_t>> binKeys;
+    binKeys.reserve(anchorRegions.size());
+    for (const auto& region : anchorRegions)
+    {
+        const int64_t binIndex = region.contigId() == -1 ? 0 : region.start() / binSize;
+        binKeys.emplace_back(region.contigId(), binIndex);
+    }
+    std::sort(binKeys.begin(), binKeys.end());
+
+    vector<RegionWithCount> bins;
+    for (size_t keyIndex = 0; keyIndex != binKeys.size();)
+    {
+        size_t nextKeyIndex = keyIndex;
+        while (nextKeyIndex != binKeys.size() && binKeys[nextKeyIndex] == binKeys[keyIndex])
+        {
+            ++nextKeyIndex;
+        }
+
+        const int contigId = binKeys[keyIndex].first;
+        const int64_t start = contigId == -1 ? 0 : binKeys[keyIndex].second * binSize;
+        const int64_t end = contigId == -1 ? 0 : start + binSize;
+        bins.emplace_back(contigId, start, end, CountFeature(static_cast<int>(nextKeyIndex - keyIndex)));
+        keyIndex = nextKeyIndex;
+    }
+
+    return bins;
+}
+
+Json encodeAsJson(const StrProfile& profile)
+{
+    Json output;
+    output["ReadLength"] = profile.readLength;
+    output["Depth"] = profile.depth;
+    if (profile.binSize != 0)
+    {
+        output["BinSize"] = profile.binSize;
+    }
+    if (!profile.inputFingerprint.empty())
+    {
+        output["InputFingerprint"] = profile.inputFingerprint;
+    }
+
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        const string& unit = motifAndRecord.first;
+        const MotifRecord& record = motifAndRecord.second;
+
+        output[unit]["RepeatUnit"] = unit;
+        output[unit]["AnchoredIrrCount"] = record.anchoredIrrCount;
+        output[unit]["IrrPairCount"] = record.irrPairCount;
+
+        for (const auto& region : record.regionsWithIrrAnchors)
+        {
+            const string regionEncoding = region.asString(profile.contigInfo);
+            output[unit]["RegionsWithIrrAnchors"][regionEncoding] = region.feature().value();
+        }
+
+        for (const auto& bin : record.irrAnchorBins)
+        {
+            output[unit]["IrrAnchorBins"][bin.asString(profile.contigInfo)] = bin.feature().value();
+        }
+    }
+
+    return output;
+}
+
+// Accumulates the contigs encountered in region encodings of a JSON profile
+class ContigDictionary
+{
+public:
+    int getContigId(const string& contigName)
+    {
+        auto entry = nameToIndex_.find(contigName);
+        if (entry == nameToIndex_.end())
+        {
+            entry = nameToIndex_.emplace(contigName, static_cast<int>(namesAndSizes_.size())).first;
+            namesAndSizes_.emplace_back(contigName, 0);
+        }
+
+        return entry->second;
+    }
+
+    ReferenceContigInfo contigInfo() const { return ReferenceContigInfo(namesAndSizes_); }
+
+private:
+    vector<pair<string, int64_t>> namesAndSizes_;
+    unordered_map<string, int> nameToIndex_;
+};
+
+static GenomicRegion decodeRegion(const string& encoding, ContigDictionary& contigDictionary)
+{
+    if (encoding == "unaligned")
+    {
+        return { -1, 0, 0 };
+    }
+
+    const auto colonIndex = encoding.find_last_of(':');
+    const auto dashIndex = encoding.find('-', colonIndex);
+    if (colonIndex == string::npos || colonIndex == 0 || dashIndex == string::npos || dashIndex == colonIndex + 1
+        || dashIndex + 1 == encoding.size())
+    {
+        throw std::logic_error("Unexpected range format: " + encoding);
+    }
+
+    const int contigId = contigDictionary.getContigId(encoding.substr(0, colonIndex));
+    const int64_t start = std::stoll(encoding.substr(colonIndex + 1, dashIndex - colonIndex - 1));
+    const int64_t end = std::stoll(encoding.substr(dashIndex + 1));
+
+    return { contigId, start, end };
+}
+
+StrProfile decodeFromJson(const Json& profileJson)
+{
+    ContigDictionary contigDictionary;
+    int readLength = 0;
+    double depth = -1;
+    int binSize = 0;
+    string inputFingerprint;
+    std::map<string, MotifRecord> motifRecords;
+
+    for (const auto& record : profileJson.items())
+    {
+        if (record.key() == "ReadLength")
+        {
+            readLength = record.value();
+        }
+        else if (record.key() == "Depth")
+        {
+            depth = record.value();
+        }
+        else if (record.key() == "BinSize")
+        {
+            binSize = record.value();
+        }
+        else if (record.key() == "InputFingerprint")
+        {
+            inputFingerprint = record.value();
+        }
+        else if (record.value().is_object())
+        {
+            const Json& recordJson = record.value();
+            MotifRecord& motifRecord = motifRecords[record.key()];
+            if (recordJson.find("AnchoredIrrCount") != recordJson.end())
+            {
+                motifRecord.anchoredIrrCount = recordJson["AnchoredIrrCount"];
+            }
+
+            if (recordJson.find("IrrPairCount") != recordJson.end())
+            {
+                motifRecord.irrPairCount = recordJson["IrrPairCount"];
+            }
+
+            if (recordJson.find("RegionsWithIrrAnchors") != recordJson.end())
+            {
+                for (const auto& regionAndCount : recordJson["RegionsWithIrrAnchors"].items())
+                {
+                    const GenomicRegion region = decodeRegion(regionAndCount.key(), contigDictionary);
+                    const int count = regionAndCount.value();
+                    motifRecord.regionsWithIrrAnchors.emplace_back(
+                        region.contigId(), region.start(), region.end(), CountFeature(count));
+                }
+            }
+
+            if (recordJson.find("IrrAnchorBins") != recordJson.end())
+            {
+                for (const auto& binAndCount : recordJson["IrrAnchorBins"].items())
+                {
+                    const GenomicRegion bin = decodeRegion(binAndCount.key(), contigDictionary);
+                    const int count = binAndCount.value();
+                    motifRecord.irrAnchorBins.emplace_back(bin.contigId(), bin.start(), bin.end(), CountFeature(count));
+                }
+                std::sort(motifRecord.irrAnchorBins.begin(), motifRecord.irrAnchorBins.end());
+            }
+        }
+    }
+
+    StrProfile profile(contigDictionary.contigInfo());
+    profile.readLength = readLength;
+    profile.depth = depth;
+    profile.binSize = binSize;
+    profile.inputFingerprint = std::move(inputFingerprint);
+    profile.motifRecords = std::move(motifRecords);
+    return profile;
+}
+
+StrProfileFormat detectStrProfileFormat(const string& path)
+{
+    const string header = readLeadingBytes(path, 8);
+    return hasBinaryStrProfileMagic(header.data(), header.size()) ? StrProfileFormat::kBinary : StrProfileFormat::kJson;
+}
+
+StrProfile loadStrProfile(const string& path, const DecompressionThreadPool* threadPool)
+{
+    return decodeStrProfile(readFileContents(path, threadPool));
+}
+
+string encodeStrProfile(const StrProfile& profile, StrProfileFormat format)
+{
+    if (format == StrProfileFormat::kBinary)
+    {
+        return encodeAsBinary(profile);
+    }
+
+    return encodeAsJson(profile).dump(4) + "\n";
+}
+
+StrProfile decodeStrProfile(const string& encoding)
+{
+    if (hasBinaryStrProfileMagic(encoding.data(), encoding.size()))
+    {
+        return decodeFromBinary(encoding);
+    }
+
+    return decodeFromJson(Json::parse(encoding));
+}
+
+void writeStrProfile(const StrProfile& profile, StrProfileFormat format, const string& path)
+{
+    std::ofstream profileStream(path, std::ios::binary);
+    if (!profileStream.is_open())
+    {
+        throw std::runtime_error("Failed to open output file " + path + " for writing (" + strerror(errno) + ")");
+    }
+
+    const string encoding = encodeStrProfile(profile, format);
+    profileStream.write(encoding.data(), encoding.size());
+
+    if (!profileStream)
+    {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
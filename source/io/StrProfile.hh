@@ -0,0 +1,87 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "thirdparty/nlohmann_json/json.hpp"
+
+#include "region/GenomicRegion.hh"
+#include "region/ReferenceContigInfo.hh"
+
+class DecompressionThreadPool;
+
+enum class StrProfileFormat
+{
+    kJson,
+    kBinary
+};
+
+StrProfileFormat decodeStrProfileFormat(const std::string& encoding);
+
+// Summary of informative reads with in-repeat reads of a given motif
+struct MotifRecord
+{
+    int anchoredIrrCount = 0;
+    int irrPairCount = 0;
+    std::vector<RegionWithCount> regionsWithIrrAnchors;
+    // Anchored IRR counts in fixed reference bins ordered by contig and start; bins of unaligned anchors are
+    // represented by a single unaligned region
+    std::vector<RegionWithCount> irrAnchorBins;
+};
+
+// In-memory representation of a single-sample STR profile; contig ids of all regions refer to the profile's own
+// contig dictionary
+struct StrProfile
+{
+    explicit StrProfile(ReferenceContigInfo contigInfo)
+        : contigInfo(std::move(contigInfo))
+    {
+    }
+
+    ReferenceContigInfo contigInfo;
+    int readLength = 0;
+    double depth = -1;
+    // Size of the bins of anchored IRR counts; zero if the counts are not binned
+    int binSize = 0;
+    // Fingerprint of the file with reads the profile was computed from; empty if unknown
+    std::string inputFingerprint;
+    std::map<std::string, MotifRecord> motifRecords;
+};
+
+// Counts anchors in bins [k * binSize, (k + 1) * binSize) of the reference by position of their start
+std::vector<RegionWithCount> computeIrrAnchorBins(const std::vector<RegionWithCount>& anchorRegions, int binSize);
+
+nlohmann::json encodeAsJson(const StrProfile& profile);
+StrProfile decodeFromJson(const nlohmann::json& profileJson);
+
+// Determines the format of a profile file from its leading bytes; compressed files are decompressed transparently
+StrProfileFormat detectStrProfileFormat(const std::string& path);
+
+// Encodes the profile as it is written to a profile file; the format of an encoding is recognized when decoding it
+std::string encodeStrProfile(const StrProfile& profile, StrProfileFormat format);
+StrProfile decodeStrProfile(const std::string& encoding);
+
+StrProfile loadStrProfile(const std::string& path, const DecompressionThreadPool* threadPool = nullptr);
+void writeStrProfile(const StrProfile& profile, StrProfileFormat format, const std::string& path);
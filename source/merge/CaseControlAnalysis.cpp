@@ -0,0 +1,328 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/CaseControlAnalysis.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "thirdparty/spdlog/fmt/fmt.h"
+
+#include "common/ParallelWork.hh"
+
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+static const size_t kRowsPerBatch = 4096;
+
+// Appends the shortest representation that reads back as the same value, formatted like Python's repr of floats
+static void appendShortestRepresentation(double value, fmt::memory_buffer& output)
+{
+    if (!std::isfinite(value))
+    {
+        fmt::format_to(output, "{}", std::isnan(value) ? "nan" : (value > 0 ? "inf" : "-inf"));
+        return;
+    }
+
+    char buffer[32];
+    int numDigits = 1;
+    for (; numDigits != 17; ++numDigits)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%.*e", numDigits - 1, value);
+        if (std::strtod(buffer, nullptr) == value)
+        {
+            break;
+        }
+    }
+    std::snprintf(buffer, sizeof(buffer), "%.*e", numDigits - 1, value);
+
+    const int exponent = std::atoi(std::strchr(buffer, 'e') + 1);
+    if (exponent < -4 || exponent >= 16)
+    {
+        fmt::format_to(output, "{}", buffer);
+        return;
+    }
+
+    const int numDecimals = std::max(numDigits - 1 - exponent, 0);
+    std::snprintf(buffer, sizeof(buffer), "%.*f", numDecimals, value);
+    fmt::format_to(output, "{}{}", buffer, numDecimals == 0 ? ".0" : "");
+}
+
+RankSumTest::RankSumTest(vector<bool> isCase)
+    : isCase_(std::move(isCase))
+    , numCases_(static_cast<int>(std::count(isCase_.begin(), isCase_.end(), true)))
+{
+}
+
+// Only nonzero counts are sorted; the remaining samples are tied at zero and share the lowest ranks
+double RankSumTest::computePvalue(const vector<pair<int, double>>& counts)
+{
+    nonzeroCounts_.clear();
+    int numNonzeroCases = 0;
+    for (const auto& cohortIndexAndCount : counts)
+    {
+        if (cohortIndexAndCount.second != 0)
+        {
+            const bool isCase = isCase_[cohortIndexAndCount.first];
+            nonzeroCounts_.emplace_back(cohortIndexAndCount.second, isCase);
+            numNonzeroCases += isCase ? 1 : 0;
+        }
+    }
+    std::sort(nonzeroCounts_.begin(), nonzeroCounts_.end());
+
+    const auto numSamples = static_cast<double>(isCase_.size());
+    const auto numZeros = static_cast<double>(isCase_.size() - nonzeroCounts_.size());
+    double caseRankSum = (numCases_ - numNonzeroCases) * (numZeros + 1) / 2;
+
+    size_t tieStart = 0;
+    while (tieStart != nonzeroCounts_.size())
+    {
+        size_t tieEnd = tieStart;
+        int numTiedCases = 0;
+        for (; tieEnd != nonzeroCounts_.size() && nonzeroCounts_[tieEnd].first == nonzeroCounts_[tieStart].first;
+             ++tieEnd)
+        {
+            numTiedCases += nonzeroCounts_[tieEnd].second ? 1 : 0;
+        }
+
+        const double averageRank = numZeros + (tieStart + 1 + tieEnd) / 2.0;
+        caseRankSum += numTiedCases * averageRank;
+        tieStart = tieEnd;
+    }
+
+    const double numControls = numSamples - numCases_;
+    const double expectedCaseRankSum = numCases_ * (numSamples + 1) / 2;
+    const double standardDeviation = std::sqrt(numCases_ * numControls * (numSamples + 1) / 12);
+    const double zscore = (caseRankSum - expectedCaseRankSum) / standardDeviation;
+
+    return 0.5 * std::erfc(zscore / std::sqrt(2.0));
+}
+
+static void openFile(const string& path, std::ofstream& file)
+{
+    file.open(path);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write to " + path);
+    }
+}
+
+void CaseControlTableWriter::openTable(const string& path, const string& header, Table& table)
+{
+    table.path = path;
+    openFile(path, table.file);
+    table.file << header << "\n";
+
+    table.pathToUncorrectedRows = path + ".tmp";
+    openFile(table.pathToUncorrectedRows, table.uncorrectedRowsFile);
+}
+
+CaseControlTableWriter::CaseControlTableWriter(
+    const ReferenceContigInfo& contigInfo, const CohortSamples& samples, const string& pathToLocusTable,
+    const string& pathToMotifTable, int minInrepeatReads, int minInrepeatReadPairs, int threadCount)
+    : contigInfo_(contigInfo)
+    , samples_(samples)
+    , threadCount_(threadCount)
+{
+    if (samples.numCases() == 0 || samples.numCases() == samples.cohortSize())
+    {
+        throw std::runtime_error("Case-control analysis requires at least one case and one control sample");
+    }
+
+    locusTable_.minCount = minInrepeatReads;
+    openTable(pathToLocusTable, "contig\tstart\tend\tmotif\tpvalue\tbonf_pvalue\tcounts", locusTable_);
+    motifTable_.minCount = minInrepeatReadPairs;
+    openTable(pathToMotifTable, "motif\tpvalue\tbonf_pvalue\tcounts", motifTable_);
+}
+
+CaseControlTableWriter::~CaseControlTableWriter()
+{
+    std::remove(locusTable_.pathToUncorrectedRows.c_str());
+    std::remove(motifTable_.pathToUncorrectedRows.c_str());
+}
+
+void CaseControlTableWriter::addMotif(
+    const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+    const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
+{
+    if (irrPairCounts && !irrPairCounts->empty())
+    {
+        addRow(motif, *irrPairCounts, true, motifTable_);
+    }
+
+    if (!regionsWithIrrAnchors)
+    {
+        return;
+    }
+
+    vector<pair<string, const RegionWithSampleCount*>> encodedRegions;
+    encodedRegions.reserve(regionsWithIrrAnchors->size());
+    for (const auto& region : *regionsWithIrrAnchors)
+    {
+        encodedRegions.emplace_back(region.asString(contigInfo_), &region);
+    }
+    std::sort(encodedRegions.begin(), encodedRegions.end());
+
+    for (const auto& encodingAndRegion : encodedRegions)
+    {
+        const RegionWithSampleCount& region = *encodingAndRegion.second;
+        if (region.contigId() == -1)
+        {
+            addRow("", region.feature().value(), false, locusTable_);
+            continue;
+        }
+
+        string label = fmt::format(
+            "{}\t{}\t{}\t{}", contigInfo_.getContigName(region.contigId()), region.start(), region.end(), motif);
+        addRow(std::move(label), region.feature().value(), true, locusTable_);
+    }
+}
+
+void CaseControlTableWriter::addRow(
+    string label, const unordered_map<SampleId, int>& sampleCounts, bool isReported, Table& table)
+{
+    vector<pair<int, int>> counts = samples_.indexCounts(sampleCounts);
+    double maxCount = 0;
+    for (const auto& sampleIndexAndCount : counts)
+    {
+        maxCount = std::max(maxCount, samples_.normalize(sampleIndexAndCount.first, sampleIndexAndCount.second));
+    }
+
+    if (maxCount < table.minCount)
+    {
+        return;
+    }
+
+    ++table.numTests;
+    if (!isReported)
+    {
+        return;
+    }
+
+    Row row;
+    row.label = std::move(label);
+    row.counts = std::move(counts);
+    table.rows.push_back(std::move(row));
+
+    if (table.rows.size() == kRowsPerBatch)
+    {
+        flush(table);
+    }
+}
+
+void CaseControlTableWriter::testRow(RankSumTest& test, Row& row) const
+{
+    vector<pair<int, double>> cohortCounts;
+    fmt::memory_buffer encodedCounts;
+    for (size_t index = 0; index != row.counts.size(); ++index)
+    {
+        const int sampleIndex = row.counts[index].first;
+        const double normalizedCount = samples_.normalize(sampleIndex, row.counts[index].second);
+        if (samples_.cohortIndex(sampleIndex) != -1)
+        {
+            cohortCounts.emplace_back(samples_.cohortIndex(sampleIndex), normalizedCount);
+        }
+
+        fmt::format_to(encodedCounts, "{}{}:", index == 0 ? "" : ",", samples_.sampleId(sampleIndex));
+        appendShortestRepresentation(normalizedCount, encodedCounts);
+    }
+
+    row.pvalue = test.computePvalue(cohortCounts);
+    row.encodedCounts = fmt::to_string(encodedCounts);
+    vector<pair<int, int>>().swap(row.counts);
+}
+
+// Tests the buffered rows and appends them to the file of uncorrected rows as lines with the label, the p-value, and
+// the counts; neither the p-value nor the counts contain tabs
+void CaseControlTableWriter::flush(Table& table)
+{
+    processOnThreads(table.rows.size(), threadCount_, [this, &table](WorkQueue& queue) {
+        RankSumTest test(samples_.isCase());
+        size_t rowIndex;
+        while (queue.tryClaim(rowIndex))
+        {
+            testRow(test, table.rows[rowIndex]);
+        }
+    });
+
+    fmt::memory_buffer lines;
+    for (const auto& row : table.rows)
+    {
+        fmt::format_to(lines, "{}\t", row.label);
+        appendShortestRepresentation(row.pvalue, lines);
+        fmt::format_to(lines, "\t{}\n", row.encodedCounts);
+    }
+    table.uncorrectedRowsFile.write(lines.data(), lines.size());
+    table.rows.clear();
+}
+
+// P-values can only be corrected once the total number of tests is known, so the rows are rewritten at the end; the
+// shortest representation of the uncorrected p-values reads back as the same value
+void CaseControlTableWriter::write(Table& table)
+{
+    flush(table);
+    table.uncorrectedRowsFile.close();
+    if (!table.uncorrectedRowsFile)
+    {
+        throw std::runtime_error("Failed to write " + table.pathToUncorrectedRows);
+    }
+
+    std::ifstream uncorrectedRowsFile(table.pathToUncorrectedRows);
+    string uncorrectedRow;
+    while (std::getline(uncorrectedRowsFile, uncorrectedRow))
+    {
+        const size_t countsStart = uncorrectedRow.rfind('\t') + 1;
+        const size_t pvalueStart = uncorrectedRow.rfind('\t', countsStart - 2) + 1;
+        const double pvalue = std::strtod(uncorrectedRow.c_str() + pvalueStart, nullptr);
+        const double correctedPvalue = std::min(pvalue * table.numTests, 1.0);
+
+        fmt::memory_buffer line;
+        line.append(uncorrectedRow.data(), uncorrectedRow.data() + countsStart);
+        appendShortestRepresentation(correctedPvalue, line);
+        line.push_back('\t');
+        line.append(uncorrectedRow.data() + countsStart, uncorrectedRow.data() + uncorrectedRow.size());
+        line.push_back('\n');
+        table.file.write(line.data(), line.size());
+    }
+    if (uncorrectedRowsFile.bad())
+    {
+        throw std::runtime_error("Failed to read " + table.pathToUncorrectedRows);
+    }
+    uncorrectedRowsFile.close();
+    std::remove(table.pathToUncorrectedRows.c_str());
+
+    table.file.close();
+    if (!table.file)
+    {
+        throw std::runtime_error("Failed to write " + table.path);
+    }
+}
+
+void CaseControlTableWriter::finish()
+{
+    write(locusTable_);
+    write(motifTable_);
+}
@@ -0,0 +1,107 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Case-control analysis of a merged cohort performed directly on the merged counts. Depth-normalized counts of cases
+// and controls are compared with the one-sided Wilcoxon rank-sum test for each region and motif that has enough
+// in-repeat reads, and p-values are Bonferroni-corrected for the number of tests. This is equivalent to the
+// case-control workflows of the accompanying Python scripts with the default normal approximation.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "merge/CohortSamples.hh"
+#include "merge/MultisampleProfile.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Computes rank-sum test p-values; each instance holds scratch buffers and must be used by one thread at a time
+class RankSumTest
+{
+public:
+    explicit RankSumTest(std::vector<bool> isCase);
+
+    // Returns the p-value of the hypothesis that counts of cases are greater than counts of controls; counts are given
+    // as (cohort index, count) pairs and samples that are not listed have zero counts
+    double computePvalue(const std::vector<std::pair<int, double>>& counts);
+
+private:
+    std::vector<bool> isCase_;
+    int numCases_ = 0;
+    std::vector<std::pair<double, bool>> nonzeroCounts_;
+};
+
+// Tests rows of the multisample profile on a pool of threads and writes case-control locus and motif tables once all
+// motifs are added; motifs are added in lexicographic order. Tested rows are written to temporary files batch by batch
+// and rewritten with corrected p-values once the number of tests is known, so only one batch is held in memory.
+class CaseControlTableWriter
+{
+public:
+    CaseControlTableWriter(
+        const ReferenceContigInfo& contigInfo, const CohortSamples& samples, const std::string& pathToLocusTable,
+        const std::string& pathToMotifTable, int minInrepeatReads, int minInrepeatReadPairs, int threadCount);
+    ~CaseControlTableWriter();
+
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const std::vector<RegionWithSampleCount>* regionsWithIrrAnchors);
+    void finish();
+
+private:
+    struct Row
+    {
+        std::string label;
+        // Sample indexes and raw counts ordered by sample index; released once the row is tested
+        std::vector<std::pair<int, int>> counts;
+        double pvalue = 1;
+        std::string encodedCounts;
+    };
+
+    struct Table
+    {
+        std::string path;
+        std::ofstream file;
+        // Tested rows with p-values that are not yet corrected
+        std::string pathToUncorrectedRows;
+        std::ofstream uncorrectedRowsFile;
+        int minCount = 0;
+        // Rows that passed the count filter including unaligned regions, which are tested but not reported
+        uint64_t numTests = 0;
+        std::vector<Row> rows;
+    };
+
+    void addRow(
+        std::string label, const std::unordered_map<SampleId, int>& sampleCounts, bool isReported, Table& table);
+    void openTable(const std::string& path, const std::string& header, Table& table);
+    void testRow(RankSumTest& test, Row& row) const;
+    void flush(Table& table);
+    void write(Table& table);
+
+    const ReferenceContigInfo& contigInfo_;
+    const CohortSamples& samples_;
+    int threadCount_;
+    Table locusTable_;
+    Table motifTable_;
+};
@@ -0,0 +1,83 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/CohortSamples.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using std::pair;
+using std::unordered_map;
+using std::vector;
+
+static const double kTargetDepth = 40;
+
+CohortSamples::CohortSamples(
+    const SampleIdToSampleParameters& parametersForSamples, const SampleIdToSampleStatus& sampleStatuses)
+{
+    for (const auto& sampleIdAndParameters : parametersForSamples)
+    {
+        sampleIds_.push_back(sampleIdAndParameters.first);
+    }
+    std::sort(sampleIds_.begin(), sampleIds_.end());
+
+    for (const auto& sampleId : sampleIds_)
+    {
+        const int sampleIndex = static_cast<int>(depths_.size());
+        sampleIndexes_.emplace(sampleId, sampleIndex);
+        depths_.push_back(parametersForSamples.at(sampleId).depth);
+
+        const auto sampleStatus = sampleStatuses.find(sampleId);
+        if (sampleStatus == sampleStatuses.end())
+        {
+            cohortIndexes_.push_back(-1);
+            continue;
+        }
+
+        cohortIndexes_.push_back(static_cast<int>(cohortSampleIndexes_.size()));
+        cohortSampleIndexes_.push_back(sampleIndex);
+        const bool isCase = sampleStatus->second == SampleStatus::kCase;
+        isCase_.push_back(isCase);
+        numCases_ += isCase ? 1 : 0;
+    }
+}
+
+vector<pair<int, int>> CohortSamples::indexCounts(const unordered_map<SampleId, int>& sampleCounts) const
+{
+    vector<pair<int, int>> counts;
+    counts.reserve(sampleCounts.size());
+    for (const auto& sampleIdAndCount : sampleCounts)
+    {
+        const auto sampleIndex = sampleIndexes_.find(sampleIdAndCount.first);
+        if (sampleIndex == sampleIndexes_.end())
+        {
+            throw std::logic_error("Depth of sample " + sampleIdAndCount.first + " is unknown");
+        }
+        counts.emplace_back(sampleIndex->second, sampleIdAndCount.second);
+    }
+    std::sort(counts.begin(), counts.end());
+    return counts;
+}
+
+double CohortSamples::normalize(int sampleIndex, int count) const
+{
+    return kTargetDepth * count / depths_[sampleIndex];
+}
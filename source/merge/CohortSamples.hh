@@ -0,0 +1,65 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "merge/Manifest.hh"
+#include "merge/MultisampleProfile.hh"
+
+using SampleIdToSampleStatus = std::unordered_map<SampleId, SampleStatus>;
+
+// Samples of a merged profile ordered by id. Samples with known case/control status form the cohort that takes part
+// in statistical analyses; other samples are only reported.
+class CohortSamples
+{
+public:
+    CohortSamples(const SampleIdToSampleParameters& parametersForSamples, const SampleIdToSampleStatus& sampleStatuses);
+
+    int numSamples() const { return static_cast<int>(sampleIds_.size()); }
+    const SampleId& sampleId(int sampleIndex) const { return sampleIds_[sampleIndex]; }
+    double depth(int sampleIndex) const { return depths_[sampleIndex]; }
+    // Returns -1 for samples outside of the cohort
+    int cohortIndex(int sampleIndex) const { return cohortIndexes_[sampleIndex]; }
+
+    int cohortSize() const { return static_cast<int>(cohortSampleIndexes_.size()); }
+    int sampleIndexOfCohortMember(int cohortIndex) const { return cohortSampleIndexes_[cohortIndex]; }
+    const std::vector<bool>& isCase() const { return isCase_; }
+    int numCases() const { return numCases_; }
+
+    // Converts counts keyed by sample id to (sample index, count) pairs ordered by sample index
+    std::vector<std::pair<int, int>> indexCounts(const std::unordered_map<SampleId, int>& sampleCounts) const;
+    // Depth-normalized count
+    double normalize(int sampleIndex, int count) const;
+
+private:
+    std::vector<SampleId> sampleIds_;
+    std::vector<double> depths_;
+    std::vector<int> cohortIndexes_;
+    std::unordered_map<SampleId, int> sampleIndexes_;
+    std::vector<int> cohortSampleIndexes_;
+    std::vector<bool> isCase_;
+    int numCases_ = 0;
+};
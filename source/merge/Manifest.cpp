@@ -0,0 +1,71 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/Manifest.hh"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using std::string;
+
+SampleStatus decodeSampleStatus(const string& encoding)
+{
+    if (encoding == "case")
+    {
+        return SampleStatus::kCase;
+    }
+    else if (encoding == "control")
+    {
+        return SampleStatus::kControl;
+    }
+    else
+    {
+        throw std::runtime_error(encoding + " is not a valid sample status");
+    }
+}
+
+Manifest loadManifest(const string& path)
+{
+    Manifest manifest;
+
+    std::ifstream manifestFile(path);
+    if (!manifestFile)
+    {
+        throw std::runtime_error("Unable to load manifest from " + path);
+    }
+
+    string line;
+    while (std::getline(manifestFile, line))
+    {
+        std::istringstream decoder(line);
+        string sample;
+        string statusEncoding;
+        string path;
+        if (!(decoder >> sample >> statusEncoding >> path))
+        {
+            throw std::runtime_error("Unable to decode manifest line " + line);
+        }
+        manifest.emplace_back(sample, statusEncoding, path);
+    }
+
+    return manifest;
+}
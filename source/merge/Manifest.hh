@@ -0,0 +1,58 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum class SampleStatus
+{
+    kCase,
+    kControl
+};
+
+SampleStatus decodeSampleStatus(const std::string& encoding);
+
+struct ManifestEntry
+{
+    ManifestEntry(std::string sample, SampleStatus status, std::string path)
+        : sample(std::move(sample))
+        , status(status)
+        , path(std::move(path))
+    {
+    }
+
+    ManifestEntry(std::string sample, const std::string& statusEncoding, std::string path)
+        : sample(std::move(sample))
+        , status(decodeSampleStatus(statusEncoding))
+        , path(std::move(path))
+    {
+    }
+
+    std::string sample;
+    SampleStatus status;
+    std::string path;
+};
+
+using Manifest = std::vector<ManifestEntry>;
+
+Manifest loadManifest(const std::string& path);
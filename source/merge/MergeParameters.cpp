@@ -22,6 +22,7 @@
 #include "merge/MergeParameters.hh"
 
 #include <memory>
+#include <stdexcept>
 
 #include <boost/filesystem.hpp>
 
@@ -31,12 +32,28 @@ using std::string;
 
 MergeWorkflowParameters::MergeWorkflowParameters(
     const std::string& pathToReference, const string& outputPrefix, string pathToManifest, int shortestUnitToConsider,
-    int longestUnitToConsider)
+    int longestUnitToConsider, const MergeWorkflowOptions& options)
     : pathToReference_(pathToReference)
     , pathToMultisampleProfile_(outputPrefix + ".multisample_profile.json")
+    , pathToMultisampleStore_(options.writeStore ? outputPrefix + ".multisample_store.bin" : "")
+    , pathToOutlierLocusTable_(options.writeOutlierTables ? outputPrefix + ".outlier_locus.tsv" : "")
+    , pathToOutlierMotifTable_(options.writeOutlierTables ? outputPrefix + ".outlier_motif.tsv" : "")
+    , pathToCaseControlLocusTable_(options.writeCaseControlTables ? outputPrefix + ".casecontrol_locus.tsv" : "")
+    , pathToCaseControlMotifTable_(options.writeCaseControlTables ? outputPrefix + ".casecontrol_motif.tsv" : "")
+    , pathToArrowSampleTable_(options.writeArrowTables ? outputPrefix + ".samples.arrow" : "")
+    , pathToArrowLocusTable_(options.writeArrowTables ? outputPrefix + ".loci.arrow" : "")
+    , pathToArrowCountTable_(options.writeArrowTables ? outputPrefix + ".counts.arrow" : "")
     , pathToManifest_(std::move(pathToManifest))
+    , pathToBaseProfile_(options.pathToBaseProfile)
+    , pathToSpilledRunPrefix_(outputPrefix + ".merge_run")
+    , pathToTargetRegions_(options.pathToTargetRegions)
     , shortestUnitToConsider_(shortestUnitToConsider)
     , longestUnitToConsider_(longestUnitToConsider)
+    , threadCount_(options.threadCount)
+    , memoryBudget_(options.memoryBudget)
+    , minInrepeatReads_(options.minInrepeatReads)
+    , minInrepeatReadPairs_(options.minInrepeatReadPairs)
+    , useBins_(options.useBins)
 {
 }
 
@@ -232,4 +249,22 @@ void assertValidity(const MergeWorkflowParameters& parameters)
 {
     assertPathToExistingFile(parameters.pathToReference());
     assertPathToExistingFile(parameters.pathToManifest());
+    if (!parameters.pathToBaseProfile().empty())
+    {
+        assertPathToExistingFile(parameters.pathToBaseProfile());
+    }
+    if (!parameters.pathToTargetRegions().empty())
+    {
+        assertPathToExistingFile(parameters.pathToTargetRegions());
+    }
+
+    if (parameters.threadCount() < 1)
+    {
+        throw std::invalid_argument("Number of threads must be positive");
+    }
+
+    if (parameters.useBins() && (!parameters.pathToBaseProfile().empty() || parameters.memoryBudget() != 0))
+    {
+        throw std::invalid_argument("Merging with bins cannot be combined with base profile or memory budget");
+    }
 }
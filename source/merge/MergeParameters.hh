@@ -21,28 +21,92 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+// Optional settings of the merge workflow; the defaults merge all regions in memory on one thread
+struct MergeWorkflowOptions
+{
+    int threadCount = 1;
+    // Maximal size of regions held in memory before they are spilled to disk; zero keeps all regions in memory
+    size_t memoryBudget = 0;
+    // Multisample profile that new samples are added to; empty if the merge starts from scratch
+    std::string pathToBaseProfile;
+    // BED file with regions that merged regions are restricted to; empty if all regions are kept
+    std::string pathToTargetRegions;
+    // Merge binned anchored IRR counts of the profiles instead of clustering regions with anchored IRRs
+    bool useBins = false;
+    bool writeStore = false;
+    bool writeArrowTables = false;
+    bool writeOutlierTables = false;
+    bool writeCaseControlTables = false;
+    // Minimal depth-normalized counts of regions and motifs included in the case-control analysis
+    int minInrepeatReads = 5;
+    int minInrepeatReadPairs = 5;
+};
+
 class MergeWorkflowParameters
 {
 public:
     MergeWorkflowParameters(
         const std::string& pathToReference, const std::string& outputPrefix, std::string pathToManifest,
-        int shortestUnitToConsider, int longestUnitToConsider);
+        int shortestUnitToConsider, int longestUnitToConsider,
+        const MergeWorkflowOptions& options = MergeWorkflowOptions());
 
     const std::string& pathToReference() const { return pathToReference_; }
     const std::string& pathToMultisampleProfile() const { return pathToMultisampleProfile_; }
+    // Empty unless the multisample store was requested
+    const std::string& pathToMultisampleStore() const { return pathToMultisampleStore_; }
+    // Empty unless the outlier analysis was requested
+    const std::string& pathToOutlierLocusTable() const { return pathToOutlierLocusTable_; }
+    const std::string& pathToOutlierMotifTable() const { return pathToOutlierMotifTable_; }
+    // Empty unless the case-control analysis was requested
+    const std::string& pathToCaseControlLocusTable() const { return pathToCaseControlLocusTable_; }
+    const std::string& pathToCaseControlMotifTable() const { return pathToCaseControlMotifTable_; }
+    // Empty unless the Arrow tables were requested
+    const std::string& pathToArrowSampleTable() const { return pathToArrowSampleTable_; }
+    const std::string& pathToArrowLocusTable() const { return pathToArrowLocusTable_; }
+    const std::string& pathToArrowCountTable() const { return pathToArrowCountTable_; }
     const std::string& pathToManifest() const { return pathToManifest_; }
+    // Multisample profile that new samples are added to; empty if the merge starts from scratch
+    const std::string& pathToBaseProfile() const { return pathToBaseProfile_; }
+    const std::string& pathToSpilledRunPrefix() const { return pathToSpilledRunPrefix_; }
+    // BED file with regions that merged regions are restricted to; empty if all regions are kept
+    const std::string& pathToTargetRegions() const { return pathToTargetRegions_; }
     int shortestUnitToConsider() const { return shortestUnitToConsider_; }
     int longestUnitToConsider() const { return longestUnitToConsider_; }
+    int threadCount() const { return threadCount_; }
+    // Maximal size of regions held in memory before they are spilled to disk; zero keeps all regions in memory
+    size_t memoryBudget() const { return memoryBudget_; }
+    // Minimal depth-normalized counts of regions and motifs included in the case-control analysis
+    int minInrepeatReads() const { return minInrepeatReads_; }
+    int minInrepeatReadPairs() const { return minInrepeatReadPairs_; }
+    // Merge binned anchored IRR counts of the profiles instead of clustering regions with anchored IRRs
+    bool useBins() const { return useBins_; }
 
 private:
     std::string pathToReference_;
     std::string pathToMultisampleProfile_;
+    std::string pathToMultisampleStore_;
+    std::string pathToOutlierLocusTable_;
+    std::string pathToOutlierMotifTable_;
+    std::string pathToCaseControlLocusTable_;
+    std::string pathToCaseControlMotifTable_;
+    std::string pathToArrowSampleTable_;
+    std::string pathToArrowLocusTable_;
+    std::string pathToArrowCountTable_;
     std::string pathToManifest_;
+    std::string pathToBaseProfile_;
+    std::string pathToSpilledRunPrefix_;
+    std::string pathToTargetRegions_;
     int shortestUnitToConsider_;
     int longestUnitToConsider_;
+    int threadCount_;
+    size_t memoryBudget_;
+    int minInrepeatReads_;
+    int minInrepeatReadPairs_;
+    bool useBins_;
 };
 
 void assertValidity(const MergeWorkflowParameters& parameters);
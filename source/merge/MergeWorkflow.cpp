@@ -21,242 +21,346 @@
 
 #include "merge/MergeWorkflow.hh"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
-#include <sstream>
 #include <stdexcept>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
-#include "thirdparty/nlohmann_json/json.hpp"
 #include "thirdparty/spdlog/spdlog.h"
 
 #include "MergeParameters.hh"
 #include "io/Reference.hh"
+#include "merge/CaseControlAnalysis.hh"
+#include "merge/CohortSamples.hh"
+#include "merge/Manifest.hh"
+#include "merge/MultisampleArrowWriter.hh"
 #include "merge/MultisampleProfile.hh"
+#include "merge/MultisampleProfileWriter.hh"
+#include "merge/MultisampleStore.hh"
+#include "merge/OutlierAnalysis.hh"
+#include "merge/SampleProfileLoader.hh"
+#include "merge/SpilledAnchoredIrrProfile.hh"
+#include "region/TargetRegionIndex.hh"
 
-using std::string;
-using std::unordered_map;
-using std::unordered_set;
 using std::vector;
 
-using Json = nlohmann::json;
-
-struct SampleParameters
+// Samples of a multisample profile listed in the manifest share the status of its manifest entry. A sample may be
+// present in only one input, since the counts of a sample present in several inputs would be added more than once.
+static void addSampleSummary(
+    const ManifestEntry& sampleInfo, const SampleProfile& sampleProfile, MultisampleIrrPairProfile& pairedIrrProfile,
+    SampleIdToSampleParameters& parametersForSamples, SampleIdToSampleStatus& sampleStatuses)
 {
-    SampleParameters(int readLength, double depth)
-        : readLength(readLength)
-        , depth(depth)
+    for (const auto& motifAndCounts : sampleProfile.irrPairProfile)
     {
+        pairedIrrProfile[motifAndCounts.first].insert(motifAndCounts.second.begin(), motifAndCounts.second.end());
     }
-    int readLength;
-    double depth;
-};
-using SampleIdToSampleParameters = unordered_map<string, SampleParameters>;
-
-enum class SampleStatus
-{
-    kCase,
-    kControl
-};
 
-SampleStatus decodeSampleStatus(const string& encoding)
-{
-    if (encoding == "case")
-    {
-        return SampleStatus::kCase;
-    }
-    else if (encoding == "control")
+    for (const auto& sampleIdAndParameters : sampleProfile.parametersForSamples)
     {
-        return SampleStatus::kControl;
-    }
-    else
-    {
-        throw std::runtime_error(encoding + " is not a valid sample status");
+        if (!parametersForSamples.emplace(sampleIdAndParameters).second)
+        {
+            throw std::runtime_error(
+                "Sample " + sampleIdAndParameters.first + " of " + sampleInfo.path
+                + " is present in more than one input profile");
+        }
+        sampleStatuses.emplace(sampleIdAndParameters.first, sampleInfo.status);
     }
 }
 
-struct ManifestEntry
+// Writes the multisample profile and, if requested, the multisample store and the tables of the outlier and
+// case-control analyses; motifs are added in lexicographic order
+class MergeOutputs
 {
-    ManifestEntry(string sample, SampleStatus status, string path)
-        : sample(std::move(sample))
-        , status(status)
-        , path(std::move(path))
+public:
+    MergeOutputs(
+        const MergeWorkflowParameters& parameters, const ReferenceContigInfo& contigInfo,
+        const SampleIdToSampleParameters& parametersForSamples, const SampleIdToSampleStatus& sampleStatuses)
+        : parameters_(parameters)
+        , parametersForSamples_(parametersForSamples)
+        , profileFile_(parameters.pathToMultisampleProfile())
+        , profileWriter_(contigInfo, profileFile_)
     {
-    }
+        if (!profileFile_)
+        {
+            throw std::logic_error("Unable to write to " + parameters.pathToMultisampleProfile());
+        }
 
-    ManifestEntry(string sample, const string& statusEncoding, string path)
-        : sample(std::move(sample))
-        , status(decodeSampleStatus(statusEncoding))
-        , path(std::move(path))
-    {
-    }
+        if (!parameters.pathToMultisampleStore().empty())
+        {
+            storeWriter_.reset(
+                new MultisampleStoreWriter(contigInfo, parametersForSamples, parameters.pathToMultisampleStore()));
+        }
 
-    string sample;
-    SampleStatus status;
-    string path;
-};
+        if (!parameters.pathToArrowLocusTable().empty())
+        {
+            arrowWriter_.reset(new MultisampleArrowWriter(
+                contigInfo, parametersForSamples, parameters.pathToArrowSampleTable(),
+                parameters.pathToArrowLocusTable(), parameters.pathToArrowCountTable()));
+        }
 
-using Manifest = vector<ManifestEntry>;
+        const bool runOutlierAnalysis = !parameters.pathToOutlierLocusTable().empty();
+        const bool runCaseControlAnalysis = !parameters.pathToCaseControlLocusTable().empty();
+        if (runOutlierAnalysis || runCaseControlAnalysis)
+        {
+            samples_.reset(new CohortSamples(parametersForSamples, sampleStatuses));
+        }
 
-Manifest loadManifest(const string& path)
-{
-    Manifest manifest;
+        if (runOutlierAnalysis)
+        {
+            outlierWriter_.reset(new OutlierTableWriter(
+                contigInfo, *samples_, parameters.pathToOutlierLocusTable(), parameters.pathToOutlierMotifTable(),
+                parameters.threadCount()));
+        }
 
-    std::ifstream manifestFile(path);
-    if (!manifestFile)
+        if (runCaseControlAnalysis)
+        {
+            caseControlWriter_.reset(new CaseControlTableWriter(
+                contigInfo, *samples_, parameters.pathToCaseControlLocusTable(),
+                parameters.pathToCaseControlMotifTable(), parameters.minInrepeatReads(),
+                parameters.minInrepeatReadPairs(), parameters.threadCount()));
+        }
+    }
+
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
     {
-        throw std::runtime_error("Unable to load manifest from " + path);
+        profileWriter_.addMotif(motif, irrPairCounts, regionsWithIrrAnchors);
+        if (storeWriter_)
+        {
+            storeWriter_->addMotif(motif, irrPairCounts, regionsWithIrrAnchors);
+        }
+        if (arrowWriter_)
+        {
+            arrowWriter_->addMotif(motif, irrPairCounts, regionsWithIrrAnchors);
+        }
+        if (outlierWriter_)
+        {
+            outlierWriter_->addMotif(motif, irrPairCounts, regionsWithIrrAnchors);
+        }
+        if (caseControlWriter_)
+        {
+            caseControlWriter_->addMotif(motif, irrPairCounts, regionsWithIrrAnchors);
+        }
     }
 
-    string line;
-    while (std::getline(manifestFile, line))
+    void finish()
     {
-        std::istringstream decoder(line);
-        string sample;
-        string statusEncoding;
-        string path;
-        if (!(decoder >> sample >> statusEncoding >> path))
+        profileWriter_.finish(parametersForSamples_);
+        profileFile_.close();
+        if (!profileFile_)
+        {
+            throw std::runtime_error("Failed to write " + parameters_.pathToMultisampleProfile());
+        }
+
+        if (storeWriter_)
+        {
+            storeWriter_->finish();
+        }
+        if (arrowWriter_)
         {
-            throw std::runtime_error("Unable to decode manifest line " + line);
+            arrowWriter_->finish();
+        }
+        if (outlierWriter_)
+        {
+            outlierWriter_->finish();
+        }
+        if (caseControlWriter_)
+        {
+            caseControlWriter_->finish();
         }
-        manifest.emplace_back(sample, statusEncoding, path);
     }
 
-    return manifest;
-}
+private:
+    const MergeWorkflowParameters& parameters_;
+    const SampleIdToSampleParameters& parametersForSamples_;
+    std::ofstream profileFile_;
+    MultisampleProfileWriter profileWriter_;
+    std::unique_ptr<MultisampleStoreWriter> storeWriter_;
+    std::unique_ptr<MultisampleArrowWriter> arrowWriter_;
+    std::unique_ptr<CohortSamples> samples_;
+    std::unique_ptr<OutlierTableWriter> outlierWriter_;
+    std::unique_ptr<CaseControlTableWriter> caseControlWriter_;
+};
 
-void loadAnchorInfo(
-    const ReferenceContigInfo& contigInfo, const string& sampleId, const string& motif, const Json& record,
-    MultisampleAnchoredIrrProfile& anchoredIrrProfile)
+// Collects the motifs of both profiles in lexicographic order
+static vector<Motif> getSortedMotifs(
+    const MultisampleIrrPairProfile& irrPairProfile, const MultisampleAnchoredIrrProfile& anchoredIrrProfile)
 {
-    if (record.find("RegionsWithIrrAnchors") == record.end())
+    vector<Motif> motifs;
+    for (const auto& motifAndCounts : irrPairProfile)
     {
-        return;
+        motifs.push_back(motifAndCounts.first);
     }
-
-    for (const auto& regionAndCount : record["RegionsWithIrrAnchors"].items())
+    for (const auto& motifAndRegions : anchoredIrrProfile)
     {
-        GenomicRegion region = decode(contigInfo, regionAndCount.key());
-        SampleCountFeature sampleCount({ { sampleId, regionAndCount.value() } });
-        RegionWithSampleCount regionWithSampleCount(region.contigId(), region.start(), region.end(), sampleCount);
-        anchoredIrrProfile[motif].push_back(regionWithSampleCount);
+        motifs.push_back(motifAndRegions.first);
     }
+    std::sort(motifs.begin(), motifs.end());
+    motifs.erase(std::unique(motifs.begin(), motifs.end()), motifs.end());
+    return motifs;
 }
 
-void loadPairedIrrProfile(
-    const string& sampleId, const string& motif, const Json& record, MultisampleIrrPairProfile& pairedIrrProfile)
+static void writeOutputs(
+    const MultisampleIrrPairProfile& irrPairProfile, const MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MergeOutputs& outputs)
 {
-    if (record.find("IrrPairCount") == record.end() || record["IrrPairCount"] == 0)
+    for (const auto& motif : getSortedMotifs(irrPairProfile, anchoredIrrProfile))
     {
-        return;
+        const auto irrPairCounts = irrPairProfile.find(motif);
+        const auto regionsWithIrrAnchors = anchoredIrrProfile.find(motif);
+        outputs.addMotif(
+            motif, irrPairCounts != irrPairProfile.end() ? &irrPairCounts->second : nullptr,
+            regionsWithIrrAnchors != anchoredIrrProfile.end() ? &regionsWithIrrAnchors->second : nullptr);
     }
-
-    pairedIrrProfile[motif].emplace(sampleId, record["IrrPairCount"]);
+    outputs.finish();
 }
 
-void loadSampleProfile(
-    const ManifestEntry& sampleInfo, const ReferenceContigInfo& contigInfo,
-    MultisampleAnchoredIrrProfile& anchoredIrrProfile, MultisampleIrrPairProfile& pairedIrrProfile,
-    SampleIdToSampleParameters& parametersForSamples, int shortestUnit, int longestUnit)
+static void runInMemoryMerge(
+    const MergeWorkflowParameters& parameters, const ReferenceContigInfo& contigInfo, const Manifest& manifest,
+    ParallelSampleProfileLoader& profileLoader, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& irrPairProfile, SampleIdToSampleParameters& parametersForSamples,
+    SampleIdToSampleStatus& sampleStatuses)
 {
-    std::ifstream profileFile(sampleInfo.path);
-    if (!profileFile)
+    int sampleCount = 0;
+    int kNormalizationStride = 50;
+    for (const auto& sampleInfo : manifest)
     {
-        throw std::runtime_error("Unable to read " + sampleInfo.path);
+        spdlog::info("Loading STR profile of {}", sampleInfo.sample);
+        auto sampleProfile = profileLoader.next();
+        addAnchoredIrrProfile(sampleProfile->anchoredIrrProfile, anchoredIrrProfile);
+        addSampleSummary(sampleInfo, *sampleProfile, irrPairProfile, parametersForSamples, sampleStatuses);
+        sampleCount++;
+
+        if (sampleCount % kNormalizationStride == 0)
+        {
+            spdlog::info("Normalizing after loading sample #{}", sampleCount);
+            normalize(anchoredIrrProfile);
+        }
     }
+    normalize(anchoredIrrProfile);
 
-    Json profileJson;
-    profileFile >> profileJson;
+    MergeOutputs outputs(parameters, contigInfo, parametersForSamples, sampleStatuses);
+    writeOutputs(irrPairProfile, anchoredIrrProfile, outputs);
+}
 
-    int readLength = 0;
-    double depth = -1;
-    for (const auto& record : profileJson.items())
+// Bins of all samples share reference-anchored coordinates, so the profiles are combined by adding the counts of
+// matching bins; neither sorting nor clustering of regions is needed
+static void runBinnedMerge(
+    const MergeWorkflowParameters& parameters, const ReferenceContigInfo& contigInfo, const Manifest& manifest,
+    ParallelSampleProfileLoader& profileLoader, MultisampleIrrPairProfile& irrPairProfile,
+    SampleIdToSampleParameters& parametersForSamples, SampleIdToSampleStatus& sampleStatuses)
+{
+    // Bins are keyed by contig and start; unaligned bins have contig id -1 and start 0
+    using BinKey = std::pair<int, int64_t>;
+    struct BinKeyHash
     {
-        if (record.key() == "ReadLength")
+        size_t operator()(const BinKey& key) const
         {
-            readLength = record.value();
+            // Contig indices can be negative for unplaced reads, so the shift is done on an unsigned value
+            const uint64_t contigBits = static_cast<uint64_t>(static_cast<int64_t>(key.first)) << 40;
+            return std::hash<uint64_t>()(contigBits ^ static_cast<uint64_t>(key.second));
         }
-        else if (record.key() == "Depth")
+    };
+    std::unordered_map<Motif, std::unordered_map<BinKey, SampleToIrrPairCount, BinKeyHash>> binCounts;
+
+    int binSize = 0;
+    for (const auto& sampleInfo : manifest)
+    {
+        spdlog::info("Loading STR profile of {}", sampleInfo.sample);
+        auto sampleProfile = profileLoader.next();
+        if (binSize != 0 && sampleProfile->binSize != binSize)
         {
-            depth = record.value();
+            throw std::runtime_error("Bin size of " + sampleInfo.sample + " differs from bin size of other samples");
         }
-        else if (shortestUnit <= record.key().length() && record.key().length() <= longestUnit)
+        binSize = sampleProfile->binSize;
+
+        for (const auto& motifAndBins : sampleProfile->anchoredIrrProfile)
         {
-            const string& motif = record.key();
-            loadAnchorInfo(contigInfo, sampleInfo.sample, motif, record.value(), anchoredIrrProfile);
-            loadPairedIrrProfile(sampleInfo.sample, motif, record.value(), pairedIrrProfile);
+            auto& motifBinCounts = binCounts[motifAndBins.first];
+            for (const auto& bin : motifAndBins.second)
+            {
+                auto& sampleCounts = motifBinCounts[BinKey(bin.contigId(), bin.start())];
+                for (const auto& sampleIdAndCount : bin.feature().value())
+                {
+                    sampleCounts[sampleIdAndCount.first] += sampleIdAndCount.second;
+                }
+            }
         }
+        addSampleSummary(sampleInfo, *sampleProfile, irrPairProfile, parametersForSamples, sampleStatuses);
     }
 
-    if (readLength == 0)
-    {
-        throw std::runtime_error("Read length appears to be unset for " + sampleInfo.sample);
-    }
-
-    if (depth == -1)
+    MultisampleAnchoredIrrProfile anchoredIrrProfile;
+    for (auto& motifAndBinCounts : binCounts)
     {
-        throw std::runtime_error("Depth appears to be unset for " + sampleInfo.sample);
+        auto& bins = anchoredIrrProfile[motifAndBinCounts.first];
+        bins.reserve(motifAndBinCounts.second.size());
+        for (auto& binAndCounts : motifAndBinCounts.second)
+        {
+            const BinKey& key = binAndCounts.first;
+            const int64_t end = key.first == -1 ? 0 : key.second + binSize;
+            bins.emplace_back(key.first, key.second, end, SampleCountFeature(std::move(binAndCounts.second)));
+        }
+        motifAndBinCounts.second.clear();
     }
 
-    parametersForSamples.emplace(sampleInfo.sample, SampleParameters(readLength, depth));
+    MergeOutputs outputs(parameters, contigInfo, parametersForSamples, sampleStatuses);
+    writeOutputs(irrPairProfile, anchoredIrrProfile, outputs);
 }
 
-void writeMultisampleProfile(
-    const ReferenceContigInfo& contigInfo, const string& outputPath,
-    const MultisampleAnchoredIrrProfile& anchoredIrrProfile, const MultisampleIrrPairProfile& pairedIrrProfile,
-    const SampleIdToSampleParameters& parametersForSamples)
+// Keeps only IRR pair counts and sample parameters in memory; anchored IRR regions are merged out of core
+static void runExternalMerge(
+    const MergeWorkflowParameters& parameters, const ReferenceContigInfo& contigInfo, const Manifest& manifest,
+    ParallelSampleProfileLoader& profileLoader, MultisampleAnchoredIrrProfile& baseAnchoredIrrProfile,
+    MultisampleIrrPairProfile& irrPairProfile, SampleIdToSampleParameters& parametersForSamples,
+    SampleIdToSampleStatus& sampleStatuses)
 {
-    Json countsRecord;
-    for (const auto& motifAndRecord : pairedIrrProfile)
-    {
-        const string& motif = motifAndRecord.first;
-        const auto& record = motifAndRecord.second;
-        for (const auto& sampleIdAndCount : record)
-        {
-            const string& sampleId = sampleIdAndCount.first;
-            int count = sampleIdAndCount.second;
-            countsRecord[motif]["IrrPairCounts"][sampleId] = count;
-        }
-    }
+    SpilledAnchoredIrrProfile anchoredIrrProfile(parameters.pathToSpilledRunPrefix(), parameters.memoryBudget());
+    anchoredIrrProfile.add(baseAnchoredIrrProfile);
+    baseAnchoredIrrProfile.clear();
 
-    for (const auto& motifAndRecord : anchoredIrrProfile)
+    for (const auto& sampleInfo : manifest)
     {
-        const string& motif = motifAndRecord.first;
-        const auto& record = motifAndRecord.second;
-        for (const auto& regionWithSampleCounts : record)
-        {
-            const auto& regionEncoding = regionWithSampleCounts.asString(contigInfo);
-            for (const auto& sampleIdAndCount : regionWithSampleCounts.feature().value())
-            {
-                const auto& sampleId = sampleIdAndCount.first;
-                int count = sampleIdAndCount.second;
-                countsRecord[motif]["RegionsWithIrrAnchors"][regionEncoding][sampleId] = count;
-            }
-        }
+        spdlog::info("Loading STR profile of {}", sampleInfo.sample);
+        auto sampleProfile = profileLoader.next();
+        anchoredIrrProfile.add(sampleProfile->anchoredIrrProfile);
+        addSampleSummary(sampleInfo, *sampleProfile, irrPairProfile, parametersForSamples, sampleStatuses);
     }
 
-    Json parametersRecord;
-    for (const auto& sampleIdAndParameters : parametersForSamples)
+    vector<Motif> irrPairMotifs;
+    for (const auto& motifAndCounts : irrPairProfile)
     {
-        const auto& sampleId = sampleIdAndParameters.first;
-        const auto& parameters = sampleIdAndParameters.second;
-        parametersRecord["ReadLengths"][sampleId] = parameters.readLength;
-        parametersRecord["Depths"][sampleId] = parameters.depth;
+        irrPairMotifs.push_back(motifAndCounts.first);
     }
+    std::sort(irrPairMotifs.begin(), irrPairMotifs.end());
+
+    spdlog::info("Merging regions with anchored IRRs");
+    MergeOutputs outputs(parameters, contigInfo, parametersForSamples, sampleStatuses);
+    auto irrPairMotif = irrPairMotifs.begin();
+    anchoredIrrProfile.merge([&](const Motif& motif, const vector<RegionWithSampleCount>& regions) {
+        for (; irrPairMotif != irrPairMotifs.end() && *irrPairMotif < motif; ++irrPairMotif)
+        {
+            outputs.addMotif(*irrPairMotif, &irrPairProfile.at(*irrPairMotif), nullptr);
+        }
 
-    Json multisampleProfile;
-    multisampleProfile["Counts"] = countsRecord;
-    multisampleProfile["Parameters"] = parametersRecord;
+        const SampleToIrrPairCount* irrPairCounts = nullptr;
+        if (irrPairMotif != irrPairMotifs.end() && *irrPairMotif == motif)
+        {
+            irrPairCounts = &irrPairProfile.at(*irrPairMotif++);
+        }
+        outputs.addMotif(motif, irrPairCounts, &regions);
+    });
 
-    std::ofstream outputFile(outputPath);
-    if (!outputFile)
+    for (; irrPairMotif != irrPairMotifs.end(); ++irrPairMotif)
     {
-        throw std::logic_error("Unable to write to " + outputPath);
+        outputs.addMotif(*irrPairMotif, &irrPairProfile.at(*irrPairMotif), nullptr);
     }
-    outputFile << multisampleProfile.dump(4);
+    outputs.finish();
 }
 
 int runMergeWorkflow(const MergeWorkflowParameters& parameters)
@@ -271,27 +375,61 @@ int runMergeWorkflow(const MergeWorkflowParameters& parameters)
     MultisampleAnchoredIrrProfile anchoredIrrProfile;
     MultisampleIrrPairProfile irrPairProfile;
     SampleIdToSampleParameters parametersForSamples;
+    SampleIdToSampleStatus sampleStatuses;
 
-    int sampleCount = 0;
-    int kNormalizationStride = 50;
-    for (const auto& sampleInfo : manifest)
+    std::shared_ptr<const TargetRegionIndex> targetRegions;
+    if (!parameters.pathToTargetRegions().empty())
     {
-        spdlog::info("Loading STR profile of {}", sampleInfo.sample);
-        loadSampleProfile(
-            sampleInfo, contigInfo, anchoredIrrProfile, irrPairProfile, parametersForSamples,
-            parameters.shortestUnitToConsider(), parameters.longestUnitToConsider());
-        sampleCount++;
+        targetRegions = std::make_shared<const TargetRegionIndex>(
+            loadTargetRegionIndex(parameters.pathToTargetRegions(), contigInfo));
+        spdlog::info("Restricting regions to {} target intervals", targetRegions->numIntervals());
+    }
 
-        if (sampleCount % kNormalizationStride == 0)
-        {
-            spdlog::info("Normalizing after loading sample #{}", sampleCount);
-            normalize(anchoredIrrProfile);
-        }
+    if (!parameters.pathToBaseProfile().empty())
+    {
+        spdlog::info("Loading multisample profile {}", parameters.pathToBaseProfile());
+        loadMultisampleProfile(
+            parameters.pathToBaseProfile(), contigInfo, parameters.shortestUnitToConsider(),
+            parameters.longestUnitToConsider(), targetRegions.get(), anchoredIrrProfile, irrPairProfile,
+            parametersForSamples);
+        spdlog::info("Multisample profile contains {} samples", parametersForSamples.size());
+
+        // Samples that are already part of the multisample profile are not loaded again
+        const auto isMerged = [&parametersForSamples, &sampleStatuses](const ManifestEntry& sampleInfo) {
+            if (parametersForSamples.find(sampleInfo.sample) == parametersForSamples.end())
+            {
+                return false;
+            }
+            sampleStatuses.emplace(sampleInfo.sample, sampleInfo.status);
+            return true;
+        };
+        const size_t originalManifestSize = manifest.size();
+        manifest.erase(std::remove_if(manifest.begin(), manifest.end(), isMerged), manifest.end());
+        const size_t numSkippedSamples = originalManifestSize - manifest.size();
+        spdlog::info("Skipping {} samples already present in multisample profile", numSkippedSamples);
     }
-    normalize(anchoredIrrProfile);
 
-    writeMultisampleProfile(
-        contigInfo, parameters.pathToMultisampleProfile(), anchoredIrrProfile, irrPairProfile, parametersForSamples);
+    const ProfileLoadingParameters loadingParameters(
+        parameters.shortestUnitToConsider(), parameters.longestUnitToConsider(), parameters.useBins(), targetRegions);
+    ParallelSampleProfileLoader profileLoader(manifest, contigInfo, loadingParameters, parameters.threadCount());
+
+    if (parameters.useBins())
+    {
+        runBinnedMerge(
+            parameters, contigInfo, manifest, profileLoader, irrPairProfile, parametersForSamples, sampleStatuses);
+    }
+    else if (parameters.memoryBudget() == 0)
+    {
+        runInMemoryMerge(
+            parameters, contigInfo, manifest, profileLoader, anchoredIrrProfile, irrPairProfile, parametersForSamples,
+            sampleStatuses);
+    }
+    else
+    {
+        runExternalMerge(
+            parameters, contigInfo, manifest, profileLoader, anchoredIrrProfile, irrPairProfile, parametersForSamples,
+            sampleStatuses);
+    }
 
     spdlog::info("Done");
     return 0;
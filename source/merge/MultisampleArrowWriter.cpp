@@ -0,0 +1,163 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MultisampleArrowWriter.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+static const char kIrrPairRecord[] = "irr_pairs";
+static const char kAnchoredIrrRecord[] = "anchored_irrs";
+
+MultisampleArrowWriter::MultisampleArrowWriter(
+    const ReferenceContigInfo& contigInfo, const SampleIdToSampleParameters& parametersForSamples,
+    const string& pathToSampleTable, const string& pathToLocusTable, const string& pathToCountTable)
+    : contigInfo_(contigInfo)
+    , sampleTable_(
+          pathToSampleTable,
+          { { "sample", ArrowType::kUtf8 }, { "read_length", ArrowType::kInt32 }, { "depth", ArrowType::kFloat64 } })
+    , locusTable_(
+          pathToLocusTable,
+          { { "motif", ArrowType::kUtf8 },
+            { "record", ArrowType::kUtf8 },
+            { "contig", ArrowType::kUtf8, true },
+            { "start", ArrowType::kInt64, true },
+            { "end", ArrowType::kInt64, true },
+            { "counts_offset", ArrowType::kInt64 },
+            { "num_counts", ArrowType::kInt32 } })
+    , countTable_(
+          pathToCountTable,
+          { { "locus", ArrowType::kInt32 }, { "sample", ArrowType::kInt32 }, { "count", ArrowType::kInt32 } })
+{
+    vector<const SampleId*> sampleIds;
+    for (const auto& sampleIdAndParameters : parametersForSamples)
+    {
+        sampleIds.push_back(&sampleIdAndParameters.first);
+    }
+    std::sort(sampleIds.begin(), sampleIds.end(), [](const SampleId* left, const SampleId* right) {
+        return *left < *right;
+    });
+
+    for (const SampleId* sampleId : sampleIds)
+    {
+        const SampleParameters& parameters = parametersForSamples.at(*sampleId);
+        sampleIndexes_.emplace(*sampleId, static_cast<int32_t>(sampleIndexes_.size()));
+        sampleTable_.appendUtf8(*sampleId);
+        sampleTable_.appendInt32(parameters.readLength);
+        sampleTable_.appendFloat64(parameters.depth);
+    }
+}
+
+void MultisampleArrowWriter::addLocus(
+    const Motif& motif, const RegionWithSampleCount* region, const SampleToIrrPairCount& sampleCounts)
+{
+    vector<pair<int32_t, int32_t>> counts;
+    counts.reserve(sampleCounts.size());
+    for (const auto& sampleIdAndCount : sampleCounts)
+    {
+        const auto sampleIdAndIndex = sampleIndexes_.find(sampleIdAndCount.first);
+        if (sampleIdAndIndex == sampleIndexes_.end())
+        {
+            throw std::logic_error("Parameters of sample " + sampleIdAndCount.first + " are missing");
+        }
+        counts.emplace_back(sampleIdAndIndex->second, sampleIdAndCount.second);
+    }
+    std::sort(counts.begin(), counts.end());
+
+    locusTable_.appendUtf8(motif);
+    locusTable_.appendUtf8(region ? kAnchoredIrrRecord : kIrrPairRecord);
+    if (region && region->contigId() != -1)
+    {
+        locusTable_.appendUtf8(contigInfo_.getContigName(region->contigId()));
+        locusTable_.appendInt64(region->start());
+        locusTable_.appendInt64(region->end());
+    }
+    else
+    {
+        locusTable_.appendNull();
+        locusTable_.appendNull();
+        locusTable_.appendNull();
+    }
+    locusTable_.appendInt64(numCounts_);
+    locusTable_.appendInt32(static_cast<int32_t>(counts.size()));
+
+    for (const auto& sampleIndexAndCount : counts)
+    {
+        countTable_.appendInt32(numLoci_);
+        countTable_.appendInt32(sampleIndexAndCount.first);
+        countTable_.appendInt32(sampleIndexAndCount.second);
+    }
+
+    ++numLoci_;
+    numCounts_ += counts.size();
+}
+
+void MultisampleArrowWriter::addMotif(
+    const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+    const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
+{
+    const bool hasIrrPairCounts = irrPairCounts && !irrPairCounts->empty();
+    const bool hasRegionsWithIrrAnchors = regionsWithIrrAnchors && !regionsWithIrrAnchors->empty();
+    if (!hasIrrPairCounts && !hasRegionsWithIrrAnchors)
+    {
+        return;
+    }
+
+    if (numLoci_ != 0 && !(lastMotif_ < motif))
+    {
+        throw std::logic_error("Motif " + motif + " is out of order in Arrow tables");
+    }
+    lastMotif_ = motif;
+
+    if (hasIrrPairCounts)
+    {
+        addLocus(motif, nullptr, *irrPairCounts);
+    }
+
+    if (hasRegionsWithIrrAnchors)
+    {
+        vector<const RegionWithSampleCount*> regions;
+        for (const auto& region : *regionsWithIrrAnchors)
+        {
+            regions.push_back(&region);
+        }
+        std::sort(
+            regions.begin(), regions.end(),
+            [](const RegionWithSampleCount* left, const RegionWithSampleCount* right) { return *left < *right; });
+
+        for (const auto* region : regions)
+        {
+            addLocus(motif, region, region->feature().value());
+        }
+    }
+}
+
+void MultisampleArrowWriter::finish()
+{
+    sampleTable_.finish();
+    locusTable_.finish();
+    countTable_.finish();
+}
@@ -0,0 +1,65 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "io/ArrowFileWriter.hh"
+#include "merge/MultisampleProfile.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Writes the merged counts as a sparse sample-by-locus matrix in three Arrow IPC files:
+//
+//   - samples: sample id, read length, and depth of each sample ordered by sample id; the row of a sample is its index,
+//   - loci: motif, record type, region, and the range of rows of the locus in the count table; loci of a motif start
+//     with the IRR pair counts (no region) followed by regions with anchored IRRs (no contig if unaligned),
+//   - counts: (locus index, sample index, count) triplets ordered by locus and sample, so the loci table doubles as the
+//     row pointer array of the matrix in CSR format.
+//
+// Motifs must be added in lexicographic order.
+class MultisampleArrowWriter
+{
+public:
+    MultisampleArrowWriter(
+        const ReferenceContigInfo& contigInfo, const SampleIdToSampleParameters& parametersForSamples,
+        const std::string& pathToSampleTable, const std::string& pathToLocusTable, const std::string& pathToCountTable);
+
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const std::vector<RegionWithSampleCount>* regionsWithIrrAnchors);
+    void finish();
+
+private:
+    void addLocus(const Motif& motif, const RegionWithSampleCount* region, const SampleToIrrPairCount& sampleCounts);
+
+    const ReferenceContigInfo& contigInfo_;
+    std::unordered_map<SampleId, int32_t> sampleIndexes_;
+    ArrowFileWriter sampleTable_;
+    ArrowFileWriter locusTable_;
+    ArrowFileWriter countTable_;
+    int32_t numLoci_ = 0;
+    int64_t numCounts_ = 0;
+    Motif lastMotif_;
+};
@@ -21,6 +21,8 @@
 
 #include "merge/MultisampleProfile.hh"
 
+#include <iterator>
+
 using std::vector;
 
 void normalize(MultisampleAnchoredIrrProfile& profile)
@@ -31,6 +33,18 @@ void normalize(MultisampleAnchoredIrrProfile& profile)
     }
 }
 
+void addAnchoredIrrProfile(
+    MultisampleAnchoredIrrProfile& sampleProfile, MultisampleAnchoredIrrProfile& anchoredIrrProfile)
+{
+    for (auto& motifAndRegions : sampleProfile)
+    {
+        auto& regions = anchoredIrrProfile[motifAndRegions.first];
+        regions.insert(
+            regions.end(), std::make_move_iterator(motifAndRegions.second.begin()),
+            std::make_move_iterator(motifAndRegions.second.end()));
+    }
+}
+
 void add(
     const SampleId& sampleId, const Motif& motif, const GenomicRegion& region, int numAnchoredIrrs,
     MultisampleAnchoredIrrProfile& profile)
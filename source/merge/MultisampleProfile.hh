@@ -23,6 +23,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "region/GenomicRegion.hh"
 
@@ -33,7 +34,23 @@ using SampleToIrrPairCount = std::unordered_map<SampleId, int>;
 using MultisampleIrrPairProfile = std::unordered_map<Motif, SampleToIrrPairCount>;
 using MultisampleAnchoredIrrProfile = std::unordered_map<Motif, std::vector<RegionWithSampleCount>>;
 
+struct SampleParameters
+{
+    SampleParameters(int readLength, double depth)
+        : readLength(readLength)
+        , depth(depth)
+    {
+    }
+    int readLength;
+    double depth;
+};
+using SampleIdToSampleParameters = std::unordered_map<SampleId, SampleParameters>;
+
 void normalize(MultisampleAnchoredIrrProfile& profile);
+// Moves the regions of a sample profile to the end of the regions of the same motifs; the profile needs to be
+// normalized afterwards
+void addAnchoredIrrProfile(
+    MultisampleAnchoredIrrProfile& sampleProfile, MultisampleAnchoredIrrProfile& anchoredIrrProfile);
 void add(
     const SampleId& sampleId, const Motif& motif, const GenomicRegion& region, int numAnchoredIrrs,
     MultisampleAnchoredIrrProfile& profile);
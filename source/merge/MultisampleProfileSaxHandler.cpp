@@ -0,0 +1,237 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MultisampleProfileSaxHandler.hh"
+
+#include <stdexcept>
+#include <utility>
+
+using std::string;
+
+MultisampleProfileSaxHandler::MultisampleProfileSaxHandler(
+    const ReferenceContigInfo& contigInfo, std::string path, int shortestUnit, int longestUnit,
+    const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& pairedIrrProfile)
+    : regionDecoder_(contigInfo)
+    , path_(std::move(path))
+    , shortestUnit_(shortestUnit)
+    , longestUnit_(longestUnit)
+    , targetRegions_(targetRegions)
+    , anchoredIrrProfile_(anchoredIrrProfile)
+    , pairedIrrProfile_(pairedIrrProfile)
+{
+    levels_.push_back(Level::kDocument);
+}
+
+SampleIdToSampleParameters MultisampleProfileSaxHandler::parametersForSamples() const
+{
+    if (readLengths_.size() != depths_.size())
+    {
+        throw std::runtime_error("Read lengths and depths of " + path_ + " describe different samples");
+    }
+
+    SampleIdToSampleParameters parametersForSamples;
+    for (const auto& sampleIdAndReadLength : readLengths_)
+    {
+        const auto sampleIdAndDepth = depths_.find(sampleIdAndReadLength.first);
+        if (sampleIdAndDepth == depths_.end())
+        {
+            throw std::runtime_error("Depth of " + sampleIdAndReadLength.first + " is missing from " + path_);
+        }
+
+        parametersForSamples.emplace(
+            sampleIdAndReadLength.first, SampleParameters(sampleIdAndReadLength.second, sampleIdAndDepth->second));
+    }
+
+    return parametersForSamples;
+}
+
+bool MultisampleProfileSaxHandler::null() { return true; }
+bool MultisampleProfileSaxHandler::boolean(bool) { return true; }
+bool MultisampleProfileSaxHandler::string(string_t&) { return true; }
+
+bool MultisampleProfileSaxHandler::number_integer(number_integer_t value) { return handleNumber(value); }
+bool MultisampleProfileSaxHandler::number_unsigned(number_unsigned_t value) { return handleNumber(value); }
+bool MultisampleProfileSaxHandler::number_float(number_float_t value, const string_t&) { return handleNumber(value); }
+
+bool MultisampleProfileSaxHandler::handleNumber(double value)
+{
+    if (numSkippedLevels_ != 0)
+    {
+        return true;
+    }
+
+    switch (levels_.back())
+    {
+    case Level::kIrrPairCounts:
+        pairedIrrProfile_[motif_][key_] = static_cast<int>(value);
+        break;
+    case Level::kRegionCounts:
+        regionCounts_[key_] = static_cast<int>(value);
+        break;
+    case Level::kReadLengths:
+        readLengths_[key_] = static_cast<int>(value);
+        break;
+    case Level::kDepths:
+        depths_[key_] = value;
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+// Determines the level of an object that starts after the most recent key; objects without a level are skipped
+MultisampleProfileSaxHandler::Level MultisampleProfileSaxHandler::getNestedLevel() const
+{
+    switch (levels_.back())
+    {
+    case Level::kDocument:
+        return Level::kProfile;
+    case Level::kProfile:
+        if (key_ == "Counts")
+        {
+            return Level::kCounts;
+        }
+        if (key_ == "Parameters")
+        {
+            return Level::kParameters;
+        }
+        break;
+    case Level::kCounts:
+        if (shortestUnit_ <= key_.length() && key_.length() <= longestUnit_)
+        {
+            return Level::kMotifRecord;
+        }
+        break;
+    case Level::kMotifRecord:
+        if (key_ == "IrrPairCounts")
+        {
+            return Level::kIrrPairCounts;
+        }
+        if (key_ == "RegionsWithIrrAnchors")
+        {
+            return Level::kRegions;
+        }
+        break;
+    case Level::kRegions:
+        return Level::kRegionCounts;
+    case Level::kParameters:
+        if (key_ == "Depths")
+        {
+            return Level::kDepths;
+        }
+        if (key_ == "ReadLengths")
+        {
+            return Level::kReadLengths;
+        }
+        break;
+    default:
+        throw std::runtime_error("Unexpected object in multisample profile " + path_);
+    }
+
+    return levels_.back();
+}
+
+bool MultisampleProfileSaxHandler::start_object(std::size_t)
+{
+    if (numSkippedLevels_ != 0)
+    {
+        ++numSkippedLevels_;
+        return true;
+    }
+
+    const Level level = getNestedLevel();
+    if (level == levels_.back())
+    {
+        numSkippedLevels_ = 1;
+        return true;
+    }
+
+    if (level == Level::kMotifRecord)
+    {
+        motif_ = key_;
+    }
+    else if (level == Level::kRegionCounts)
+    {
+        region_ = regionDecoder_.decode(key_);
+        regionCounts_.clear();
+    }
+
+    levels_.push_back(level);
+    return true;
+}
+
+bool MultisampleProfileSaxHandler::key(string_t& value)
+{
+    if (numSkippedLevels_ == 0)
+    {
+        key_ = value;
+    }
+
+    return true;
+}
+
+bool MultisampleProfileSaxHandler::end_object()
+{
+    if (numSkippedLevels_ != 0)
+    {
+        --numSkippedLevels_;
+        return true;
+    }
+
+    if (levels_.back() == Level::kRegionCounts && !regionCounts_.empty())
+    {
+        if (!targetRegions_ || targetRegions_->overlaps(region_))
+        {
+            anchoredIrrProfile_[motif_].emplace_back(
+                region_.contigId(), region_.start(), region_.end(), SampleCountFeature(std::move(regionCounts_)));
+        }
+        regionCounts_.clear();
+    }
+
+    levels_.pop_back();
+    return true;
+}
+
+bool MultisampleProfileSaxHandler::start_array(std::size_t)
+{
+    if (numSkippedLevels_ == 0 && levels_.back() == Level::kDocument)
+    {
+        throw std::runtime_error("Multisample profile " + path_ + " is not a JSON object");
+    }
+
+    ++numSkippedLevels_;
+    return true;
+}
+
+bool MultisampleProfileSaxHandler::end_array()
+{
+    --numSkippedLevels_;
+    return true;
+}
+
+bool MultisampleProfileSaxHandler::parse_error(
+    std::size_t, const std::string&, const nlohmann::detail::exception& exception)
+{
+    throw std::runtime_error("Unable to parse multisample profile " + path_ + ": " + exception.what());
+}
@@ -0,0 +1,98 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "thirdparty/nlohmann_json/json.hpp"
+
+#include "merge/MultisampleProfile.hh"
+#include "merge/RegionDecoder.hh"
+#include "region/ReferenceContigInfo.hh"
+#include "region/TargetRegionIndex.hh"
+
+// Adds the content of a multisample profile produced by the merge workflow to multisample profiles while the
+// profile is parsed. Records of motifs with lengths outside of the target range are skipped, as are regions that do
+// not overlap the target regions if these are given.
+class MultisampleProfileSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    MultisampleProfileSaxHandler(
+        const ReferenceContigInfo& contigInfo, std::string path, int shortestUnit, int longestUnit,
+        const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+        MultisampleIrrPairProfile& pairedIrrProfile);
+
+    // Read lengths and depths of all samples; throws if either is missing for some sample
+    SampleIdToSampleParameters parametersForSamples() const;
+
+    bool null() override;
+    bool boolean(bool value) override;
+    bool number_integer(number_integer_t value) override;
+    bool number_unsigned(number_unsigned_t value) override;
+    bool number_float(number_float_t value, const string_t& encoding) override;
+    bool string(string_t& value) override;
+    bool start_object(std::size_t numElements) override;
+    bool key(string_t& value) override;
+    bool end_object() override;
+    bool start_array(std::size_t numElements) override;
+    bool end_array() override;
+    bool parse_error(
+        std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception) override;
+
+private:
+    enum class Level
+    {
+        kDocument,
+        kProfile,
+        kCounts,
+        kMotifRecord,
+        kIrrPairCounts,
+        kRegions,
+        kRegionCounts,
+        kParameters,
+        kDepths,
+        kReadLengths
+    };
+
+    bool handleNumber(double value);
+    Level getNestedLevel() const;
+
+    RegionDecoder regionDecoder_;
+    std::string path_;
+    int shortestUnit_;
+    int longestUnit_;
+    const TargetRegionIndex* targetRegions_;
+    MultisampleAnchoredIrrProfile& anchoredIrrProfile_;
+    MultisampleIrrPairProfile& pairedIrrProfile_;
+
+    std::vector<Level> levels_;
+    int numSkippedLevels_ = 0;
+    std::string key_;
+
+    Motif motif_;
+    GenomicRegion region_ = GenomicRegion(-1, 0, 0);
+    std::unordered_map<SampleId, int> regionCounts_;
+    std::unordered_map<SampleId, int> readLengths_;
+    std::unordered_map<SampleId, double> depths_;
+};
@@ -0,0 +1,166 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MultisampleProfileWriter.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+// Orders entries of a map by key as required by the JSON output
+template <typename Map> static vector<const typename Map::value_type*> sortByKey(const Map& map)
+{
+    using Entry = typename Map::value_type;
+    vector<const Entry*> entries;
+    entries.reserve(map.size());
+    for (const auto& entry : map)
+    {
+        entries.push_back(&entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry* left, const Entry* right) {
+        return left->first < right->first;
+    });
+    return entries;
+}
+
+static void writeSampleCounts(const unordered_map<SampleId, int>& sampleCounts, JsonStreamWriter& writer)
+{
+    writer.startObject();
+    for (const auto* sampleIdAndCount : sortByKey(sampleCounts))
+    {
+        writer.key(sampleIdAndCount->first);
+        writer.value(sampleIdAndCount->second);
+    }
+    writer.endObject();
+}
+
+MultisampleProfileWriter::MultisampleProfileWriter(const ReferenceContigInfo& contigInfo, std::ostream& out)
+    : contigInfo_(contigInfo)
+    , out_(out)
+    , writer_(out, 4)
+{
+    writer_.startObject();
+}
+
+void MultisampleProfileWriter::addMotif(
+    const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+    const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
+{
+    const bool hasIrrPairCounts = irrPairCounts && !irrPairCounts->empty();
+    const bool hasRegionsWithIrrAnchors = regionsWithIrrAnchors && !regionsWithIrrAnchors->empty();
+    if (!hasIrrPairCounts && !hasRegionsWithIrrAnchors)
+    {
+        return;
+    }
+
+    if (numMotifs_ != 0 && !(lastMotif_ < motif))
+    {
+        throw std::logic_error("Motif " + motif + " is out of order in multisample profile");
+    }
+
+    if (numMotifs_ == 0)
+    {
+        writer_.key("Counts");
+        writer_.startObject();
+    }
+    ++numMotifs_;
+    lastMotif_ = motif;
+
+    writer_.key(motif);
+    writer_.startObject();
+    if (hasIrrPairCounts)
+    {
+        writer_.key("IrrPairCounts");
+        writeSampleCounts(*irrPairCounts, writer_);
+    }
+
+    if (hasRegionsWithIrrAnchors)
+    {
+        vector<std::pair<string, const RegionWithSampleCount*>> encodedRegions;
+        encodedRegions.reserve(regionsWithIrrAnchors->size());
+        for (const auto& region : *regionsWithIrrAnchors)
+        {
+            encodedRegions.emplace_back(region.asString(contigInfo_), &region);
+        }
+        std::sort(encodedRegions.begin(), encodedRegions.end());
+
+        writer_.key("RegionsWithIrrAnchors");
+        writer_.startObject();
+        for (const auto& encodingAndRegion : encodedRegions)
+        {
+            writer_.key(encodingAndRegion.first);
+            writeSampleCounts(encodingAndRegion.second->feature().value(), writer_);
+        }
+        writer_.endObject();
+    }
+    writer_.endObject();
+}
+
+void MultisampleProfileWriter::finish(const SampleIdToSampleParameters& parametersForSamples)
+{
+    // Empty records are written as null to match the output of the original DOM-based writer
+    if (numMotifs_ == 0)
+    {
+        writer_.key("Counts");
+        writer_.null();
+    }
+    else
+    {
+        writer_.endObject();
+    }
+
+    writer_.key("Parameters");
+    if (parametersForSamples.empty())
+    {
+        writer_.null();
+    }
+    else
+    {
+        const auto sortedParameters = sortByKey(parametersForSamples);
+        writer_.startObject();
+        writer_.key("Depths");
+        writer_.startObject();
+        for (const auto* sampleIdAndParameters : sortedParameters)
+        {
+            writer_.key(sampleIdAndParameters->first);
+            writer_.value(sampleIdAndParameters->second.depth);
+        }
+        writer_.endObject();
+
+        writer_.key("ReadLengths");
+        writer_.startObject();
+        for (const auto* sampleIdAndParameters : sortedParameters)
+        {
+            writer_.key(sampleIdAndParameters->first);
+            writer_.value(sampleIdAndParameters->second.readLength);
+        }
+        writer_.endObject();
+        writer_.endObject();
+    }
+
+    writer_.endObject();
+    out_.flush();
+}
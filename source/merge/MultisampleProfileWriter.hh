@@ -0,0 +1,50 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/JsonStreamWriter.hh"
+#include "merge/MultisampleProfile.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Streams a multisample profile in JSON format; motifs must be added in lexicographic order
+class MultisampleProfileWriter
+{
+public:
+    MultisampleProfileWriter(const ReferenceContigInfo& contigInfo, std::ostream& out);
+
+    // Either of the records can be null; motifs without any counts are skipped
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const std::vector<RegionWithSampleCount>* regionsWithIrrAnchors);
+    void finish(const SampleIdToSampleParameters& parametersForSamples);
+
+private:
+    const ReferenceContigInfo& contigInfo_;
+    std::ostream& out_;
+    JsonStreamWriter writer_;
+    int numMotifs_ = 0;
+    Motif lastMotif_;
+};
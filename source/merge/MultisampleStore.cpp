@@ -0,0 +1,498 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MultisampleStore.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using std::pair;
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::vector;
+
+static const char kMagic[] = { 'E', 'H', 'D', 'N', 'M', 'S', 'S', 'T' };
+static const uint32_t kFormatVersion = 1;
+
+MultisampleStoreWriter::MultisampleStoreWriter(
+    const ReferenceContigInfo& contigInfo, const SampleIdToSampleParameters& parametersForSamples, const string& path)
+    : contigInfo_(contigInfo)
+    , path_(path)
+    , storeFile_(path, std::ios::binary)
+    , samples_(parametersForSamples.begin(), parametersForSamples.end())
+    , contigIndexes_(contigInfo.numContigs())
+    , maxRegionLengths_(contigInfo.numContigs(), 0)
+{
+    if (!storeFile_)
+    {
+        throw std::runtime_error("Unable to write to " + path);
+    }
+
+    using SampleAndParameters = pair<SampleId, SampleParameters>;
+    std::sort(samples_.begin(), samples_.end(), [](const SampleAndParameters& left, const SampleAndParameters& right) {
+        return left.first < right.first;
+    });
+    for (uint32_t sampleIndex = 0; sampleIndex != samples_.size(); ++sampleIndex)
+    {
+        sampleIndexes_.emplace(samples_[sampleIndex].first, sampleIndex);
+    }
+
+    // The header is written once the offsets of all sections are known
+    const StoreHeader header = {};
+    storeFile_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+uint64_t MultisampleStoreWriter::addString(const string& value)
+{
+    const uint64_t offset = stringPool_.size();
+    stringPool_ += value;
+    return offset;
+}
+
+uint32_t MultisampleStoreWriter::getSampleIndex(const SampleId& sampleId) const
+{
+    const auto sampleIdAndIndex = sampleIndexes_.find(sampleId);
+    if (sampleIdAndIndex == sampleIndexes_.end())
+    {
+        throw std::logic_error("Parameters of sample " + sampleId + " are missing");
+    }
+
+    return sampleIdAndIndex->second;
+}
+
+void MultisampleStoreWriter::writeCounts(const unordered_map<SampleId, int>& sampleCounts)
+{
+    vector<StoredCount> counts;
+    counts.reserve(sampleCounts.size());
+    for (const auto& sampleIdAndCount : sampleCounts)
+    {
+        counts.push_back({ getSampleIndex(sampleIdAndCount.first), sampleIdAndCount.second });
+    }
+
+    std::sort(counts.begin(), counts.end(), [](const StoredCount& left, const StoredCount& right) {
+        return left.sampleIndex < right.sampleIndex;
+    });
+    storeFile_.write(reinterpret_cast<const char*>(counts.data()), counts.size() * sizeof(StoredCount));
+}
+
+void MultisampleStoreWriter::align()
+{
+    static const char kPadding[8] = {};
+    const auto position = static_cast<uint64_t>(storeFile_.tellp());
+    storeFile_.write(kPadding, (8 - position % 8) % 8);
+}
+
+void MultisampleStoreWriter::addMotif(
+    const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+    const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
+{
+    const bool hasIrrPairCounts = irrPairCounts && !irrPairCounts->empty();
+    const bool hasRegionsWithIrrAnchors = regionsWithIrrAnchors && !regionsWithIrrAnchors->empty();
+    if (!hasIrrPairCounts && !hasRegionsWithIrrAnchors)
+    {
+        return;
+    }
+
+    if (!motifs_.empty() && !(lastMotif_ < motif))
+    {
+        throw std::logic_error("Motif " + motif + " is out of order in multisample store");
+    }
+    lastMotif_ = motif;
+
+    StoredMotif storedMotif = {};
+    storedMotif.nameOffset = addString(motif);
+    storedMotif.nameLength = motif.length();
+    storedMotif.irrPairCountsOffset = storeFile_.tellp();
+    if (hasIrrPairCounts)
+    {
+        storedMotif.numIrrPairCounts = irrPairCounts->size();
+        writeCounts(*irrPairCounts);
+    }
+
+    vector<const RegionWithSampleCount*> regions;
+    if (hasRegionsWithIrrAnchors)
+    {
+        for (const auto& region : *regionsWithIrrAnchors)
+        {
+            regions.push_back(&region);
+        }
+        std::sort(
+            regions.begin(), regions.end(),
+            [](const RegionWithSampleCount* left, const RegionWithSampleCount* right) { return *left < *right; });
+    }
+
+    const auto motifIndex = static_cast<uint32_t>(motifs_.size());
+    storedMotif.regionsOffset = storeFile_.tellp();
+    storedMotif.numRegions = regions.size();
+
+    uint64_t countsOffset = storedMotif.regionsOffset + regions.size() * sizeof(StoredRegion);
+    for (size_t regionIndex = 0; regionIndex != regions.size(); ++regionIndex)
+    {
+        const RegionWithSampleCount& region = *regions[regionIndex];
+        StoredRegion storedRegion = {};
+        storedRegion.contigId = region.contigId();
+        storedRegion.numCounts = region.feature().value().size();
+        storedRegion.start = region.start();
+        storedRegion.end = region.end();
+        storedRegion.countsOffset = countsOffset;
+        storeFile_.write(reinterpret_cast<const char*>(&storedRegion), sizeof(storedRegion));
+        countsOffset += storedRegion.numCounts * sizeof(StoredCount);
+
+        if (region.contigId() != -1)
+        {
+            const uint64_t regionOffset = storedMotif.regionsOffset + regionIndex * sizeof(StoredRegion);
+            contigIndexes_[region.contigId()].push_back({ region.start(), region.end(), motifIndex, 0, regionOffset });
+            maxRegionLengths_[region.contigId()]
+                = std::max(maxRegionLengths_[region.contigId()], region.end() - region.start());
+        }
+    }
+
+    for (const auto* region : regions)
+    {
+        writeCounts(region->feature().value());
+    }
+
+    motifs_.push_back(storedMotif);
+}
+
+void MultisampleStoreWriter::finish()
+{
+    StoreHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.numSamples = samples_.size();
+    header.numContigs = contigInfo_.numContigs();
+    header.numMotifs = motifs_.size();
+
+    vector<StoredContig> contigs;
+    for (int contigId = 0; contigId != contigInfo_.numContigs(); ++contigId)
+    {
+        auto& index = contigIndexes_[contigId];
+        std::sort(index.begin(), index.end(), [](const StoredIndexEntry& left, const StoredIndexEntry& right) {
+            return left.start < right.start;
+        });
+
+        align();
+        StoredContig contig = {};
+        const string& contigName = contigInfo_.getContigName(contigId);
+        contig.nameOffset = addString(contigName);
+        contig.nameLength = contigName.length();
+        contig.size = contigInfo_.getContigSize(contigId);
+        contig.indexOffset = storeFile_.tellp();
+        contig.numIndexEntries = index.size();
+        contig.maxRegionLength = maxRegionLengths_[contigId];
+        storeFile_.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(StoredIndexEntry));
+        contigs.push_back(contig);
+        vector<StoredIndexEntry>().swap(index);
+    }
+
+    vector<StoredSample> samples;
+    for (const auto& sampleIdAndParameters : samples_)
+    {
+        StoredSample sample = {};
+        sample.nameOffset = addString(sampleIdAndParameters.first);
+        sample.nameLength = sampleIdAndParameters.first.length();
+        sample.readLength = sampleIdAndParameters.second.readLength;
+        sample.depth = sampleIdAndParameters.second.depth;
+        samples.push_back(sample);
+    }
+
+    align();
+    header.sampleTableOffset = storeFile_.tellp();
+    storeFile_.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(StoredSample));
+    header.contigTableOffset = storeFile_.tellp();
+    storeFile_.write(reinterpret_cast<const char*>(contigs.data()), contigs.size() * sizeof(StoredContig));
+    header.motifTableOffset = storeFile_.tellp();
+    storeFile_.write(reinterpret_cast<const char*>(motifs_.data()), motifs_.size() * sizeof(StoredMotif));
+    header.stringPoolOffset = storeFile_.tellp();
+    header.stringPoolSize = stringPool_.size();
+    storeFile_.write(stringPool_.data(), stringPool_.size());
+
+    storeFile_.seekp(0);
+    storeFile_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    storeFile_.close();
+
+    if (!storeFile_)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+MultisampleStore::MultisampleStore(const string& path)
+    : path_(path)
+    , contigInfo_(vector<pair<string, int64_t>>())
+{
+    const int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1)
+    {
+        throw std::runtime_error("Unable to read " + path + " (" + strerror(errno) + ")");
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < static_cast<off_t>(sizeof(StoreHeader)))
+    {
+        close(fileDescriptor);
+        throw std::runtime_error(path + " is not a multisample store");
+    }
+
+    size_ = fileStatus.st_size;
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map " + path + " into memory (" + strerror(errno) + ")");
+    }
+    data_ = static_cast<const char*>(mapping);
+
+    try
+    {
+        header_ = getRecords<StoreHeader>(0, 1);
+        if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0)
+        {
+            throw std::runtime_error(path + " is not a multisample store");
+        }
+
+        if (header_->version != kFormatVersion)
+        {
+            throw std::runtime_error("Unsupported version of multisample store " + to_string(header_->version));
+        }
+
+        samples_ = getRecords<StoredSample>(header_->sampleTableOffset, header_->numSamples);
+        contigs_ = getRecords<StoredContig>(header_->contigTableOffset, header_->numContigs);
+        motifs_ = getRecords<StoredMotif>(header_->motifTableOffset, header_->numMotifs);
+        getRecords<char>(header_->stringPoolOffset, header_->stringPoolSize);
+
+        vector<pair<string, int64_t>> contigNamesAndSizes;
+        for (uint32_t contigIndex = 0; contigIndex != header_->numContigs; ++contigIndex)
+        {
+            const StoredContig& contig = contigs_[contigIndex];
+            contigNamesAndSizes.emplace_back(getString(contig.nameOffset, contig.nameLength), contig.size);
+        }
+        contigInfo_ = ReferenceContigInfo(std::move(contigNamesAndSizes));
+    }
+    catch (...)
+    {
+        munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+MultisampleStore::~MultisampleStore() { munmap(const_cast<char*>(data_), size_); }
+
+template <typename T> const T* MultisampleStore::getRecords(uint64_t offset, uint64_t numRecords) const
+{
+    if (offset > size_ || numRecords > (size_ - offset) / sizeof(T) || offset % alignof(T) != 0)
+    {
+        throw std::runtime_error("Multisample store " + path_ + " is corrupted");
+    }
+
+    return reinterpret_cast<const T*>(data_ + offset);
+}
+
+string MultisampleStore::getString(uint64_t offset, uint32_t length) const
+{
+    if (offset > header_->stringPoolSize || length > header_->stringPoolSize - offset)
+    {
+        throw std::runtime_error("Multisample store " + path_ + " is corrupted");
+    }
+
+    return string(data_ + header_->stringPoolOffset + offset, length);
+}
+
+// Counts refer to samples by index, so an index outside of the sample table means that the store is corrupted
+const StoredCount* MultisampleStore::getCounts(uint64_t offset, uint32_t numCounts) const
+{
+    const StoredCount* counts = getRecords<StoredCount>(offset, numCounts);
+    for (uint32_t countIndex = 0; countIndex != numCounts; ++countIndex)
+    {
+        if (counts[countIndex].sampleIndex >= header_->numSamples)
+        {
+            throw std::runtime_error("Multisample store " + path_ + " is corrupted");
+        }
+    }
+
+    return counts;
+}
+
+string MultisampleStore::sampleId(int sampleIndex) const
+{
+    const StoredSample& sample = samples_[sampleIndex];
+    return getString(sample.nameOffset, sample.nameLength);
+}
+
+SampleParameters MultisampleStore::sampleParameters(int sampleIndex) const
+{
+    const StoredSample& sample = samples_[sampleIndex];
+    return { sample.readLength, sample.depth };
+}
+
+int MultisampleStore::findSample(const SampleId& sampleId) const
+{
+    int first = 0;
+    int last = numSamples();
+    while (first < last)
+    {
+        const int middle = first + (last - first) / 2;
+        if (this->sampleId(middle) < sampleId)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first != numSamples() && this->sampleId(first) == sampleId ? first : -1;
+}
+
+Motif MultisampleStore::motif(int motifIndex) const
+{
+    const StoredMotif& motif = motifs_[motifIndex];
+    return getString(motif.nameOffset, motif.nameLength);
+}
+
+int MultisampleStore::findMotif(const Motif& motif) const
+{
+    int first = 0;
+    int last = numMotifs();
+    while (first < last)
+    {
+        const int middle = first + (last - first) / 2;
+        if (this->motif(middle) < motif)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first != numMotifs() && this->motif(first) == motif ? first : -1;
+}
+
+static bool isSelected(uint32_t sampleIndex, const vector<bool>& selectedSamples)
+{
+    return selectedSamples.empty() || selectedSamples[sampleIndex];
+}
+
+SampleToIrrPairCount MultisampleStore::getIrrPairCounts(int motifIndex, const vector<bool>& selectedSamples) const
+{
+    const StoredMotif& motif = motifs_[motifIndex];
+    const StoredCount* counts = getCounts(motif.irrPairCountsOffset, motif.numIrrPairCounts);
+
+    SampleToIrrPairCount irrPairCounts;
+    for (uint32_t countIndex = 0; countIndex != motif.numIrrPairCounts; ++countIndex)
+    {
+        if (isSelected(counts[countIndex].sampleIndex, selectedSamples))
+        {
+            irrPairCounts.emplace(sampleId(counts[countIndex].sampleIndex), counts[countIndex].count);
+        }
+    }
+
+    return irrPairCounts;
+}
+
+RegionWithSampleCount
+MultisampleStore::decodeRegion(const StoredRegion& region, const vector<bool>& selectedSamples) const
+{
+    const StoredCount* counts = getCounts(region.countsOffset, region.numCounts);
+
+    unordered_map<SampleId, int> sampleCounts;
+    for (uint32_t countIndex = 0; countIndex != region.numCounts; ++countIndex)
+    {
+        if (isSelected(counts[countIndex].sampleIndex, selectedSamples))
+        {
+            sampleCounts.emplace(sampleId(counts[countIndex].sampleIndex), counts[countIndex].count);
+        }
+    }
+
+    return { region.contigId, region.start, region.end, SampleCountFeature(std::move(sampleCounts)) };
+}
+
+vector<RegionWithSampleCount> MultisampleStore::getRegions(int motifIndex, const vector<bool>& selectedSamples) const
+{
+    const StoredMotif& motif = motifs_[motifIndex];
+    const StoredRegion* regions = getRecords<StoredRegion>(motif.regionsOffset, motif.numRegions);
+
+    vector<RegionWithSampleCount> decodedRegions;
+    for (uint64_t regionIndex = 0; regionIndex != motif.numRegions; ++regionIndex)
+    {
+        RegionWithSampleCount region = decodeRegion(regions[regionIndex], selectedSamples);
+        if (!region.feature().value().empty())
+        {
+            decodedRegions.push_back(std::move(region));
+        }
+    }
+
+    return decodedRegions;
+}
+
+vector<pair<int, RegionWithSampleCount>>
+MultisampleStore::getOverlappingRegions(const GenomicRegion& queryRegion, const vector<bool>& selectedSamples) const
+{
+    vector<pair<int, RegionWithSampleCount>> overlappingRegions;
+    if (queryRegion.contigId() < 0 || static_cast<uint32_t>(queryRegion.contigId()) >= header_->numContigs)
+    {
+        return overlappingRegions;
+    }
+
+    const StoredContig& contig = contigs_[queryRegion.contigId()];
+    const StoredIndexEntry* first = getRecords<StoredIndexEntry>(contig.indexOffset, contig.numIndexEntries);
+    const StoredIndexEntry* last = first + contig.numIndexEntries;
+
+    // No region starts further than the longest region on the contig away from an overlapping query
+    const int64_t minStart = queryRegion.start() - contig.maxRegionLength;
+    auto entry = std::lower_bound(first, last, minStart, [](const StoredIndexEntry& entry, int64_t start) {
+        return entry.start < start;
+    });
+
+    for (; entry != last && entry->start <= queryRegion.end(); ++entry)
+    {
+        if (entry->end < queryRegion.start())
+        {
+            continue;
+        }
+
+        if (entry->motifIndex >= header_->numMotifs)
+        {
+            throw std::runtime_error("Multisample store " + path_ + " is corrupted");
+        }
+
+        const StoredRegion& region = *getRecords<StoredRegion>(entry->regionOffset, 1);
+        RegionWithSampleCount decodedRegion = decodeRegion(region, selectedSamples);
+        if (!decodedRegion.feature().value().empty())
+        {
+            overlappingRegions.emplace_back(entry->motifIndex, std::move(decodedRegion));
+        }
+    }
+
+    return overlappingRegions;
+}
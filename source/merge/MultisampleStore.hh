@@ -0,0 +1,188 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Binary multisample store designed to be memory-mapped and queried without reading the whole file. All sections
+// consist of fixed-size little-endian records aligned to eight bytes:
+//
+//   - a header with the magic string, format version, section sizes, and section offsets,
+//   - a sample table with read lengths and depths of all samples sorted by sample id,
+//   - a contig table locating the region index of each contig,
+//   - a motif table sorted by motif locating IRR pair counts and regions of each motif,
+//   - per-motif blocks of regions sorted by position, each followed by sparse blocks of (sample, count) pairs,
+//   - a per-contig region index sorted by region start that refers to the regions of all motifs,
+//   - a pool of the strings referenced from the tables.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "merge/MultisampleProfile.hh"
+#include "region/GenomicRegion.hh"
+#include "region/ReferenceContigInfo.hh"
+
+struct StoreHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numSamples;
+    uint32_t numContigs;
+    uint32_t numMotifs;
+    uint64_t sampleTableOffset;
+    uint64_t contigTableOffset;
+    uint64_t motifTableOffset;
+    uint64_t stringPoolOffset;
+    uint64_t stringPoolSize;
+};
+
+struct StoredSample
+{
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    int32_t readLength;
+    double depth;
+};
+
+struct StoredContig
+{
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    uint32_t padding;
+    int64_t size;
+    uint64_t indexOffset;
+    uint64_t numIndexEntries;
+    int64_t maxRegionLength;
+};
+
+struct StoredMotif
+{
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    uint32_t numIrrPairCounts;
+    uint64_t irrPairCountsOffset;
+    uint64_t regionsOffset;
+    uint64_t numRegions;
+};
+
+struct StoredRegion
+{
+    int32_t contigId;
+    uint32_t numCounts;
+    int64_t start;
+    int64_t end;
+    uint64_t countsOffset;
+};
+
+struct StoredCount
+{
+    uint32_t sampleIndex;
+    int32_t count;
+};
+
+struct StoredIndexEntry
+{
+    int64_t start;
+    int64_t end;
+    uint32_t motifIndex;
+    uint32_t padding;
+    uint64_t regionOffset;
+};
+
+// Writes a multisample store; motifs must be added in lexicographic order
+class MultisampleStoreWriter
+{
+public:
+    MultisampleStoreWriter(
+        const ReferenceContigInfo& contigInfo, const SampleIdToSampleParameters& parametersForSamples,
+        const std::string& path);
+
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const std::vector<RegionWithSampleCount>* regionsWithIrrAnchors);
+    void finish();
+
+private:
+    uint64_t addString(const std::string& value);
+    uint32_t getSampleIndex(const SampleId& sampleId) const;
+    void writeCounts(const std::unordered_map<SampleId, int>& sampleCounts);
+    void align();
+
+    const ReferenceContigInfo& contigInfo_;
+    std::string path_;
+    std::ofstream storeFile_;
+    std::vector<std::pair<SampleId, SampleParameters>> samples_;
+    std::unordered_map<SampleId, uint32_t> sampleIndexes_;
+    std::vector<StoredMotif> motifs_;
+    Motif lastMotif_;
+    std::vector<std::vector<StoredIndexEntry>> contigIndexes_;
+    std::vector<int64_t> maxRegionLengths_;
+    std::string stringPool_;
+};
+
+// Read-only view of a memory-mapped multisample store
+class MultisampleStore
+{
+public:
+    explicit MultisampleStore(const std::string& path);
+    ~MultisampleStore();
+
+    MultisampleStore(const MultisampleStore&) = delete;
+    MultisampleStore& operator=(const MultisampleStore&) = delete;
+
+    const ReferenceContigInfo& contigInfo() const { return contigInfo_; }
+
+    int numSamples() const { return header_->numSamples; }
+    std::string sampleId(int sampleIndex) const;
+    SampleParameters sampleParameters(int sampleIndex) const;
+    // Returns -1 if the store does not contain the sample
+    int findSample(const SampleId& sampleId) const;
+
+    int numMotifs() const { return header_->numMotifs; }
+    Motif motif(int motifIndex) const;
+    // Returns -1 if the store does not contain the motif
+    int findMotif(const Motif& motif) const;
+
+    // Sample selections are indexed by sample index; an empty selection includes all samples
+    SampleToIrrPairCount getIrrPairCounts(int motifIndex, const std::vector<bool>& selectedSamples) const;
+    std::vector<RegionWithSampleCount> getRegions(int motifIndex, const std::vector<bool>& selectedSamples) const;
+    // Returns regions of all motifs that overlap the query region as (motif index, region) pairs
+    std::vector<std::pair<int, RegionWithSampleCount>>
+    getOverlappingRegions(const GenomicRegion& queryRegion, const std::vector<bool>& selectedSamples) const;
+
+private:
+    template <typename T> const T* getRecords(uint64_t offset, uint64_t numRecords) const;
+    std::string getString(uint64_t offset, uint32_t length) const;
+    const StoredCount* getCounts(uint64_t offset, uint32_t numCounts) const;
+    RegionWithSampleCount decodeRegion(const StoredRegion& region, const std::vector<bool>& selectedSamples) const;
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const StoreHeader* header_ = nullptr;
+    const StoredSample* samples_ = nullptr;
+    const StoredContig* contigs_ = nullptr;
+    const StoredMotif* motifs_ = nullptr;
+    ReferenceContigInfo contigInfo_;
+};
@@ -0,0 +1,333 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/OutlierAnalysis.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "thirdparty/spdlog/fmt/fmt.h"
+
+#include "common/ParallelWork.hh"
+
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+static const uint64_t kSeed = 42;
+static const size_t kRowsPerBatch = 4096;
+
+static uint64_t splitMix(uint64_t& state)
+{
+    uint64_t value = (state += 0x9e3779b97f4a7c15ULL);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+// xoshiro256** generator; each row gets its own generator so that the results do not depend on the thread count
+class FastRandomGenerator
+{
+public:
+    using result_type = uint64_t;
+
+    explicit FastRandomGenerator(uint64_t seed)
+    {
+        for (auto& word : state_)
+        {
+            word = splitMix(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()()
+    {
+        const uint64_t result = rotate(state_[1] * 5, 7) * 9;
+        const uint64_t shifted = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= shifted;
+        state_[3] = rotate(state_[3], 45);
+        return result;
+    }
+
+    // Returns a uniformly distributed integer from [0, bound)
+    uint32_t below(uint32_t bound) { return static_cast<uint32_t>(((operator()() >> 32) * bound) >> 32); }
+
+private:
+    static uint64_t rotate(uint64_t value, int shift) { return (value << shift) | (value >> (64 - shift)); }
+
+    uint64_t state_[4];
+};
+
+OutlierScorer::OutlierScorer(vector<bool> isCase, int numResamples, double quantile)
+    : isCase_(std::move(isCase))
+    , numResamples_(numResamples)
+    , quantile_(quantile)
+{
+}
+
+// Resamples are drawn in two steps: the number of draws that hit samples with nonzero counts is binomial and only
+// those draws are materialized, so sparse rows are scored in time proportional to their nonzero counts
+OutlierScore OutlierScorer::score(const vector<pair<int, double>>& counts, uint64_t seed)
+{
+    const int cohortSize = static_cast<int>(isCase_.size());
+    nonzeroCounts_.clear();
+    for (const auto& cohortIndexAndCount : counts)
+    {
+        if (cohortIndexAndCount.second != 0)
+        {
+            nonzeroCounts_.push_back(cohortIndexAndCount.second);
+        }
+    }
+
+    // Quantiles are interpolated linearly between the closest ranks as in numpy.quantile
+    const double position = (cohortSize - 1) * quantile_;
+    const int lowerRank = static_cast<int>(std::floor(position));
+    const int upperRank = std::min(lowerRank + 1, cohortSize - 1);
+    const double fraction = position - lowerRank;
+
+    FastRandomGenerator generator(seed);
+    const double nonzeroFraction = static_cast<double>(nonzeroCounts_.size()) / cohortSize;
+    std::binomial_distribution<int> numNonzeroDraws(cohortSize, nonzeroFraction);
+    const auto numNonzeroCounts = static_cast<uint32_t>(nonzeroCounts_.size());
+
+    vector<double> quantiles;
+    quantiles.reserve(numResamples_);
+    for (int resampleIndex = 0; resampleIndex != numResamples_; ++resampleIndex)
+    {
+        resample_.clear();
+        const int numDraws = numNonzeroCounts == 0 ? 0 : numNonzeroDraws(generator);
+        for (int drawIndex = 0; drawIndex != numDraws; ++drawIndex)
+        {
+            resample_.push_back(nonzeroCounts_[generator.below(numNonzeroCounts)]);
+        }
+
+        const int numZeroDraws = cohortSize - numDraws;
+        const auto getOrderStatistic = [this, numZeroDraws](int rank) {
+            if (rank < numZeroDraws)
+            {
+                return 0.0;
+            }
+            auto nth = resample_.begin() + (rank - numZeroDraws);
+            std::nth_element(resample_.begin(), nth, resample_.end());
+            return *nth;
+        };
+
+        const double lowerValue = getOrderStatistic(lowerRank);
+        const double upperValue = getOrderStatistic(upperRank);
+        quantiles.push_back(lowerValue + fraction * (upperValue - lowerValue));
+    }
+
+    double mean = 0;
+    for (double quantile : quantiles)
+    {
+        mean += quantile;
+    }
+    mean /= numResamples_;
+
+    double variance = 0;
+    for (double quantile : quantiles)
+    {
+        variance += (quantile - mean) * (quantile - mean);
+    }
+    variance /= numResamples_;
+    const double standardDeviation = std::max(std::sqrt(variance), 1.0);
+
+    OutlierScore score;
+    for (const auto& cohortIndexAndCount : counts)
+    {
+        if (!isCase_[cohortIndexAndCount.first])
+        {
+            continue;
+        }
+
+        const double zscore = (cohortIndexAndCount.second - mean) / standardDeviation;
+        if (zscore > 1.0)
+        {
+            score.highCaseCounts.push_back(cohortIndexAndCount);
+            score.topCaseZscore = std::max(score.topCaseZscore, zscore);
+        }
+    }
+
+    return score;
+}
+
+static void openTable(const string& path, const string& header, std::ofstream& file)
+{
+    file.open(path);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write to " + path);
+    }
+    file << header << "\n";
+}
+
+OutlierTableWriter::OutlierTableWriter(
+    const ReferenceContigInfo& contigInfo, const CohortSamples& samples, const string& pathToLocusTable,
+    const string& pathToMotifTable, int threadCount)
+    : contigInfo_(contigInfo)
+    , samples_(samples)
+    , threadCount_(threadCount)
+{
+    if (samples.numCases() == 0)
+    {
+        throw std::runtime_error("Outlier analysis requires at least one case sample");
+    }
+
+    locusTable_.path = pathToLocusTable;
+    const string locusTableHeader = "contig\tstart\tend\tmotif\ttop_case_zscore\thigh_case_counts\tcounts";
+    openTable(pathToLocusTable, locusTableHeader, locusTable_.file);
+    motifTable_.path = pathToMotifTable;
+    openTable(pathToMotifTable, "motif\ttop_case_zscore\thigh_case_counts\tcounts", motifTable_.file);
+}
+
+void OutlierTableWriter::addMotif(
+    const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+    const vector<RegionWithSampleCount>* regionsWithIrrAnchors)
+{
+    if (irrPairCounts && !irrPairCounts->empty())
+    {
+        addRow(motif, *irrPairCounts, motifTable_);
+    }
+
+    if (!regionsWithIrrAnchors)
+    {
+        return;
+    }
+
+    // Rows follow the order of regions in the multisample profile
+    vector<pair<string, const RegionWithSampleCount*>> encodedRegions;
+    for (const auto& region : *regionsWithIrrAnchors)
+    {
+        if (region.contigId() != -1)
+        {
+            encodedRegions.emplace_back(region.asString(contigInfo_), &region);
+        }
+    }
+    std::sort(encodedRegions.begin(), encodedRegions.end());
+
+    for (const auto& encodingAndRegion : encodedRegions)
+    {
+        const RegionWithSampleCount& region = *encodingAndRegion.second;
+        string label = fmt::format(
+            "{}\t{}\t{}\t{}", contigInfo_.getContigName(region.contigId()), region.start(), region.end(), motif);
+        addRow(std::move(label), region.feature().value(), locusTable_);
+    }
+}
+
+void OutlierTableWriter::addRow(string label, const unordered_map<SampleId, int>& sampleCounts, Table& table)
+{
+    Row row;
+    row.label = std::move(label);
+    row.counts = samples_.indexCounts(sampleCounts);
+
+    uint64_t seedState = kSeed ^ table.numRows++;
+    row.seed = splitMix(seedState);
+    table.rows.push_back(std::move(row));
+
+    if (table.rows.size() == kRowsPerBatch)
+    {
+        flush(table);
+    }
+}
+
+void OutlierTableWriter::scoreRow(OutlierScorer& scorer, Row& row) const
+{
+    vector<double> normalizedCounts;
+    vector<pair<int, double>> cohortCounts;
+    normalizedCounts.reserve(row.counts.size());
+    for (const auto& sampleIndexAndCount : row.counts)
+    {
+        const int sampleIndex = sampleIndexAndCount.first;
+        const double normalizedCount = samples_.normalize(sampleIndex, sampleIndexAndCount.second);
+        normalizedCounts.push_back(normalizedCount);
+        if (samples_.cohortIndex(sampleIndex) != -1)
+        {
+            cohortCounts.emplace_back(samples_.cohortIndex(sampleIndex), normalizedCount);
+        }
+    }
+
+    const OutlierScore score = scorer.score(cohortCounts, row.seed);
+    if (score.highCaseCounts.empty())
+    {
+        return;
+    }
+
+    fmt::memory_buffer output;
+    fmt::format_to(output, "{}\t{:.2f}\t", row.label, score.topCaseZscore);
+    for (size_t index = 0; index != score.highCaseCounts.size(); ++index)
+    {
+        const auto& cohortIndexAndCount = score.highCaseCounts[index];
+        const string& sampleId = samples_.sampleId(samples_.sampleIndexOfCohortMember(cohortIndexAndCount.first));
+        fmt::format_to(output, "{}{}:{:.2f}", index == 0 ? "" : ",", sampleId, cohortIndexAndCount.second);
+    }
+    output.push_back('\t');
+    for (size_t index = 0; index != normalizedCounts.size(); ++index)
+    {
+        fmt::format_to(output, "{}{:.2f}", index == 0 ? "" : ",", normalizedCounts[index]);
+    }
+    output.push_back('\n');
+    row.output = fmt::to_string(output);
+}
+
+void OutlierTableWriter::flush(Table& table)
+{
+    processOnThreads(table.rows.size(), threadCount_, [this, &table](WorkQueue& queue) {
+        OutlierScorer scorer(samples_.isCase());
+        size_t rowIndex;
+        while (queue.tryClaim(rowIndex))
+        {
+            scoreRow(scorer, table.rows[rowIndex]);
+        }
+    });
+
+    for (const auto& row : table.rows)
+    {
+        table.file << row.output;
+    }
+    table.rows.clear();
+
+    if (!table.file)
+    {
+        throw std::runtime_error("Failed to write " + table.path);
+    }
+}
+
+void OutlierTableWriter::finish()
+{
+    for (Table* table : { &locusTable_, &motifTable_ })
+    {
+        flush(*table);
+        table->file.close();
+        if (!table->file)
+        {
+            throw std::runtime_error("Failed to write " + table->path);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Outlier analysis of a merged cohort performed directly on the merged counts. For each region and motif, counts are
+// depth-normalized and the 95th percentile of the counts across the cohort is estimated from bootstrap resamples;
+// case samples whose counts exceed the mean of the resampled percentiles by more than one standard deviation are
+// reported. This is equivalent to the outlier workflows of the accompanying Python scripts.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "merge/CohortSamples.hh"
+#include "merge/MultisampleProfile.hh"
+#include "region/ReferenceContigInfo.hh"
+
+struct OutlierScore
+{
+    double topCaseZscore = -1;
+    // Cohort indexes and counts of case samples with z-scores above one
+    std::vector<std::pair<int, double>> highCaseCounts;
+};
+
+// Computes resampled-quantile z-scores; each instance holds scratch buffers and must be used by one thread at a time
+class OutlierScorer
+{
+public:
+    explicit OutlierScorer(std::vector<bool> isCase, int numResamples = 100, double quantile = 0.95);
+
+    // Counts are given as (cohort index, count) pairs; samples that are not listed have zero counts
+    OutlierScore score(const std::vector<std::pair<int, double>>& counts, uint64_t seed);
+
+private:
+    std::vector<bool> isCase_;
+    int numResamples_;
+    double quantile_;
+    std::vector<double> nonzeroCounts_;
+    std::vector<double> resample_;
+};
+
+// Scores rows of the multisample profile on a pool of threads and writes outlier locus and motif tables; motifs are
+// added in lexicographic order
+class OutlierTableWriter
+{
+public:
+    OutlierTableWriter(
+        const ReferenceContigInfo& contigInfo, const CohortSamples& samples, const std::string& pathToLocusTable,
+        const std::string& pathToMotifTable, int threadCount);
+
+    void addMotif(
+        const Motif& motif, const SampleToIrrPairCount* irrPairCounts,
+        const std::vector<RegionWithSampleCount>* regionsWithIrrAnchors);
+    void finish();
+
+private:
+    struct Row
+    {
+        std::string label;
+        // Sample indexes and raw counts ordered by sample index
+        std::vector<std::pair<int, int>> counts;
+        uint64_t seed;
+        std::string output;
+    };
+
+    struct Table
+    {
+        std::string path;
+        std::ofstream file;
+        std::vector<Row> rows;
+        uint64_t numRows = 0;
+    };
+
+    void addRow(std::string label, const std::unordered_map<SampleId, int>& sampleCounts, Table& table);
+    void scoreRow(OutlierScorer& scorer, Row& row) const;
+    void flush(Table& table);
+
+    const ReferenceContigInfo& contigInfo_;
+    const CohortSamples& samples_;
+    int threadCount_;
+    Table locusTable_;
+    Table motifTable_;
+};
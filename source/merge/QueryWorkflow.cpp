@@ -0,0 +1,155 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/QueryWorkflow.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include "merge/MultisampleProfileWriter.hh"
+#include "merge/MultisampleStore.hh"
+
+using std::map;
+using std::string;
+using std::vector;
+
+static vector<bool>
+selectSamples(const MultisampleStore& store, const string& pathToStore, const vector<string>& sampleIds)
+{
+    vector<bool> selectedSamples;
+    if (sampleIds.empty())
+    {
+        return selectedSamples;
+    }
+
+    selectedSamples.assign(store.numSamples(), false);
+    for (const auto& sampleId : sampleIds)
+    {
+        const int sampleIndex = store.findSample(sampleId);
+        if (sampleIndex == -1)
+        {
+            throw std::runtime_error("Sample " + sampleId + " is not present in " + pathToStore);
+        }
+        selectedSamples[sampleIndex] = true;
+    }
+
+    return selectedSamples;
+}
+
+// Motifs absent from the store have no counts, so they are silently skipped
+static vector<bool> selectMotifs(const MultisampleStore& store, const vector<string>& motifs)
+{
+    vector<bool> selectedMotifs(store.numMotifs(), motifs.empty());
+    for (const auto& motif : motifs)
+    {
+        const int motifIndex = store.findMotif(motif);
+        if (motifIndex != -1)
+        {
+            selectedMotifs[motifIndex] = true;
+        }
+    }
+
+    return selectedMotifs;
+}
+
+int runQueryWorkflow(const QueryWorkflowParameters& parameters)
+{
+    MultisampleStore store(parameters.pathToStore);
+    const vector<bool> selectedSamples = selectSamples(store, parameters.pathToStore, parameters.sampleIds);
+    const vector<bool> selectedMotifs = selectMotifs(store, parameters.motifs);
+
+    // Motif indexes follow the lexicographic order of motifs
+    map<int, vector<RegionWithSampleCount>> regionsByMotif;
+    map<int, SampleToIrrPairCount> irrPairCountsByMotif;
+
+    if (parameters.regionEncodings.empty())
+    {
+        for (int motifIndex = 0; motifIndex != store.numMotifs(); ++motifIndex)
+        {
+            if (selectedMotifs[motifIndex])
+            {
+                regionsByMotif[motifIndex] = store.getRegions(motifIndex, selectedSamples);
+                irrPairCountsByMotif[motifIndex] = store.getIrrPairCounts(motifIndex, selectedSamples);
+            }
+        }
+    }
+    else
+    {
+        for (const auto& regionEncoding : parameters.regionEncodings)
+        {
+            const GenomicRegion queryRegion = decode(store.contigInfo(), regionEncoding);
+            for (auto& motifIndexAndRegion : store.getOverlappingRegions(queryRegion, selectedSamples))
+            {
+                if (selectedMotifs[motifIndexAndRegion.first])
+                {
+                    regionsByMotif[motifIndexAndRegion.first].push_back(std::move(motifIndexAndRegion.second));
+                }
+            }
+        }
+
+        // A region may overlap more than one query region
+        for (auto& motifIndexAndRegions : regionsByMotif)
+        {
+            auto& regions = motifIndexAndRegions.second;
+            std::sort(regions.begin(), regions.end());
+            const auto isSameRegion = [](const GenomicRegion& left, const GenomicRegion& right) {
+                return left.contigId() == right.contigId() && left.start() == right.start()
+                    && left.end() == right.end();
+            };
+            regions.erase(std::unique(regions.begin(), regions.end(), isSameRegion), regions.end());
+        }
+    }
+
+    SampleIdToSampleParameters parametersForSamples;
+    for (int sampleIndex = 0; sampleIndex != store.numSamples(); ++sampleIndex)
+    {
+        if (selectedSamples.empty() || selectedSamples[sampleIndex])
+        {
+            parametersForSamples.emplace(store.sampleId(sampleIndex), store.sampleParameters(sampleIndex));
+        }
+    }
+
+    std::ofstream outputFile(parameters.pathToOutput);
+    if (!outputFile)
+    {
+        throw std::runtime_error("Unable to write to " + parameters.pathToOutput);
+    }
+
+    MultisampleProfileWriter writer(store.contigInfo(), outputFile);
+    for (const auto& motifIndexAndRegions : regionsByMotif)
+    {
+        const int motifIndex = motifIndexAndRegions.first;
+        const auto irrPairCounts = irrPairCountsByMotif.find(motifIndex);
+        writer.addMotif(
+            store.motif(motifIndex), irrPairCounts != irrPairCountsByMotif.end() ? &irrPairCounts->second : nullptr,
+            &motifIndexAndRegions.second);
+    }
+    writer.finish(parametersForSamples);
+
+    if (!outputFile)
+    {
+        throw std::runtime_error("Failed to write " + parameters.pathToOutput);
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/RegionDecoder.hh"
+
+#include <cstdint>
+#include <stdexcept>
+
+using std::string;
+
+static int64_t decodeCoordinate(const string& encoding, size_t begin, size_t end)
+{
+    if (begin == end)
+    {
+        throw std::logic_error("Unexpected range format: " + encoding);
+    }
+
+    int64_t coordinate = 0;
+    for (size_t index = begin; index != end; ++index)
+    {
+        const char digit = encoding[index];
+        if (digit < '0' || '9' < digit)
+        {
+            throw std::logic_error("Unexpected range format: " + encoding);
+        }
+        coordinate = 10 * coordinate + (digit - '0');
+    }
+
+    return coordinate;
+}
+
+GenomicRegion RegionDecoder::decode(const string& encoding)
+{
+    if (encoding == "unaligned")
+    {
+        return { -1, 0, 0 };
+    }
+
+    const auto colonIndex = encoding.find_last_of(':');
+    if (colonIndex == string::npos || colonIndex == 0)
+    {
+        throw std::logic_error("Unexpected range format: " + encoding);
+    }
+
+    const auto dashIndex = encoding.find('-', colonIndex);
+    if (dashIndex == string::npos)
+    {
+        throw std::logic_error("Unexpected range format: " + encoding);
+    }
+
+    if (lastContigId_ == -1 || encoding.compare(0, colonIndex, lastContigName_) != 0)
+    {
+        lastContigName_ = encoding.substr(0, colonIndex);
+        lastContigId_ = contigInfo_.getContigId(lastContigName_);
+    }
+
+    const int64_t start = decodeCoordinate(encoding, colonIndex + 1, dashIndex);
+    const int64_t end = decodeCoordinate(encoding, dashIndex + 1, encoding.size());
+    return { lastContigId_, start, end };
+}
@@ -0,0 +1,45 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "region/GenomicRegion.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Decodes region encodings such as chr1:100-200 or unaligned found in profile files. Regions are typically grouped by
+// contig so the most recent contig lookup is reused.
+class RegionDecoder
+{
+public:
+    explicit RegionDecoder(const ReferenceContigInfo& contigInfo)
+        : contigInfo_(contigInfo)
+    {
+    }
+
+    GenomicRegion decode(const std::string& encoding);
+
+private:
+    const ReferenceContigInfo& contigInfo_;
+    std::string lastContigName_;
+    int lastContigId_ = -1;
+};
@@ -0,0 +1,385 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/SampleProfileLoader.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "thirdparty/nlohmann_json/json.hpp"
+
+#include "io/BinaryStrProfile.hh"
+#include "io/CompressedFile.hh"
+#include "io/StrProfile.hh"
+#include "merge/MultisampleProfileSaxHandler.hh"
+#include "merge/SampleProfileSaxHandler.hh"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+using Json = nlohmann::json;
+
+static void loadStrProfileRecords(
+    const ReferenceContigInfo& contigInfo, const string& sampleId, const StrProfile& profile,
+    const ProfileLoadingParameters& parameters, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& pairedIrrProfile)
+{
+    // Contig names are translated once per contig rather than once per region
+    vector<int> contigIds;
+    contigIds.reserve(profile.contigInfo.numContigs());
+    for (int contigIndex = 0; contigIndex != profile.contigInfo.numContigs(); ++contigIndex)
+    {
+        contigIds.push_back(contigInfo.getContigId(profile.contigInfo.getContigName(contigIndex)));
+    }
+
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        const string& motif = motifAndRecord.first;
+        if (motif.length() < parameters.shortestUnit || parameters.longestUnit < motif.length())
+        {
+            continue;
+        }
+
+        const MotifRecord& record = motifAndRecord.second;
+        for (const auto& region : parameters.useBins ? record.irrAnchorBins : record.regionsWithIrrAnchors)
+        {
+            const int contigId = region.contigId() == -1 ? -1 : contigIds[region.contigId()];
+            if (parameters.targetRegions && !parameters.targetRegions->overlaps(contigId, region.start(), region.end()))
+            {
+                continue;
+            }
+            SampleCountFeature sampleCount({ { sampleId, region.feature().value() } });
+            anchoredIrrProfile[motif].emplace_back(contigId, region.start(), region.end(), sampleCount);
+        }
+
+        if (record.irrPairCount != 0)
+        {
+            pairedIrrProfile[motif].emplace(sampleId, record.irrPairCount);
+        }
+    }
+}
+
+// Multisample profiles are JSON objects whose first key is either Counts or Parameters
+static bool isMultisampleProfile(std::istream& profileStream)
+{
+    char character = 0;
+    while (profileStream.get(character) && std::isspace(static_cast<unsigned char>(character)))
+    {
+    }
+
+    if (!profileStream || character != '{')
+    {
+        return false;
+    }
+
+    string firstKey;
+    profileStream >> std::ws;
+    std::getline(profileStream, firstKey, ':');
+    return firstKey.compare(0, 8, "\"Counts\"") == 0 || firstKey.compare(0, 12, "\"Parameters\"") == 0;
+}
+
+std::shared_ptr<const ProfileBundleReader> ProfileBundleCache::find(const string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto bundleIterator = bundles_.find(path);
+    return bundleIterator != bundles_.end() ? bundleIterator->second : nullptr;
+}
+
+std::shared_ptr<const ProfileBundleReader> ProfileBundleCache::open(const string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& bundle = bundles_[path];
+    if (!bundle)
+    {
+        bundle = std::make_shared<const ProfileBundleReader>(path);
+    }
+
+    return bundle;
+}
+
+static string readFileHeader(const string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    char header[8];
+    file.read(header, sizeof(header));
+    return string(header, file.gcount());
+}
+
+unique_ptr<SampleProfile> loadSampleProfile(
+    const ManifestEntry& sampleInfo, const ReferenceContigInfo& contigInfo, const ProfileLoadingParameters& parameters,
+    ProfileBundleCache& bundles, const DecompressionThreadPool* decompressionPool)
+{
+    unique_ptr<SampleProfile> sampleProfile(new SampleProfile());
+
+    // Profiles stored in bundles and compressed profiles are read into memory while other profiles are read from
+    // their files
+    std::shared_ptr<const ProfileBundleReader> bundle = bundles.find(sampleInfo.path);
+    string header;
+    if (!bundle)
+    {
+        header = readFileHeader(sampleInfo.path);
+        if (hasProfileBundleMagic(header.data(), header.size()))
+        {
+            bundle = bundles.open(sampleInfo.path);
+        }
+    }
+
+    string profileContents;
+    const bool isInMemory = bundle || hasGzipMagic(header.data(), header.size());
+    if (bundle)
+    {
+        profileContents = bundle->readProfile(sampleInfo.sample);
+    }
+    else if (isInMemory)
+    {
+        profileContents = readFileContents(sampleInfo.path, decompressionPool);
+    }
+    if (isInMemory)
+    {
+        header = profileContents.substr(0, 8);
+    }
+    const bool isBinaryProfile = hasBinaryStrProfileMagic(header.data(), header.size());
+
+    if (!bundle && !isBinaryProfile)
+    {
+        std::unique_ptr<std::istream> profileStream;
+        if (isInMemory)
+        {
+            profileStream.reset(new std::istringstream(profileContents));
+        }
+        else
+        {
+            profileStream.reset(new std::ifstream(sampleInfo.path, std::ios::binary));
+        }
+
+        if (isMultisampleProfile(*profileStream))
+        {
+            if (parameters.useBins)
+            {
+                throw std::runtime_error("Multisample profile " + sampleInfo.path + " cannot be merged using bins");
+            }
+
+            loadMultisampleProfile(
+                sampleInfo.path, contigInfo, parameters.shortestUnit, parameters.longestUnit,
+                parameters.targetRegions.get(), sampleProfile->anchoredIrrProfile, sampleProfile->irrPairProfile,
+                sampleProfile->parametersForSamples, decompressionPool);
+            normalize(sampleProfile->anchoredIrrProfile);
+            return sampleProfile;
+        }
+    }
+
+    int readLength = 0;
+    double depth = -1;
+    int binSize = 0;
+    if (isBinaryProfile)
+    {
+        const StrProfile profile = isInMemory ? decodeFromBinary(profileContents) : loadStrProfile(sampleInfo.path);
+        readLength = profile.readLength;
+        depth = profile.depth;
+        binSize = profile.binSize;
+        loadStrProfileRecords(
+            contigInfo, sampleInfo.sample, profile, parameters, sampleProfile->anchoredIrrProfile,
+            sampleProfile->irrPairProfile);
+    }
+    else
+    {
+        SampleProfileSaxHandler profileHandler(
+            contigInfo, sampleInfo.sample, parameters.shortestUnit, parameters.longestUnit, parameters.useBins,
+            parameters.targetRegions.get(), sampleProfile->anchoredIrrProfile, sampleProfile->irrPairProfile);
+        if (isInMemory)
+        {
+            Json::sax_parse(profileContents, &profileHandler);
+        }
+        else
+        {
+            std::ifstream profileFile(sampleInfo.path);
+            if (!profileFile)
+            {
+                throw std::runtime_error("Unable to read " + sampleInfo.path);
+            }
+            Json::sax_parse(profileFile, &profileHandler);
+        }
+        readLength = profileHandler.readLength();
+        depth = profileHandler.depth();
+        binSize = profileHandler.binSize();
+    }
+
+    if (readLength == 0)
+    {
+        throw std::runtime_error("Read length appears to be unset for " + sampleInfo.sample);
+    }
+
+    if (depth == -1)
+    {
+        throw std::runtime_error("Depth appears to be unset for " + sampleInfo.sample);
+    }
+
+    sampleProfile->parametersForSamples.emplace(sampleInfo.sample, SampleParameters(readLength, depth));
+    if (parameters.useBins)
+    {
+        if (binSize == 0)
+        {
+            throw std::runtime_error("STR profile of " + sampleInfo.sample + " does not contain binned counts");
+        }
+
+        // Bins of a sample are distinct, so they do not need to be merged
+        sampleProfile->binSize = binSize;
+        return sampleProfile;
+    }
+
+    normalize(sampleProfile->anchoredIrrProfile);
+    return sampleProfile;
+}
+
+void loadMultisampleProfile(
+    const string& path, const ReferenceContigInfo& contigInfo, int shortestUnit, int longestUnit,
+    const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& pairedIrrProfile, SampleIdToSampleParameters& parametersForSamples,
+    const DecompressionThreadPool* decompressionPool)
+{
+    MultisampleProfileSaxHandler profileHandler(
+        contigInfo, path, shortestUnit, longestUnit, targetRegions, anchoredIrrProfile, pairedIrrProfile);
+    const string header = readFileHeader(path);
+    if (hasGzipMagic(header.data(), header.size()))
+    {
+        Json::sax_parse(readFileContents(path, decompressionPool), &profileHandler);
+    }
+    else
+    {
+        std::ifstream profileFile(path);
+        if (!profileFile)
+        {
+            throw std::runtime_error("Unable to read " + path);
+        }
+        Json::sax_parse(profileFile, &profileHandler);
+    }
+
+    for (auto& sampleIdAndParameters : profileHandler.parametersForSamples())
+    {
+        parametersForSamples.emplace(sampleIdAndParameters.first, sampleIdAndParameters.second);
+    }
+}
+
+ParallelSampleProfileLoader::ParallelSampleProfileLoader(
+    const Manifest& manifest, const ReferenceContigInfo& contigInfo, ProfileLoadingParameters parameters,
+    int threadCount)
+    : manifest_(manifest)
+    , contigInfo_(contigInfo)
+    , parameters_(std::move(parameters))
+    , decompressionPool_(std::max(threadCount, 1))
+    , maxPendingProfiles_(2 * static_cast<size_t>(std::max(threadCount, 1)))
+    , profiles_(manifest.size())
+    , errors_(manifest.size())
+{
+    for (int threadIndex = 0; threadIndex < std::max(threadCount, 1); ++threadIndex)
+    {
+        loaders_.emplace_back(&ParallelSampleProfileLoader::runLoader, this);
+    }
+}
+
+ParallelSampleProfileLoader::~ParallelSampleProfileLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopped_ = true;
+    }
+    profileRetrieved_.notify_all();
+
+    for (auto& loader : loaders_)
+    {
+        loader.join();
+    }
+}
+
+unique_ptr<SampleProfile> ParallelSampleProfileLoader::next()
+{
+    if (nextIndexToRetrieve_ == manifest_.size())
+    {
+        throw std::logic_error("All sample profiles were already retrieved");
+    }
+
+    unique_ptr<SampleProfile> profile;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const size_t index = nextIndexToRetrieve_;
+        profileLoaded_.wait(lock, [this, index] { return profiles_[index] || errors_[index]; });
+
+        if (errors_[index])
+        {
+            std::rethrow_exception(errors_[index]);
+        }
+
+        profile = std::move(profiles_[index]);
+        ++nextIndexToRetrieve_;
+    }
+    profileRetrieved_.notify_all();
+
+    return profile;
+}
+
+void ParallelSampleProfileLoader::runLoader()
+{
+    while (true)
+    {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            profileRetrieved_.wait(lock, [this] {
+                return isStopped_ || nextIndexToLoad_ == manifest_.size()
+                    || nextIndexToLoad_ < nextIndexToRetrieve_ + maxPendingProfiles_;
+            });
+
+            if (isStopped_ || nextIndexToLoad_ == manifest_.size())
+            {
+                return;
+            }
+
+            index = nextIndexToLoad_++;
+        }
+
+        unique_ptr<SampleProfile> profile;
+        std::exception_ptr error;
+        try
+        {
+            profile = loadSampleProfile(manifest_[index], contigInfo_, parameters_, bundles_, &decompressionPool_);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            profiles_[index] = std::move(profile);
+            errors_[index] = error;
+        }
+        profileLoaded_.notify_all();
+    }
+}
@@ -0,0 +1,134 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "io/CompressedFile.hh"
+#include "io/ProfileBundle.hh"
+#include "merge/Manifest.hh"
+#include "merge/MultisampleProfile.hh"
+#include "region/ReferenceContigInfo.hh"
+#include "region/TargetRegionIndex.hh"
+
+// Determines which content of sample profiles is loaded
+struct ProfileLoadingParameters
+{
+    ProfileLoadingParameters(
+        int shortestUnit, int longestUnit, bool useBins = false,
+        std::shared_ptr<const TargetRegionIndex> targetRegions = nullptr)
+        : shortestUnit(shortestUnit)
+        , longestUnit(longestUnit)
+        , useBins(useBins)
+        , targetRegions(std::move(targetRegions))
+    {
+    }
+
+    int shortestUnit;
+    int longestUnit;
+    // Load binned anchored IRR counts in place of regions with anchored IRRs
+    bool useBins;
+    // Regions that do not overlap these targets are dropped while profiles are loaded; all regions are kept if unset
+    std::shared_ptr<const TargetRegionIndex> targetRegions;
+};
+
+// Content of a manifest entry restricted to motifs of the target lengths; regions are sorted and merged. The entry is
+// either a single-sample STR profile or a multisample profile covering a subset of the cohort.
+struct SampleProfile
+{
+    MultisampleAnchoredIrrProfile anchoredIrrProfile;
+    MultisampleIrrPairProfile irrPairProfile;
+    SampleIdToSampleParameters parametersForSamples;
+    // Size of the bins loaded in place of regions; zero if regions were loaded
+    int binSize = 0;
+};
+
+// Profile bundles referenced by the manifest; each bundle is opened once and shared by all of its samples
+class ProfileBundleCache
+{
+public:
+    // Returns the bundle if it was already opened and nullptr otherwise
+    std::shared_ptr<const ProfileBundleReader> find(const std::string& path);
+    std::shared_ptr<const ProfileBundleReader> open(const std::string& path);
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const ProfileBundleReader>> bundles_;
+};
+
+// Multisample profiles and profile bundles are recognized by their content, so they can be listed in the manifest
+// alongside single-sample profiles; the profile of a sample stored in a bundle is looked up by the sample id.
+// Compressed profiles are decompressed on the threads of the pool if one is given.
+std::unique_ptr<SampleProfile> loadSampleProfile(
+    const ManifestEntry& sampleInfo, const ReferenceContigInfo& contigInfo, const ProfileLoadingParameters& parameters,
+    ProfileBundleCache& bundles, const DecompressionThreadPool* decompressionPool = nullptr);
+
+// Adds the content of a multisample profile produced by the merge workflow to the given profiles
+void loadMultisampleProfile(
+    const std::string& path, const ReferenceContigInfo& contigInfo, int shortestUnit, int longestUnit,
+    const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& pairedIrrProfile, SampleIdToSampleParameters& parametersForSamples,
+    const DecompressionThreadPool* decompressionPool = nullptr);
+
+// Loads sample profiles on a pool of threads and hands them out in manifest order. The number of loaded profiles
+// waiting to be retrieved is capped to bound memory use.
+class ParallelSampleProfileLoader
+{
+public:
+    ParallelSampleProfileLoader(
+        const Manifest& manifest, const ReferenceContigInfo& contigInfo, ProfileLoadingParameters parameters,
+        int threadCount);
+    ~ParallelSampleProfileLoader();
+
+    ParallelSampleProfileLoader(const ParallelSampleProfileLoader&) = delete;
+    ParallelSampleProfileLoader& operator=(const ParallelSampleProfileLoader&) = delete;
+
+    // Returns the profile of the next manifest entry; rethrows the error if the profile could not be loaded
+    std::unique_ptr<SampleProfile> next();
+
+private:
+    void runLoader();
+
+    const Manifest& manifest_;
+    const ReferenceContigInfo& contigInfo_;
+    ProfileLoadingParameters parameters_;
+    ProfileBundleCache bundles_;
+    DecompressionThreadPool decompressionPool_;
+    size_t maxPendingProfiles_;
+
+    std::mutex mutex_;
+    std::condition_variable profileLoaded_;
+    std::condition_variable profileRetrieved_;
+    size_t nextIndexToLoad_ = 0;
+    size_t nextIndexToRetrieve_ = 0;
+    bool isStopped_ = false;
+    std::vector<std::unique_ptr<SampleProfile>> profiles_;
+    std::vector<std::exception_ptr> errors_;
+    std::vector<std::thread> loaders_;
+};
@@ -0,0 +1,242 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/SampleProfileSaxHandler.hh"
+
+#include <stdexcept>
+#include <utility>
+
+using std::string;
+
+SampleProfileSaxHandler::SampleProfileSaxHandler(
+    const ReferenceContigInfo& contigInfo, SampleId sampleId, int shortestUnit, int longestUnit, bool useBins,
+    const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+    MultisampleIrrPairProfile& pairedIrrProfile)
+    : regionDecoder_(contigInfo)
+    , sampleId_(std::move(sampleId))
+    , shortestUnit_(shortestUnit)
+    , longestUnit_(longestUnit)
+    , useBins_(useBins)
+    , targetRegions_(targetRegions)
+    , anchoredIrrProfile_(anchoredIrrProfile)
+    , pairedIrrProfile_(pairedIrrProfile)
+{
+}
+
+bool SampleProfileSaxHandler::null() { return handleNonNumericScalar(); }
+bool SampleProfileSaxHandler::boolean(bool) { return handleNonNumericScalar(); }
+bool SampleProfileSaxHandler::string(string_t&) { return handleNonNumericScalar(); }
+
+bool SampleProfileSaxHandler::number_integer(number_integer_t value) { return handleNumber(value); }
+bool SampleProfileSaxHandler::number_unsigned(number_unsigned_t value) { return handleNumber(value); }
+bool SampleProfileSaxHandler::number_float(number_float_t value, const string_t&) { return handleNumber(value); }
+
+bool SampleProfileSaxHandler::handleNonNumericScalar()
+{
+    if (numSkippedLevels_ == 0 && value_ != Value::kIgnored && value_ != Value::kMotifRecord
+        && value_ != Value::kRegions)
+    {
+        throw std::runtime_error("Expected a number in the STR profile of " + sampleId_);
+    }
+
+    return true;
+}
+
+bool SampleProfileSaxHandler::handleNumber(double value)
+{
+    if (numSkippedLevels_ != 0)
+    {
+        return true;
+    }
+
+    switch (value_)
+    {
+    case Value::kReadLength:
+        readLength_ = static_cast<int>(value);
+        break;
+    case Value::kDepth:
+        depth_ = value;
+        break;
+    case Value::kBinSize:
+        binSize_ = static_cast<int>(value);
+        break;
+    case Value::kIrrPairCount:
+        if (value != 0)
+        {
+            pairedIrrProfile_[motif_].emplace(sampleId_, static_cast<int>(value));
+        }
+        break;
+    case Value::kRegionCount:
+        if (!targetRegions_ || targetRegions_->overlaps(region_))
+        {
+            SampleCountFeature sampleCount({ { sampleId_, static_cast<int>(value) } });
+            anchoredIrrProfile_[motif_].emplace_back(region_.contigId(), region_.start(), region_.end(), sampleCount);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool SampleProfileSaxHandler::start_object(std::size_t)
+{
+    if (numSkippedLevels_ != 0)
+    {
+        ++numSkippedLevels_;
+    }
+    else if (level_ == Level::kDocument)
+    {
+        level_ = Level::kProfile;
+    }
+    else if (value_ == Value::kMotifRecord)
+    {
+        level_ = Level::kMotifRecord;
+    }
+    else if (value_ == Value::kRegions)
+    {
+        level_ = Level::kRegions;
+    }
+    else if (value_ == Value::kIgnored)
+    {
+        numSkippedLevels_ = 1;
+    }
+    else
+    {
+        throw std::runtime_error("Expected a number in the STR profile of " + sampleId_);
+    }
+
+    return true;
+}
+
+bool SampleProfileSaxHandler::key(string_t& value)
+{
+    if (numSkippedLevels_ != 0)
+    {
+        return true;
+    }
+
+    switch (level_)
+    {
+    case Level::kProfile:
+        if (value == "ReadLength")
+        {
+            value_ = Value::kReadLength;
+        }
+        else if (value == "Depth")
+        {
+            value_ = Value::kDepth;
+        }
+        else if (value == "BinSize")
+        {
+            value_ = Value::kBinSize;
+        }
+        else if (value == "InputFingerprint")
+        {
+            value_ = Value::kIgnored;
+        }
+        else if (shortestUnit_ <= value.length() && value.length() <= longestUnit_)
+        {
+            value_ = Value::kMotifRecord;
+            motif_ = value;
+        }
+        else
+        {
+            value_ = Value::kIgnored;
+        }
+        break;
+    case Level::kMotifRecord:
+        if (value == "IrrPairCount")
+        {
+            value_ = Value::kIrrPairCount;
+        }
+        else if (value == (useBins_ ? "IrrAnchorBins" : "RegionsWithIrrAnchors"))
+        {
+            value_ = Value::kRegions;
+        }
+        else
+        {
+            value_ = Value::kIgnored;
+        }
+        break;
+    case Level::kRegions:
+        region_ = regionDecoder_.decode(value);
+        value_ = Value::kRegionCount;
+        break;
+    default:
+        value_ = Value::kIgnored;
+    }
+
+    return true;
+}
+
+bool SampleProfileSaxHandler::end_object()
+{
+    if (numSkippedLevels_ != 0)
+    {
+        --numSkippedLevels_;
+        return true;
+    }
+
+    switch (level_)
+    {
+    case Level::kRegions:
+        level_ = Level::kMotifRecord;
+        break;
+    case Level::kMotifRecord:
+        level_ = Level::kProfile;
+        break;
+    default:
+        level_ = Level::kDocument;
+    }
+
+    value_ = Value::kIgnored;
+    return true;
+}
+
+bool SampleProfileSaxHandler::start_array(std::size_t)
+{
+    if (numSkippedLevels_ == 0 && level_ == Level::kDocument)
+    {
+        throw std::runtime_error("STR profile of " + sampleId_ + " is not a JSON object");
+    }
+
+    if (numSkippedLevels_ == 0)
+    {
+        handleNonNumericScalar();
+    }
+
+    ++numSkippedLevels_;
+    return true;
+}
+
+bool SampleProfileSaxHandler::end_array()
+{
+    --numSkippedLevels_;
+    return true;
+}
+
+bool SampleProfileSaxHandler::parse_error(
+    std::size_t, const std::string&, const nlohmann::detail::exception& exception)
+{
+    throw std::runtime_error("Unable to parse STR profile of " + sampleId_ + ": " + exception.what());
+}
@@ -0,0 +1,106 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "thirdparty/nlohmann_json/json.hpp"
+
+#include "merge/MultisampleProfile.hh"
+#include "merge/RegionDecoder.hh"
+#include "region/ReferenceContigInfo.hh"
+#include "region/TargetRegionIndex.hh"
+
+// Adds the content of a JSON STR profile to multisample profiles while the profile is parsed; this avoids building
+// the JSON document in memory. Records of motifs with lengths outside of the target range are skipped. If bins are
+// used, binned anchored IRR counts are loaded in place of regions with anchored IRRs. Regions that do not overlap the
+// target regions are skipped if these are given.
+class SampleProfileSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    SampleProfileSaxHandler(
+        const ReferenceContigInfo& contigInfo, SampleId sampleId, int shortestUnit, int longestUnit, bool useBins,
+        const TargetRegionIndex* targetRegions, MultisampleAnchoredIrrProfile& anchoredIrrProfile,
+        MultisampleIrrPairProfile& pairedIrrProfile);
+
+    int readLength() const { return readLength_; }
+    double depth() const { return depth_; }
+    int binSize() const { return binSize_; }
+
+    bool null() override;
+    bool boolean(bool value) override;
+    bool number_integer(number_integer_t value) override;
+    bool number_unsigned(number_unsigned_t value) override;
+    bool number_float(number_float_t value, const string_t& encoding) override;
+    bool string(string_t& value) override;
+    bool start_object(std::size_t numElements) override;
+    bool key(string_t& value) override;
+    bool end_object() override;
+    bool start_array(std::size_t numElements) override;
+    bool end_array() override;
+    bool parse_error(
+        std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception) override;
+
+private:
+    enum class Level
+    {
+        kDocument,
+        kProfile,
+        kMotifRecord,
+        kRegions
+    };
+
+    // Meaning of the value that follows the most recent key
+    enum class Value
+    {
+        kIgnored,
+        kReadLength,
+        kDepth,
+        kBinSize,
+        kMotifRecord,
+        kIrrPairCount,
+        kRegions,
+        kRegionCount
+    };
+
+    bool handleNumber(double value);
+    bool handleNonNumericScalar();
+
+    RegionDecoder regionDecoder_;
+    SampleId sampleId_;
+    int shortestUnit_;
+    int longestUnit_;
+    bool useBins_;
+    const TargetRegionIndex* targetRegions_;
+    MultisampleAnchoredIrrProfile& anchoredIrrProfile_;
+    MultisampleIrrPairProfile& pairedIrrProfile_;
+
+    Level level_ = Level::kDocument;
+    Value value_ = Value::kIgnored;
+    int numSkippedLevels_ = 0;
+
+    int readLength_ = 0;
+    double depth_ = -1;
+    int binSize_ = 0;
+    Motif motif_;
+    GenomicRegion region_ = GenomicRegion(-1, 0, 0);
+};
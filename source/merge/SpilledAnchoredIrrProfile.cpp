@@ -0,0 +1,437 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/SpilledAnchoredIrrProfile.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "thirdparty/spdlog/spdlog.h"
+
+#include "common/BinaryCoding.hh"
+
+using std::string;
+using std::to_string;
+using std::unique_ptr;
+using std::vector;
+
+using Entry = SpilledAnchoredIrrProfile::Entry;
+
+// Regions that are this close to one another are merged, as in normalize()
+static const int kMaxMergeDistance = 500;
+
+bool Entry::operator<(const Entry& other) const
+{
+    if (contigId != other.contigId)
+    {
+        return contigId < other.contigId;
+    }
+
+    if (start != other.start)
+    {
+        return start < other.start;
+    }
+
+    if (end != other.end)
+    {
+        return end < other.end;
+    }
+
+    return sampleIndex < other.sampleIndex;
+}
+
+// Sequentially reads a run written by SpilledAnchoredIrrProfile::spill(). A run consists of blocks each containing
+// a motif, the number of entries, and the entries sorted by region.
+class RunReader
+{
+public:
+    explicit RunReader(const string& path)
+        : path_(path)
+        , runFile_(path, std::ios::binary)
+    {
+        if (!runFile_)
+        {
+            throw std::runtime_error("Unable to read " + path);
+        }
+        advance();
+    }
+
+    bool atEnd() const { return atEnd_; }
+    const Motif& motif() const { return motif_; }
+    const Entry& entry() const { return entry_; }
+
+    void advance()
+    {
+        if (numRemainingEntries_ == 0)
+        {
+            if (runFile_.peek() == std::char_traits<char>::eof())
+            {
+                atEnd_ = true;
+                return;
+            }
+
+            motif_.resize(readVarint());
+            runFile_.read(&motif_[0], motif_.size());
+            numRemainingEntries_ = readVarint();
+            entry_.contigId = -1;
+            entry_.start = 0;
+        }
+
+        const int contigId = static_cast<int>(readVarint()) - 1;
+        if (contigId != entry_.contigId)
+        {
+            entry_.start = 0;
+        }
+
+        entry_.contigId = contigId;
+        entry_.start += readSignedVarint();
+        entry_.end = entry_.start + readSignedVarint();
+        entry_.sampleIndex = static_cast<int>(readVarint());
+        entry_.count = static_cast<int>(readVarint());
+        --numRemainingEntries_;
+    }
+
+private:
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            const int byte = runFile_.get();
+            if (byte == std::char_traits<char>::eof())
+            {
+                throw std::runtime_error("Unexpected end of " + path_);
+            }
+
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+
+        throw std::runtime_error("Malformed varint in " + path_);
+    }
+
+    int64_t readSignedVarint()
+    {
+        const uint64_t zigzagEncoding = readVarint();
+        return static_cast<int64_t>(zigzagEncoding >> 1) ^ -static_cast<int64_t>(zigzagEncoding & 1);
+    }
+
+    string path_;
+    std::ifstream runFile_;
+    bool atEnd_ = false;
+    Motif motif_;
+    uint64_t numRemainingEntries_ = 0;
+    Entry entry_ { -1, 0, 0, 0, 0 };
+};
+
+// Writes a run in the format read by RunReader. Entries of one motif may be split across consecutive blocks, so runs
+// combined from other runs can be written without holding all entries of a motif in memory.
+class RunWriter
+{
+public:
+    explicit RunWriter(const string& path)
+        : path_(path)
+        , runFile_(path, std::ios::binary)
+    {
+        if (!runFile_)
+        {
+            throw std::runtime_error("Unable to write to " + path);
+        }
+    }
+
+    // Entries must be added sorted by motif and then by region
+    void add(const Motif& motif, const Entry& entry)
+    {
+        if (motif != motif_ || entries_.size() == kMaxEntriesPerBlock)
+        {
+            writeBlock(motif_, entries_);
+            entries_.clear();
+            motif_ = motif;
+        }
+        entries_.push_back(entry);
+    }
+
+    void writeBlock(const Motif& motif, const vector<Entry>& entries)
+    {
+        if (entries.empty())
+        {
+            return;
+        }
+
+        encoder_.writeString(motif);
+        encoder_.writeVarint(entries.size());
+        int previousContigId = -1;
+        int64_t previousStart = 0;
+        for (const auto& entry : entries)
+        {
+            if (entry.contigId != previousContigId)
+            {
+                previousStart = 0;
+            }
+
+            encoder_.writeVarint(entry.contigId + 1);
+            encoder_.writeSignedVarint(entry.start - previousStart);
+            encoder_.writeSignedVarint(entry.end - entry.start);
+            encoder_.writeVarint(entry.sampleIndex);
+            encoder_.writeVarint(entry.count);
+
+            previousContigId = entry.contigId;
+            previousStart = entry.start;
+        }
+
+        runFile_.write(encoder_.buffer().data(), encoder_.buffer().size());
+        encoder_.clear();
+    }
+
+    void finish()
+    {
+        writeBlock(motif_, entries_);
+        entries_.clear();
+        runFile_.close();
+        if (!runFile_)
+        {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+    }
+
+private:
+    static const size_t kMaxEntriesPerBlock = 4096;
+
+    string path_;
+    std::ofstream runFile_;
+    BinaryEncoder encoder_;
+    Motif motif_;
+    vector<Entry> entries_;
+};
+
+SpilledAnchoredIrrProfile::SpilledAnchoredIrrProfile(string runPathPrefix, size_t memoryBudget, size_t maxOpenRuns)
+    : runPathPrefix_(std::move(runPathPrefix))
+    , memoryBudget_(memoryBudget)
+    , maxOpenRuns_(std::max<size_t>(maxOpenRuns, 2))
+{
+}
+
+SpilledAnchoredIrrProfile::~SpilledAnchoredIrrProfile() { removeRuns(); }
+
+int SpilledAnchoredIrrProfile::getSampleIndex(const SampleId& sampleId)
+{
+    auto sampleIndex = sampleIndexes_.find(sampleId);
+    if (sampleIndex == sampleIndexes_.end())
+    {
+        sampleIndex = sampleIndexes_.emplace(sampleId, static_cast<int>(sampleIds_.size())).first;
+        sampleIds_.push_back(sampleId);
+    }
+
+    return sampleIndex->second;
+}
+
+void SpilledAnchoredIrrProfile::add(const MultisampleAnchoredIrrProfile& sampleProfile)
+{
+    for (const auto& motifAndRegions : sampleProfile)
+    {
+        auto motifEntries = buffer_.find(motifAndRegions.first);
+        if (motifEntries == buffer_.end())
+        {
+            motifEntries = buffer_.emplace(motifAndRegions.first, vector<Entry>()).first;
+            bufferSize_ += sizeof(*motifEntries) + motifAndRegions.first.capacity();
+        }
+
+        // The buffer is charged for the capacity of the vector rather than its size, which includes the slack left
+        // by reallocations
+        vector<Entry>& entries = motifEntries->second;
+        const size_t previousCapacity = entries.capacity();
+        for (const auto& region : motifAndRegions.second)
+        {
+            for (const auto& sampleIdAndCount : region.feature().value())
+            {
+                const int sampleIndex = getSampleIndex(sampleIdAndCount.first);
+                entries.push_back(
+                    { region.contigId(), region.start(), region.end(), sampleIndex, sampleIdAndCount.second });
+            }
+        }
+        bufferSize_ += (entries.capacity() - previousCapacity) * sizeof(Entry);
+    }
+
+    if (bufferSize_ >= memoryBudget_)
+    {
+        spill();
+    }
+}
+
+string SpilledAnchoredIrrProfile::newRunPath()
+{
+    const string runPath = runPathPrefix_ + to_string(numRunsWritten_++) + ".tmp";
+    runPaths_.push_back(runPath);
+    return runPath;
+}
+
+void SpilledAnchoredIrrProfile::spill()
+{
+    const string runPath = newRunPath();
+    spdlog::info("Writing {} bytes of regions to {}", bufferSize_, runPath);
+    RunWriter runWriter(runPath);
+
+    vector<Motif> motifs;
+    motifs.reserve(buffer_.size());
+    for (const auto& motifAndEntries : buffer_)
+    {
+        motifs.push_back(motifAndEntries.first);
+    }
+    std::sort(motifs.begin(), motifs.end());
+
+    for (const auto& motif : motifs)
+    {
+        vector<Entry>& entries = buffer_[motif];
+        std::sort(entries.begin(), entries.end());
+        runWriter.writeBlock(motif, entries);
+
+        // Release the memory of each motif as soon as it is written out
+        vector<Entry>().swap(entries);
+    }
+    runWriter.finish();
+
+    buffer_.clear();
+    bufferSize_ = 0;
+}
+
+void SpilledAnchoredIrrProfile::mergeRuns(
+    const vector<string>& runPaths, const std::function<void(const Motif&, const Entry&)>& processEntry)
+{
+    vector<unique_ptr<RunReader>> readers;
+    for (const auto& runPath : runPaths)
+    {
+        readers.emplace_back(new RunReader(runPath));
+    }
+
+    auto isAfter = [&readers](size_t left, size_t right) {
+        const RunReader& leftReader = *readers[left];
+        const RunReader& rightReader = *readers[right];
+        if (leftReader.motif() != rightReader.motif())
+        {
+            return rightReader.motif() < leftReader.motif();
+        }
+        return rightReader.entry() < leftReader.entry();
+    };
+
+    std::priority_queue<size_t, vector<size_t>, decltype(isAfter)> queue(isAfter);
+    for (size_t readerIndex = 0; readerIndex != readers.size(); ++readerIndex)
+    {
+        if (!readers[readerIndex]->atEnd())
+        {
+            queue.push(readerIndex);
+        }
+    }
+
+    while (!queue.empty())
+    {
+        const size_t readerIndex = queue.top();
+        queue.pop();
+        RunReader& reader = *readers[readerIndex];
+        processEntry(reader.motif(), reader.entry());
+
+        reader.advance();
+        if (!reader.atEnd())
+        {
+            queue.push(readerIndex);
+        }
+    }
+}
+
+void SpilledAnchoredIrrProfile::merge(
+    const std::function<void(const Motif&, const vector<RegionWithSampleCount>&)>& processMotif)
+{
+    if (!buffer_.empty())
+    {
+        spill();
+    }
+
+    // Each run being merged holds an open file, so runs are combined in groups into longer runs until few enough
+    // remain to be merged at once
+    while (runPaths_.size() > maxOpenRuns_)
+    {
+        const vector<string> group(runPaths_.begin(), runPaths_.begin() + maxOpenRuns_);
+        const string runPath = newRunPath();
+        spdlog::info("Merging {} runs into {}", group.size(), runPath);
+
+        RunWriter runWriter(runPath);
+        mergeRuns(group, [&runWriter](const Motif& motif, const Entry& entry) { runWriter.add(motif, entry); });
+        runWriter.finish();
+
+        for (const auto& mergedRunPath : group)
+        {
+            std::remove(mergedRunPath.c_str());
+        }
+        runPaths_.erase(runPaths_.begin(), runPaths_.begin() + maxOpenRuns_);
+    }
+
+    // Entries arrive sorted by region within each motif, so nearby regions are merged as in sortAndMerge()
+    Motif motif;
+    vector<RegionWithSampleCount> mergedRegions;
+    mergeRuns(runPaths_, [&](const Motif& entryMotif, const Entry& entry) {
+        if (entryMotif != motif)
+        {
+            if (!mergedRegions.empty())
+            {
+                processMotif(motif, mergedRegions);
+                mergedRegions.clear();
+            }
+            motif = entryMotif;
+        }
+
+        SampleCountFeature sampleCount({ { sampleIds_[entry.sampleIndex], entry.count } });
+        RegionWithSampleCount region(entry.contigId, entry.start, entry.end, std::move(sampleCount));
+
+        if (!mergedRegions.empty() && mergedRegions.back().distance(region) <= kMaxMergeDistance)
+        {
+            RegionWithSampleCount& mergedRegion = mergedRegions.back();
+            mergedRegion.setEnd(std::max<int64_t>(mergedRegion.end(), region.end()));
+            mergedRegion.feature().combine(region.feature());
+        }
+        else
+        {
+            mergedRegions.push_back(std::move(region));
+        }
+    });
+
+    if (!mergedRegions.empty())
+    {
+        processMotif(motif, mergedRegions);
+    }
+
+    removeRuns();
+}
+
+void SpilledAnchoredIrrProfile::removeRuns()
+{
+    for (const auto& runPath : runPaths_)
+    {
+        std::remove(runPath.c_str());
+    }
+    runPaths_.clear();
+}
@@ -0,0 +1,80 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "merge/MultisampleProfile.hh"
+
+// Accumulates anchored IRR regions of many samples under a memory budget. Regions are buffered in memory and, once
+// the buffer exceeds the budget, spilled to a temporary file as a run sorted by motif and region. The runs are
+// then combined by a multi-way merge, which first combines groups of runs into longer runs if there are more runs
+// than files that can be open at once.
+class SpilledAnchoredIrrProfile
+{
+public:
+    SpilledAnchoredIrrProfile(std::string runPathPrefix, size_t memoryBudget, size_t maxOpenRuns = 64);
+    ~SpilledAnchoredIrrProfile();
+
+    SpilledAnchoredIrrProfile(const SpilledAnchoredIrrProfile&) = delete;
+    SpilledAnchoredIrrProfile& operator=(const SpilledAnchoredIrrProfile&) = delete;
+
+    void add(const MultisampleAnchoredIrrProfile& sampleProfile);
+
+    // Merges nearby regions of each motif across samples and passes them to the callback one motif at a time in
+    // lexicographic order of motifs
+    void merge(const std::function<void(const Motif&, const std::vector<RegionWithSampleCount>&)>& processMotif);
+
+    struct Entry
+    {
+        int contigId;
+        int64_t start;
+        int64_t end;
+        int sampleIndex;
+        int count;
+
+        bool operator<(const Entry& other) const;
+    };
+
+private:
+    int getSampleIndex(const SampleId& sampleId);
+    std::string newRunPath();
+    void spill();
+    void mergeRuns(
+        const std::vector<std::string>& runPaths, const std::function<void(const Motif&, const Entry&)>& processEntry);
+    void removeRuns();
+
+    std::string runPathPrefix_;
+    size_t memoryBudget_;
+    size_t maxOpenRuns_;
+    size_t bufferSize_ = 0;
+    std::unordered_map<Motif, std::vector<Entry>> buffer_;
+    std::vector<SampleId> sampleIds_;
+    std::unordered_map<SampleId, int> sampleIndexes_;
+    std::vector<std::string> runPaths_;
+    int numRunsWritten_ = 0;
+};
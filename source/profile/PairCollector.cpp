@@ -22,68 +22,66 @@
 #include "PairCollector.hh"
 
 #include <cassert>
-#include <cstring>
 
 using std::string;
 using std::to_string;
 
-bool ReadCache::isReadCached(const Read& read)
-{
-    const auto it = readTypes_.find(read.name);
-    return it != readTypes_.end();
-}
+bool ReadCache::isReadCached(const ReadNameKey& key) const { return readTypes_.find(key) != readTypes_.end(); }
 
-ReadType ReadCache::typeOfRead(const Read& read)
+ReadType ReadCache::typeOfRead(const ReadNameKey& key) const
 {
-    const auto it = readTypes_.find(read.name);
+    const auto it = readTypes_.find(key);
     if (it == readTypes_.end())
     {
-        throw std::logic_error("Error: " + read.name + " is not cached");
+        throw std::logic_error("Error: " + nameCodec_.decode(key) + " is not cached");
     }
     const ReadType read_type = it->second;
     return read_type;
 }
 
-void ReadCache::eraseRead(const Read& read)
+void ReadCache::eraseRead(const ReadNameKey& key)
 {
-    const ReadType read_type = typeOfRead(read);
-
-    const auto it = readTypes_.find(read.name);
-    readTypes_.erase(it);
+    const ReadType read_type = typeOfRead(key);
+    readTypes_.erase(key);
 
     if (read_type == ReadType::kIrrRead || read_type == ReadType::kAnchorRead)
     {
-        irrAndAnchorLocations_.erase(read.name);
+        irrAndAnchorLocations_.erase(key);
     }
     if (read_type == ReadType::kIrrRead)
     {
-        irrUnits_.erase(read.name);
+        irrUnits_.erase(key);
     }
+    nameCodec_.release(key);
+}
+
+RegionWithCount ReadCache::extractRegionOfIrrOrAnchor(const ReadNameKey& key) const
+{
+    return irrAndAnchorLocations_.at(key);
 }
 
-RegionWithCount ReadCache::extractRegionOfIrrOrAnchor(const Read& read) { return irrAndAnchorLocations_.at(read.name); }
-string ReadCache::extractUnitOfIrr(const Read& read) { return irrUnits_.at(read.name); }
+string ReadCache::extractUnitOfIrr(const ReadNameKey& key) const { return irrUnits_.at(key); }
 
-void ReadCache::cacheAnchorRead(const Read& read)
+void ReadCache::cacheAnchorRead(const ReadNameKey& key, const Read& read)
 {
-    readTypes_[read.name] = ReadType::kAnchorRead;
+    readTypes_[key] = ReadType::kAnchorRead;
 
     RegionWithCount read_region = createCountableRegion(read.contigId, read.pos, read.pos + 1);
-    irrAndAnchorLocations_.emplace(std::make_pair(read.name, read_region));
+    irrAndAnchorLocations_.emplace(std::make_pair(key, read_region));
 }
 
-void ReadCache::cacheInrepeatRead(const Read& read, const string& unit)
+void ReadCache::cacheInrepeatRead(const ReadNameKey& key, const Read& read, const string& unit)
 {
-    readTypes_[read.name] = ReadType::kIrrRead;
+    readTypes_[key] = ReadType::kIrrRead;
 
     RegionWithCount read_region = createCountableRegion(read.contigId, read.pos, read.pos + 1);
-    irrAndAnchorLocations_.emplace(std::make_pair(read.name, read_region));
+    irrAndAnchorLocations_.emplace(std::make_pair(key, read_region));
 
     assert(!unit.empty());
-    irrUnits_[read.name] = unit;
+    irrUnits_[key] = unit;
 }
 
-void ReadCache::cacheOtherRead(const Read& read) { readTypes_[read.name] = ReadType::kOtherRead; }
+void ReadCache::cacheOtherRead(const ReadNameKey& key) { readTypes_[key] = ReadType::kOtherRead; }
 
 string ReadCache::printStats()
 {
@@ -92,15 +90,85 @@ string ReadCache::printStats()
     return stats;
 }
 
-void PairCollector::addAnchor(const Read& read)
+static void writeRegion(const RegionWithCount& region, BinaryEncoder& encoder)
+{
+    encoder.writeSignedVarint(region.contigId());
+    encoder.writeSignedVarint(region.start());
+    encoder.writeSignedVarint(region.end() - region.start());
+    encoder.writeVarint(region.feature().value());
+}
+
+static RegionWithCount readRegion(BinaryDecoder& decoder)
+{
+    const auto contigId = static_cast<int>(decoder.readSignedVarint());
+    const int64_t start = decoder.readSignedVarint();
+    const int64_t end = start + decoder.readSignedVarint();
+    const auto count = static_cast<int>(decoder.readVarint());
+    return RegionWithCount(contigId, start, end, CountFeature(count));
+}
+
+void ReadCache::saveState(BinaryEncoder& encoder) const
+{
+    encoder.writeVarint(readTypes_.size());
+    for (const auto& keyAndType : readTypes_)
+    {
+        const ReadNameKey& key = keyAndType.first;
+        const ReadType type = keyAndType.second;
+        encoder.writeString(nameCodec_.decode(key));
+        encoder.writeVarint(static_cast<uint64_t>(type));
+        if (type == ReadType::kIrrRead || type == ReadType::kAnchorRead)
+        {
+            writeRegion(irrAndAnchorLocations_.at(key), encoder);
+        }
+        if (type == ReadType::kIrrRead)
+        {
+            encoder.writeString(irrUnits_.at(key));
+        }
+    }
+}
+
+void ReadCache::restoreState(BinaryDecoder& decoder)
+{
+    nameCodec_ = ReadNameCodec();
+    readTypes_.clear();
+    irrAndAnchorLocations_.clear();
+    irrUnits_.clear();
+
+    const uint64_t numReads = decoder.readVarint();
+    readTypes_.reserve(numReads);
+    for (uint64_t readIndex = 0; readIndex != numReads; ++readIndex)
+    {
+        const string name = decoder.readString();
+        const uint64_t typeCode = decoder.readVarint();
+        if (typeCode > static_cast<uint64_t>(ReadType::kOtherRead))
+        {
+            throw std::runtime_error("Invalid type of cached read " + name);
+        }
+
+        const auto type = static_cast<ReadType>(typeCode);
+        const ReadNameKey key = nameCodec_.encode(name);
+        if (type == ReadType::kIrrRead || type == ReadType::kAnchorRead)
+        {
+            irrAndAnchorLocations_.emplace(key, readRegion(decoder));
+        }
+        if (type == ReadType::kIrrRead)
+        {
+            irrUnits_.emplace(key, decoder.readString());
+        }
+        readTypes_.emplace(key, type);
+    }
+}
+
+boost::optional<ReadType> PairCollector::addAnchor(const Read& read)
 {
-    if (unparedCache_.isReadCached(read))
+    const ReadNameKey key = unparedCache_.keyOf(read);
+    if (unparedCache_.isReadCached(key))
     {
-        const ReadType mate_type = unparedCache_.typeOfRead(read);
+        const ReadType mate_type = unparedCache_.typeOfRead(key);
         if (mate_type == ReadType::kIrrRead)
         {
-            RegionWithCount irr_region = unparedCache_.extractRegionOfIrrOrAnchor(read);
-            const string irr_unit = unparedCache_.extractUnitOfIrr(read);
+            RegionWithCount irr_region = unparedCache_.extractRegionOfIrrOrAnchor(key);
+            const string irr_unit = unparedCache_.extractUnitOfIrr(key);
 
             RegionWithCount anchor_region = createCountableRegion(read.contigId, read.pos, read.pos + 1);
             anchorRegions_[irr_unit].push_back(anchor_region);
@@ -108,23 +176,26 @@ void PairCollector::addAnchor(const Read& read)
 
             logAnchoredIrr(read.name, irr_unit, irr_region, anchor_region);
         }
-        unparedCache_.eraseRead(read);
+        unparedCache_.eraseRead(key);
+        return mate_type;
     }
     else
     {
-        unparedCache_.cacheAnchorRead(read);
+        unparedCache_.cacheAnchorRead(key, read);
+        return boost::none;
     }
 }
 
-void PairCollector::addIrr(const Read& read, const std::string& unit)
+boost::optional<ReadType> PairCollector::addIrr(const Read& read, const std::string& unit)
 {
-    if (unparedCache_.isReadCached(read))
+    const ReadNameKey key = unparedCache_.keyOf(read);
+    if (unparedCache_.isReadCached(key))
     {
-        const ReadType mate_type = unparedCache_.typeOfRead(read);
+        const ReadType mate_type = unparedCache_.typeOfRead(key);
         if (mate_type == ReadType::kIrrRead)
         {
-            RegionWithCount mate_region = unparedCache_.extractRegionOfIrrOrAnchor(read);
-            const string mate_unit = unparedCache_.extractUnitOfIrr(read);
+            RegionWithCount mate_region = unparedCache_.extractRegionOfIrrOrAnchor(key);
+            const string mate_unit = unparedCache_.extractUnitOfIrr(key);
 
             RegionWithCount read_region = createCountableRegion(read.contigId, read.pos, read.pos + 1);
             logIrrPair(read.name, read_region, unit, mate_region, mate_unit);
@@ -140,28 +211,34 @@ void PairCollector::addIrr(const Read& read, const std::string& unit)
             RegionWithCount irr_region = createCountableRegion(read.contigId, read.pos, read.pos + 1);
             irrRegions_[unit].push_back(irr_region);
 
-            RegionWithCount mate_region = unparedCache_.extractRegionOfIrrOrAnchor(read);
+            RegionWithCount mate_region = unparedCache_.extractRegionOfIrrOrAnchor(key);
             anchorRegions_[unit].push_back(mate_region);
 
             logAnchoredIrr(read.name, unit, irr_region, mate_region);
         }
-        unparedCache_.eraseRead(read);
+        unparedCache_.eraseRead(key);
+        return mate_type;
     }
     else
     {
-        unparedCache_.cacheInrepeatRead(read, unit);
+        unparedCache_.cacheInrepeatRead(key, read, unit);
+        return boost::none;
     }
 }
 
-void PairCollector::addOtherRead(const Read& read)
+boost::optional<ReadType> PairCollector::addOtherRead(const Read& read)
 {
-    if (unparedCache_.isReadCached(read))
+    const ReadNameKey key = unparedCache_.keyOf(read);
+    if (unparedCache_.isReadCached(key))
     {
-        unparedCache_.eraseRead(read);
+        const ReadType mate_type = unparedCache_.typeOfRead(key);
+        unparedCache_.eraseRead(key);
+        return mate_type;
     }
     else
     {
-        unparedCache_.cacheOtherRead(read);
+        unparedCache_.cacheOtherRead(key);
+        return boost::none;
     }
 }
 
@@ -174,68 +251,90 @@ string PairCollector::PrintStats()
     return stats;
 }
 
-void PairCollector::enableReadLogging(const string& pathToReadLog)
+void PairCollector::enableReadLogging(const string& pathToReadLog, int64_t sizeOfExistingLog)
 {
-    if (logStream_)
+    if (readLogWriter_)
     {
         throw std::runtime_error("Read logging cannot be enabled twice " + pathToReadLog);
     }
 
-    logStream_.reset(new std::ofstream());
-    logStream_->open(pathToReadLog.c_str());
+    readLogWriter_.reset(new ReadLogWriter(pathToReadLog, contigInfo_, sizeOfExistingLog));
+}
+
+int64_t PairCollector::readLogSize() { return readLogWriter_ ? readLogWriter_->flush() : 0; }
 
-    if (!logStream_->is_open())
+void PairCollector::finishReadLogging()
+{
+    if (readLogWriter_)
     {
-        throw std::runtime_error("Failed to open " + pathToReadLog + " for writing (" + strerror(errno) + ")");
+        readLogWriter_->close();
     }
+}
 
-    *logStream_ << "pair_type\tmotif\tread_type\tread_pos\tmate_type\tmate_pos\tname" << std::endl;
+static void writeRegionsByUnit(
+    const std::unordered_map<string, std::vector<RegionWithCount>>& regionsByUnit, BinaryEncoder& encoder)
+{
+    encoder.writeVarint(regionsByUnit.size());
+    for (const auto& unitAndRegions : regionsByUnit)
+    {
+        encoder.writeString(unitAndRegions.first);
+        encoder.writeVarint(unitAndRegions.second.size());
+        for (const auto& region : unitAndRegions.second)
+        {
+            writeRegion(region, encoder);
+        }
+    }
 }
 
-PairCollector::~PairCollector()
+static void
+readRegionsByUnit(BinaryDecoder& decoder, std::unordered_map<string, std::vector<RegionWithCount>>& regionsByUnit)
 {
-    if (logStream_)
+    regionsByUnit.clear();
+    const uint64_t numUnits = decoder.readVarint();
+    for (uint64_t unitIndex = 0; unitIndex != numUnits; ++unitIndex)
     {
-        logStream_->close();
+        std::vector<RegionWithCount>& regions = regionsByUnit[decoder.readString()];
+        const uint64_t numRegions = decoder.readVarint();
+        regions.reserve(numRegions);
+        for (uint64_t regionIndex = 0; regionIndex != numRegions; ++regionIndex)
+        {
+            regions.push_back(readRegion(decoder));
+        }
     }
 }
 
+void PairCollector::saveState(BinaryEncoder& encoder) const
+{
+    unparedCache_.saveState(encoder);
+    writeRegionsByUnit(anchorRegions_, encoder);
+    writeRegionsByUnit(irrRegions_, encoder);
+}
+
+void PairCollector::restoreState(BinaryDecoder& decoder)
+{
+    unparedCache_.restoreState(decoder);
+    readRegionsByUnit(decoder, anchorRegions_);
+    readRegionsByUnit(decoder, irrRegions_);
+}
+
+PairCollector::~PairCollector() = default;
+
 void PairCollector::logIrrPair(
     const std::string& fragName, const GenomicRegion& readRegion, const std::string& readUnit,
     const GenomicRegion& mateRegion, const std::string& mateUnit)
 {
-    if (logStream_)
+    if (readLogWriter_)
     {
-        *logStream_ << "irr_pair\t";
-        if (readUnit <= mateUnit)
-        {
-            *logStream_ << (readUnit == mateUnit ? readUnit : readUnit + "_" + mateUnit);
-            *logStream_ << "\tirr\t" << readRegion.asString(contigInfo_);
-            *logStream_ << "\tirr\t" << mateRegion.asString(contigInfo_);
-            *logStream_ << "\t" << fragName;
-        }
-        else
-        {
-            *logStream_ << (readUnit == mateUnit ? readUnit : mateUnit + "_" + readUnit);
-            *logStream_ << "\tirr\t" << mateRegion.asString(contigInfo_);
-            *logStream_ << "\tirr\t" << readRegion.asString(contigInfo_);
-            *logStream_ << "\t" << fragName;
-        }
-
-        *logStream_ << std::endl;
+        readLogWriter_->logIrrPair(fragName, readRegion, readUnit, mateRegion, mateUnit);
     }
 }
+
 void PairCollector::logAnchoredIrr(
     const std::string& fragName, const std::string& unit, const GenomicRegion& irrRegion,
     const GenomicRegion& anchorRegion)
 {
-    if (logStream_)
+    if (readLogWriter_)
     {
-        *logStream_ << "anchored_irr\t" << unit;
-        *logStream_ << "\tirr\t" << irrRegion.asString(contigInfo_);
-        *logStream_ << "\tanchor\t" << anchorRegion.asString(contigInfo_);
-        *logStream_ << "\t" << fragName;
-
-        *logStream_ << std::endl;
+        readLogWriter_->logAnchoredIrr(fragName, unit, irrRegion, anchorRegion);
     }
 }
@@ -21,11 +21,15 @@
 
 #pragma once
 
-#include <fstream>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include <boost/optional.hpp>
+
+#include "common/BinaryCoding.hh"
+#include "profile/ReadLogWriter.hh"
+#include "profile/ReadNameCodec.hh"
 #include "reads/Read.hh"
 #include "region/GenomicRegion.hh"
 
@@ -43,23 +47,30 @@ enum class PairType
     kOtherPair
 };
 
+// Reads waiting for their mates, keyed by the packed names of the reads
 class ReadCache
 {
 public:
-    bool isReadCached(const Read& read);
-    ReadType typeOfRead(const Read& read);
-    void eraseRead(const Read& read);
-    RegionWithCount extractRegionOfIrrOrAnchor(const Read& read);
-    std::string extractUnitOfIrr(const Read& read);
-    void cacheAnchorRead(const Read& read);
-    void cacheInrepeatRead(const Read& read, const std::string& unit);
-    void cacheOtherRead(const Read& read);
+    // Key of the read name; keys of names that cannot be packed stay reserved until the read is erased
+    ReadNameKey keyOf(const Read& read) { return nameCodec_.encode(read.name); }
+    bool isReadCached(const ReadNameKey& key) const;
+    ReadType typeOfRead(const ReadNameKey& key) const;
+    void eraseRead(const ReadNameKey& key);
+    RegionWithCount extractRegionOfIrrOrAnchor(const ReadNameKey& key) const;
+    std::string extractUnitOfIrr(const ReadNameKey& key) const;
+    void cacheAnchorRead(const ReadNameKey& key, const Read& read);
+    void cacheInrepeatRead(const ReadNameKey& key, const Read& read, const std::string& unit);
+    void cacheOtherRead(const ReadNameKey& key);
     std::string printStats();
 
+    void saveState(BinaryEncoder& encoder) const;
+    void restoreState(BinaryDecoder& decoder);
+
 private:
-    std::unordered_map<std::string, ReadType> readTypes_;
-    std::unordered_map<std::string, RegionWithCount> irrAndAnchorLocations_;
-    std::unordered_map<std::string, std::string> irrUnits_;
+    ReadNameCodec nameCodec_;
+    std::unordered_map<ReadNameKey, ReadType, ReadNameKeyHash> readTypes_;
+    std::unordered_map<ReadNameKey, RegionWithCount, ReadNameKeyHash> irrAndAnchorLocations_;
+    std::unordered_map<ReadNameKey, std::string, ReadNameKeyHash> irrUnits_;
 };
 
 class PairCollector
@@ -70,14 +81,25 @@ public:
     {
     }
     ~PairCollector();
-    void addAnchor(const Read& read);
-    void addIrr(const Read& read, const std::string& unit);
-    void addOtherRead(const Read& read);
+    // Each of the following returns the type of the previously added mate of the read or none if the mate is yet to
+    // be added
+    boost::optional<ReadType> addAnchor(const Read& read);
+    boost::optional<ReadType> addIrr(const Read& read, const std::string& unit);
+    boost::optional<ReadType> addOtherRead(const Read& read);
     std::string PrintStats();
     const std::unordered_map<std::string, std::vector<RegionWithCount>>& anchorRegions() { return anchorRegions_; }
     const std::unordered_map<std::string, std::vector<RegionWithCount>>& irrRegions() { return irrRegions_; };
 
-    void enableReadLogging(const std::string& pathToReadLog);
+    // Reads are appended to an existing log truncated to the given size if it is not negative
+    void enableReadLogging(const std::string& pathToReadLog, int64_t sizeOfExistingLog = -1);
+    // Size of the read log once all pairs collected so far are written to it; zero if reads are not logged
+    int64_t readLogSize();
+    // Writes the remaining pairs to the read log and closes it
+    void finishReadLogging();
+
+    // Saves and restores the cached reads and the collected regions, e.g. to resume an interrupted run
+    void saveState(BinaryEncoder& encoder) const;
+    void restoreState(BinaryDecoder& decoder);
 
 private:
     void logIrrPair(
@@ -94,5 +116,5 @@ private:
     std::unordered_map<std::string, std::vector<RegionWithCount>> anchorRegions_;
     std::unordered_map<std::string, std::vector<RegionWithCount>> irrRegions_;
 
-    std::unique_ptr<std::ofstream> logStream_;
+    std::unique_ptr<ReadLogWriter> readLogWriter_;
 };
@@ -0,0 +1,166 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ProfileCheckpoint.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "common/BinaryCoding.hh"
+
+using std::string;
+using std::to_string;
+
+static const char kMagic[] = { 'E', 'H', 'D', 'N', 'C', 'K', 'P', 'T' };
+// Version 3 restores the flag for sample statistics taken from the index, which version 2 dropped
+static const uint64_t kFormatVersion = 3;
+static const size_t kChecksumSize = 8;
+
+static uint32_t computeChecksum(const char* bytes, size_t numBytes)
+{
+    const uLong checksum = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(bytes), numBytes);
+    return static_cast<uint32_t>(checksum);
+}
+
+static void writeFileDurably(const string& path, const string& contents)
+{
+    const int fileDescriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor == -1)
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing (" + strerror(errno) + ")");
+    }
+
+    size_t numBytesWritten = 0;
+    while (numBytesWritten != contents.size())
+    {
+        const ssize_t numBytes
+            = write(fileDescriptor, contents.data() + numBytesWritten, contents.size() - numBytesWritten);
+        if (numBytes == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numBytes == -1)
+        {
+            const int error = errno;
+            close(fileDescriptor);
+            throw std::runtime_error("Failed to write " + path + " (" + strerror(error) + ")");
+        }
+        numBytesWritten += numBytes;
+    }
+
+    if (fsync(fileDescriptor) != 0)
+    {
+        const int error = errno;
+        close(fileDescriptor);
+        throw std::runtime_error("Failed to write " + path + " (" + strerror(error) + ")");
+    }
+
+    if (close(fileDescriptor) != 0)
+    {
+        throw std::runtime_error("Failed to write " + path + " (" + strerror(errno) + ")");
+    }
+}
+
+void saveProfileCheckpoint(
+    const string& path, const string& runKey, const ProfileCheckpoint& checkpoint,
+    const SampleRunStatsCalculator& statsCalculator, const PairCollector& pairCollector)
+{
+    BinaryEncoder encoder;
+    encoder.writeBytes(kMagic, sizeof(kMagic));
+    encoder.writeVarint(kFormatVersion);
+    encoder.writeString(runKey);
+    encoder.writeVarint(checkpoint.numReads);
+    encoder.writeSignedVarint(checkpoint.streamPosition.virtualOffset);
+    encoder.writeVarint(checkpoint.streamPosition.numRecordsRead);
+    encoder.writeSignedVarint(checkpoint.readLogSize);
+    statsCalculator.saveState(encoder);
+    pairCollector.saveState(encoder);
+    encoder.writeFixed64(computeChecksum(encoder.buffer().data(), encoder.buffer().size()));
+
+    const string temporaryPath = path + ".tmp";
+    writeFileDurably(temporaryPath, encoder.buffer());
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        throw std::runtime_error("Failed to rename " + temporaryPath + " to " + path + " (" + strerror(errno) + ")");
+    }
+}
+
+ProfileCheckpoint loadProfileCheckpoint(
+    const string& path, const string& runKey, SampleRunStatsCalculator& statsCalculator, PairCollector& pairCollector)
+{
+    std::ifstream checkpointFile(path, std::ios::binary);
+    if (!checkpointFile)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    std::ostringstream contents;
+    contents << checkpointFile.rdbuf();
+    const string bytes = contents.str();
+
+    if (bytes.size() < sizeof(kMagic) + kChecksumSize || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0)
+    {
+        throw std::runtime_error(path + " is not a checkpoint of a profile run");
+    }
+
+    const size_t checksumOffset = bytes.size() - kChecksumSize;
+    BinaryDecoder checksumDecoder(bytes.data() + checksumOffset, bytes.data() + bytes.size());
+    if (checksumDecoder.readFixed64() != computeChecksum(bytes.data(), checksumOffset))
+    {
+        throw std::runtime_error("Checkpoint " + path + " is corrupted");
+    }
+
+    BinaryDecoder decoder(bytes.data() + sizeof(kMagic), bytes.data() + checksumOffset);
+    const uint64_t version = decoder.readVarint();
+    if (version != kFormatVersion)
+    {
+        throw std::runtime_error("Unsupported version of checkpoint format " + to_string(version));
+    }
+
+    if (decoder.readString() != runKey)
+    {
+        throw std::runtime_error("Checkpoint " + path + " was saved by a run with different reads or parameters");
+    }
+
+    ProfileCheckpoint checkpoint;
+    checkpoint.numReads = static_cast<int64_t>(decoder.readVarint());
+    checkpoint.streamPosition.virtualOffset = decoder.readSignedVarint();
+    checkpoint.streamPosition.numRecordsRead = static_cast<int64_t>(decoder.readVarint());
+    checkpoint.readLogSize = decoder.readSignedVarint();
+    statsCalculator.restoreState(decoder);
+    pairCollector.restoreState(decoder);
+
+    if (!decoder.atEnd())
+    {
+        throw std::runtime_error("Unexpected trailing data in " + path);
+    }
+
+    return checkpoint;
+}
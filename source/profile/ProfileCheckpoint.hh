@@ -0,0 +1,60 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checkpoints of profile runs that allow an interrupted run to continue streaming the reads where it stopped. A
+// checkpoint consists of
+//
+//   - an 8-byte magic string followed by the format version,
+//   - the key of the run combining the fingerprint of the reads with the parameters of the run,
+//   - the number of analyzed reads, the position of the next record in the file with reads, and the size of the read
+//     log written so far,
+//   - the counters of the sample statistics, the reads waiting for their mates, and the collected regions,
+//   - the CRC32 checksum of all preceding bytes.
+//
+// Checkpoints are written to a temporary file that is synced and renamed over the previous checkpoint, so a run
+// killed while writing a checkpoint leaves the previous checkpoint intact.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "io/HtsFileStreamer.hh"
+#include "profile/PairCollector.hh"
+#include "profile/SampleRunStats.hh"
+
+struct ProfileCheckpoint
+{
+    int64_t numReads = 0;
+    HtsStreamPosition streamPosition;
+    // Size of the read log; negative if reads are not logged
+    int64_t readLogSize = -1;
+};
+
+void saveProfileCheckpoint(
+    const std::string& path, const std::string& runKey, const ProfileCheckpoint& checkpoint,
+    const SampleRunStatsCalculator& statsCalculator, const PairCollector& pairCollector);
+
+// Restores the sample statistics counters and the state of the pair collector; throws if the checkpoint was saved by
+// a run with a different key
+ProfileCheckpoint loadProfileCheckpoint(
+    const std::string& path, const std::string& runKey, SampleRunStatsCalculator& statsCalculator,
+    PairCollector& pairCollector);
@@ -22,6 +22,7 @@
 #include "profile/ProfileParameters.hh"
 
 #include <memory>
+#include <stdexcept>
 
 #include <boost/filesystem.hpp>
 
@@ -31,20 +32,55 @@ using std::string;
 
 ProfileWorkflowParameters::ProfileWorkflowParameters(
     const string& outputPrefix, bool logReads, string pathToReads, string pathToReference, Interval motifSizeRange,
-    int minMapqOfAnchorRead, int maxMapqOfInrepeatRead)
-    : profilePath_(outputPrefix + ".str_profile.json")
-    , pathToLocusTable_(outputPrefix + ".locus.tsv")
+    int minMapqOfAnchorRead, int maxMapqOfInrepeatRead, const ProfileWorkflowOptions& options)
+    : profilePath_(
+        outputPrefix + (options.profileFormat == StrProfileFormat::kJson ? ".str_profile.json" : ".str_profile.bin"))
+    , profileFormat_(options.profileFormat)
+    , compressProfile_(options.compressProfile)
+    , pathToProfileBundle_(options.pathToProfileBundle)
+    , sampleId_(options.sampleId)
+    , pathToLocusTable_(outputPrefix + (options.compressLocusTable ? ".locus.tsv.gz" : ".locus.tsv"))
+    , compressLocusTable_(options.compressLocusTable)
     , pathToMotifTable_(outputPrefix + ".motif.tsv")
     , pathToReads_(std::move(pathToReads))
     , pathToReference_(std::move(pathToReference))
     , motifSizeRange_(std::move(motifSizeRange))
     , minMapqOfAnchorRead_(minMapqOfAnchorRead)
     , maxMapqOfInrepeatRead_(maxMapqOfInrepeatRead)
+    , binSize_(options.binSize)
+    , pathToCache_(options.pathToCache)
+    , hashInputContent_(options.hashInputContent)
+    , pathToInputSidecar_(options.pathToInputSidecar)
+    , pathToCheckpoint_(outputPrefix + ".checkpoint")
+    , checkpointInterval_(options.checkpointInterval)
+    , resume_(options.resume)
+    , numThreads_(options.numThreads)
+    , estimateStatsFromIndex_(options.estimateStatsFromIndex)
 {
     if (logReads)
     {
         pathToReadLog_ = outputPrefix + ".reads.tsv";
     }
+
+    if (options.writeSidecar)
+    {
+        pathToSidecar_ = outputPrefix + ".sidecar.bin";
+    }
+
+    if (options.writeEvidenceBam)
+    {
+        pathToEvidenceBam_ = outputPrefix + ".evidence.bam";
+    }
+
+    if (options.compressProfile)
+    {
+        profilePath_ += ".gz";
+    }
+
+    if (sampleId_.empty())
+    {
+        sampleId_ = fs::path(outputPrefix).filename().string();
+    }
 }
 
 /*
@@ -240,6 +276,57 @@ static void assertPathToExistingFile(const string& pathEncoding)
 
 void assertValidity(const ProfileWorkflowParameters& parameters)
 {
-    assertPathToExistingFile(parameters.pathToReads());
-    assertPathToExistingFile(parameters.pathToReference());
+    if (!parameters.pathToInputSidecar().empty())
+    {
+        assertPathToExistingFile(parameters.pathToInputSidecar());
+        if (parameters.pathToSidecar())
+        {
+            throw std::invalid_argument("Sidecar cannot be written when the profile is computed from a sidecar");
+        }
+    }
+    else
+    {
+        assertPathToExistingFile(parameters.pathToReads());
+        assertPathToExistingFile(parameters.pathToReference());
+    }
+
+    if (parameters.binSize() < 0)
+    {
+        throw std::invalid_argument("Bin size cannot be negative");
+    }
+
+    if (!parameters.pathToProfileBundle().empty() && parameters.sampleId().empty())
+    {
+        throw std::invalid_argument("Sample id must be set to append the profile to a bundle");
+    }
+
+    if (!parameters.pathToProfileBundle().empty() && parameters.compressProfile())
+    {
+        throw std::invalid_argument("Profiles appended to a bundle cannot be compressed");
+    }
+
+    if (parameters.checkpointInterval() < 0)
+    {
+        throw std::invalid_argument("Checkpoint interval cannot be negative");
+    }
+
+    // Checkpoints only hold the state of the profile and the read log; a resumed run would silently miss the
+    // fragments and alignments that sidecars and evidence bamlets received before the checkpoint
+    const bool usesCheckpoints = parameters.checkpointInterval() != 0 || parameters.resume();
+    if (usesCheckpoints && (parameters.pathToSidecar() || !parameters.pathToInputSidecar().empty()))
+    {
+        throw std::invalid_argument("Checkpoints and --resume cannot be combined with sidecars");
+    }
+
+    if (parameters.numThreads() < 1)
+    {
+        throw std::invalid_argument("Number of threads must be positive");
+    }
+
+    if (parameters.pathToEvidenceBam() && (usesCheckpoints || !parameters.pathToInputSidecar().empty()))
+    {
+        throw std::invalid_argument(
+            "Evidence bamlet can only be written when all reads are streamed in a single run without checkpoints or "
+            "--resume");
+    }
 }
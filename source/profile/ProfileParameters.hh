@@ -26,16 +26,57 @@
 #include <boost/optional.hpp>
 
 #include "common/Interval.hh"
+#include "io/StrProfile.hh"
+
+// Optional settings of the profile workflow; the defaults analyze the reads once and write a plain JSON profile
+struct ProfileWorkflowOptions
+{
+    StrProfileFormat profileFormat = StrProfileFormat::kJson;
+    // Write the profile compressed with BGZF
+    bool compressProfile = false;
+    // Size of the reference bins of anchored IRR counts recorded in the profile; zero disables binning
+    int binSize = 0;
+    // Bundle that the profile is appended to in place of writing the profile file; empty if not set
+    std::string pathToProfileBundle;
+    // Id of the sample in the bundle; defaults to the file name of the output prefix
+    std::string sampleId;
+    // Directory with cached outputs of earlier runs; empty if caching is disabled
+    std::string pathToCache;
+    // Include a checksum of the entire file with reads in its fingerprint
+    bool hashInputContent = false;
+    bool writeSidecar = false;
+    // Sidecar that the profile is recomputed from in place of the file with reads; empty if not set
+    std::string pathToInputSidecar;
+    // Seconds between checkpoints of the analysis; zero disables checkpoints
+    int checkpointInterval = 0;
+    bool resume = false;
+    bool writeEvidenceBam = false;
+    // Threads compressing the evidence bamlet, the locus table, and the profile
+    int numThreads = 1;
+    // Write the locus table coordinate-sorted, compressed with BGZF, and indexed with tabix
+    bool compressLocusTable = false;
+    // Estimate depth and read length from the index and the first reads instead of from all reads
+    bool estimateStatsFromIndex = false;
+};
 
 class ProfileWorkflowParameters
 {
 public:
     ProfileWorkflowParameters(
         const std::string& outputPrefix, bool logReads, std::string pathToReads, std::string pathToReference,
-        Interval motifSizeRange, int minMapqOfAnchorRead, int maxMapqOfInrepeatRead);
+        Interval motifSizeRange, int minMapqOfAnchorRead, int maxMapqOfInrepeatRead,
+        const ProfileWorkflowOptions& options = ProfileWorkflowOptions());
 
     const std::string& profilePath() const { return profilePath_; }
+    StrProfileFormat profileFormat() const { return profileFormat_; }
+    // Write the profile compressed with BGZF
+    bool compressProfile() const { return compressProfile_; }
+    // Bundle that the profile is appended to in place of writing the profile file; empty if not set
+    const std::string& pathToProfileBundle() const { return pathToProfileBundle_; }
+    const std::string& sampleId() const { return sampleId_; }
     const std::string& pathToLocusTable() const { return pathToLocusTable_; }
+    // Write the locus table coordinate-sorted, compressed with BGZF, and indexed with tabix
+    bool compressLocusTable() const { return compressLocusTable_; }
     const std::string& pathToMotifTable() const { return pathToMotifTable_; }
     const std::string& pathToReads() const { return pathToReads_; }
     const std::string& pathToReference() const { return pathToReference_; }
@@ -43,10 +84,36 @@ public:
     const Interval& motifSizeRange() const { return motifSizeRange_; }
     int minMapqOfAnchorRead() const { return minMapqOfAnchorRead_; }
     int maxMapqOfInrepeatRead() const { return maxMapqOfInrepeatRead_; }
+    // Size of the reference bins of anchored IRR counts recorded in the profile; zero disables binning
+    int binSize() const { return binSize_; }
+    // Directory with cached outputs of earlier runs; empty if caching is disabled
+    const std::string& pathToCache() const { return pathToCache_; }
+    // Include a checksum of the entire file with reads in its fingerprint
+    bool hashInputContent() const { return hashInputContent_; }
+    // Sidecar of informative reads written while the reads are streamed
+    const boost::optional<std::string>& pathToSidecar() const { return pathToSidecar_; }
+    // Sidecar that the profile is recomputed from in place of the file with reads; empty if not set
+    const std::string& pathToInputSidecar() const { return pathToInputSidecar_; }
+    const std::string& pathToCheckpoint() const { return pathToCheckpoint_; }
+    // Seconds between checkpoints of the analysis; zero disables checkpoints
+    int checkpointInterval() const { return checkpointInterval_; }
+    // Continue the analysis from the checkpoint if it exists
+    bool resume() const { return resume_; }
+    // Bamlet with the alignments of informative fragments
+    const boost::optional<std::string>& pathToEvidenceBam() const { return pathToEvidenceBam_; }
+    // Threads compressing the evidence bamlet, the locus table, and the profile
+    int numThreads() const { return numThreads_; }
+    // Estimate depth and read length from the index and the first reads instead of from all reads
+    bool estimateStatsFromIndex() const { return estimateStatsFromIndex_; }
 
 private:
     std::string profilePath_;
+    StrProfileFormat profileFormat_;
+    bool compressProfile_;
+    std::string pathToProfileBundle_;
+    std::string sampleId_;
     std::string pathToLocusTable_;
+    bool compressLocusTable_;
     std::string pathToMotifTable_;
     std::string pathToReads_;
     std::string pathToReference_;
@@ -54,6 +121,17 @@ private:
     Interval motifSizeRange_;
     int minMapqOfAnchorRead_;
     int maxMapqOfInrepeatRead_;
+    int binSize_;
+    std::string pathToCache_;
+    bool hashInputContent_;
+    boost::optional<std::string> pathToSidecar_;
+    std::string pathToInputSidecar_;
+    std::string pathToCheckpoint_;
+    int checkpointInterval_;
+    bool resume_;
+    boost::optional<std::string> pathToEvidenceBam_;
+    int numThreads_;
+    bool estimateStatsFromIndex_;
 };
 
 void assertValidity(const ProfileWorkflowParameters& parameters);
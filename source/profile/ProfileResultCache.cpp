@@ -0,0 +1,224 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ProfileResultCache.hh"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <zlib.h>
+
+namespace fs = boost::filesystem;
+
+using boost::optional;
+using std::string;
+using std::to_string;
+using std::vector;
+
+// Bumped whenever the outputs of the workflow change for the same reads and parameters, so stale entries are not reused
+static const char kCacheVersion[] = "2";
+
+// 64-bit FNV-1a hash; collisions only matter between runs cached in the same directory
+class Fingerprinter
+{
+public:
+    void add(const char* bytes, size_t numBytes)
+    {
+        for (size_t index = 0; index != numBytes; ++index)
+        {
+            hash_ ^= static_cast<uint8_t>(bytes[index]);
+            hash_ *= 1099511628211ULL;
+        }
+    }
+
+    void add(const string& value)
+    {
+        add(static_cast<uint64_t>(value.size()));
+        add(value.data(), value.size());
+    }
+
+    void add(uint64_t value)
+    {
+        char bytes[8];
+        for (int byteIndex = 0; byteIndex != 8; ++byteIndex)
+        {
+            bytes[byteIndex] = static_cast<char>((value >> (8 * byteIndex)) & 0xff);
+        }
+        add(bytes, sizeof(bytes));
+    }
+
+    string hexDigest() const
+    {
+        char digest[17];
+        std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(hash_));
+        return digest;
+    }
+
+private:
+    uint64_t hash_ = 14695981039346656037ULL;
+};
+
+static uint32_t computeFileChecksum(const string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    vector<char> buffer(1 << 20);
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    while (file)
+    {
+        file.read(buffer.data(), buffer.size());
+        checksum = crc32(checksum, reinterpret_cast<const Bytef*>(buffer.data()), file.gcount());
+    }
+
+    return static_cast<uint32_t>(checksum);
+}
+
+static string findIndex(const string& pathToReads)
+{
+    const fs::path path(pathToReads);
+    const vector<string> candidates
+        = { pathToReads + ".bai", pathToReads + ".csi", pathToReads + ".crai",
+            fs::path(path).replace_extension(".bai").string(), fs::path(path).replace_extension(".crai").string() };
+    for (const auto& candidate : candidates)
+    {
+        if (fs::exists(candidate))
+        {
+            return candidate;
+        }
+    }
+
+    return "";
+}
+
+string computeInputFingerprint(const string& pathToReads, const string& headerText, bool hashContent)
+{
+    struct stat fileStatus;
+    if (stat(pathToReads.c_str(), &fileStatus) != 0)
+    {
+        throw std::runtime_error("Unable to access " + pathToReads);
+    }
+
+    Fingerprinter fingerprinter;
+    fingerprinter.add(static_cast<uint64_t>(fileStatus.st_size));
+    fingerprinter.add(static_cast<uint64_t>(fileStatus.st_mtim.tv_sec));
+    fingerprinter.add(static_cast<uint64_t>(fileStatus.st_mtim.tv_nsec));
+    fingerprinter.add(headerText);
+
+    const string pathToIndex = findIndex(pathToReads);
+    fingerprinter.add(pathToIndex.empty() ? 0 : computeFileChecksum(pathToIndex));
+
+    string fingerprint = fingerprinter.hexDigest();
+    if (hashContent)
+    {
+        char checksum[9];
+        std::snprintf(checksum, sizeof(checksum), "%08x", computeFileChecksum(pathToReads));
+        fingerprint += string("-") + checksum;
+    }
+
+    return fingerprint;
+}
+
+string computeProfileCacheKey(const string& inputFingerprint, const ProfileWorkflowParameters& parameters)
+{
+    Fingerprinter fingerprinter;
+    fingerprinter.add(kCacheVersion);
+    fingerprinter.add(static_cast<uint64_t>(parameters.motifSizeRange().start()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.motifSizeRange().end()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.minMapqOfAnchorRead()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.maxMapqOfInrepeatRead()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.binSize()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.profileFormat()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.compressLocusTable()));
+    fingerprinter.add(static_cast<uint64_t>(parameters.estimateStatsFromIndex()));
+    return inputFingerprint + "-" + fingerprinter.hexDigest();
+}
+
+static const char kProfileFile[] = "str_profile";
+static const char kLocusTableFile[] = "locus.tsv";
+static const char kMotifTableFile[] = "motif.tsv";
+
+ProfileResultCache::ProfileResultCache(string directory)
+    : directory_(std::move(directory))
+{
+    fs::create_directories(directory_);
+}
+
+optional<CachedProfileOutputs> ProfileResultCache::find(const string& key) const
+{
+    const fs::path entry = fs::path(directory_) / key;
+    std::ifstream profileFile((entry / kProfileFile).string(), std::ios::binary);
+    if (!profileFile)
+    {
+        return boost::none;
+    }
+
+    CachedProfileOutputs outputs;
+    outputs.profileEncoding.assign(
+        (std::istreambuf_iterator<char>(profileFile)), std::istreambuf_iterator<char>());
+    outputs.pathToLocusTable = (entry / kLocusTableFile).string();
+    outputs.pathToMotifTable = (entry / kMotifTableFile).string();
+    if (!fs::exists(outputs.pathToLocusTable) || !fs::exists(outputs.pathToMotifTable))
+    {
+        return boost::none;
+    }
+
+    return outputs;
+}
+
+void ProfileResultCache::store(
+    const string& key, const string& profileEncoding, const string& pathToLocusTable,
+    const string& pathToMotifTable) const
+{
+    const fs::path entry = fs::path(directory_) / key;
+    const fs::path temporaryEntry = fs::path(directory_) / (key + ".tmp" + to_string(getpid()));
+    fs::remove_all(temporaryEntry);
+    fs::create_directory(temporaryEntry);
+
+    std::ofstream profileFile((temporaryEntry / kProfileFile).string(), std::ios::binary);
+    profileFile.write(profileEncoding.data(), profileEncoding.size());
+    profileFile.close();
+    if (!profileFile)
+    {
+        fs::remove_all(temporaryEntry);
+        throw std::runtime_error("Failed to write profile to cache " + directory_);
+    }
+    fs::copy_file(pathToLocusTable, temporaryEntry / kLocusTableFile);
+    fs::copy_file(pathToMotifTable, temporaryEntry / kMotifTableFile);
+
+    // Renaming fails if another run published the same entry first, in which case its entry is kept
+    boost::system::error_code error;
+    fs::rename(temporaryEntry, entry, error);
+    if (error)
+    {
+        fs::remove_all(temporaryEntry);
+    }
+}
@@ -0,0 +1,61 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Outputs of profile runs are cached under a key combining a fingerprint of the file with reads and the parameters
+// that affect the outputs, so that re-running the workflow on an unchanged file does not stream it again.
+
+#pragma once
+
+#include <string>
+
+#include <boost/optional.hpp>
+
+#include "profile/ProfileParameters.hh"
+
+// Fingerprint of a BAM or CRAM file computed from its header, its index, and its size and modification time; the
+// content of the file is only hashed if requested since this requires reading the whole file
+std::string computeInputFingerprint(const std::string& pathToReads, const std::string& headerText, bool hashContent);
+
+std::string computeProfileCacheKey(const std::string& inputFingerprint, const ProfileWorkflowParameters& parameters);
+
+struct CachedProfileOutputs
+{
+    std::string profileEncoding;
+    std::string pathToLocusTable;
+    std::string pathToMotifTable;
+};
+
+// Directory with an entry for each cached run; entries are published by renaming complete temporary directories, so
+// concurrent runs never observe partial entries
+class ProfileResultCache
+{
+public:
+    explicit ProfileResultCache(std::string directory);
+
+    // Returns the encoded profile and the paths to the cached tables if the key is in the cache
+    boost::optional<CachedProfileOutputs> find(const std::string& key) const;
+    void store(
+        const std::string& key, const std::string& profileEncoding, const std::string& pathToLocusTable,
+        const std::string& pathToMotifTable) const;
+
+private:
+    std::string directory_;
+};
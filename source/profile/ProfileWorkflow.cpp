@@ -21,21 +21,43 @@
 
 #include "profile/ProfileWorkflow.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
+#include <functional>
+#include <memory>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
-#include "thirdparty/nlohmann_json/json.hpp"
+#include <boost/filesystem.hpp>
+
+#include "thirdparty/spdlog/fmt/fmt.h"
 #include "thirdparty/spdlog/spdlog.h"
 
+#include "common/ParallelWork.hh"
+#include "io/CompressedFile.hh"
+#include "io/EvidenceBamWriter.hh"
 #include "io/HtsFileStreamer.hh"
+#include "io/IndexedTable.hh"
+#include "io/ProfileBundle.hh"
+#include "io/StrProfile.hh"
 #include "profile/PairCollector.hh"
+#include "profile/ProfileCheckpoint.hh"
+#include "profile/ProfileResultCache.hh"
 #include "profile/ReadClassification.hh"
+#include "profile/ReadSidecar.hh"
 #include "profile/SampleRunStats.hh"
 
+namespace fs = boost::filesystem;
+
 using std::set;
 using std::string;
 using std::unordered_map;
@@ -58,54 +80,40 @@ set<string> getTargetRepeatUnits(const RegionsByUnit& irrRegions, Interval targe
     return units;
 }
 
-void outputProfile(
-    const string& profilePath, const SampleRunStats& sampleStats, const RegionsByUnit& irrAnchorRegions,
-    const RegionsByUnit& irrRegions, const set<string>& targetUnits, const ReferenceContigInfo& contigInfo)
+StrProfile createStrProfile(
+    const SampleRunStats& sampleStats, const RegionsByUnit& irrAnchorRegions, const RegionsByUnit& irrRegions,
+    const set<string>& targetUnits, const ReferenceContigInfo& contigInfo, int binSize)
 {
-    nlohmann::json output;
-    output["ReadLength"] = sampleStats.meanReadLength();
-    output["Depth"] = sampleStats.depth();
+    StrProfile profile(contigInfo);
+    profile.readLength = sampleStats.meanReadLength();
+    profile.depth = sampleStats.depth();
+    profile.binSize = binSize;
 
     for (const auto& unit : targetUnits)
     {
-        output[unit]["RepeatUnit"] = unit;
+        MotifRecord& record = profile.motifRecords[unit];
 
-        size_t ancIrrCount = 0;
         bool foundAncIrrs = irrAnchorRegions.find(unit) != irrAnchorRegions.end();
         if (foundAncIrrs)
         {
-            ancIrrCount = irrAnchorRegions.at(unit).size();
+            record.anchoredIrrCount = irrAnchorRegions.at(unit).size();
         }
 
-        size_t irrPairCount = (irrRegions.at(unit).size() - ancIrrCount) / 2;
-
-        output[unit]["AnchoredIrrCount"] = ancIrrCount;
-        output[unit]["IrrPairCount"] = irrPairCount;
+        record.irrPairCount = (irrRegions.at(unit).size() - record.anchoredIrrCount) / 2;
 
         if (foundAncIrrs)
         {
-            vector<RegionWithCount> mergedRegionsWithAnchors = irrAnchorRegions.at(unit);
-            sortAndMerge(mergedRegionsWithAnchors);
-
-            for (const auto& region : mergedRegionsWithAnchors)
+            if (binSize != 0)
             {
-                const string regionEncoding = region.asString(contigInfo);
-                output[unit]["RegionsWithIrrAnchors"][regionEncoding] = region.feature().value();
+                record.irrAnchorBins = computeIrrAnchorBins(irrAnchorRegions.at(unit), binSize);
             }
-        }
-    }
 
-    std::ofstream profileStream;
-    profileStream.open(profilePath.c_str());
-
-    if (!profileStream.is_open())
-    {
-        throw std::runtime_error(
-            "Failed to open output JSON file " + profilePath + " for writing (" + strerror(errno) + ")");
+            record.regionsWithIrrAnchors = irrAnchorRegions.at(unit);
+            sortAndMerge(record.regionsWithIrrAnchors);
+        }
     }
 
-    profileStream << output.dump(4) << std::endl;
-    profileStream.close();
+    return profile;
 }
 
 int getNumUnitsSpanned(double sampleDepth, int readLength, int unitLen, int numIrrs)
@@ -122,136 +130,485 @@ double depthNormalize(double sampleDepth, int numIrrs, double targetDepth = 30.0
     return (numIrrs * targetDepth) / sampleDepth;
 }
 
-void outputLocusTable(
-    const string& tablePath, const SampleRunStats& sampleStats, const RegionsByUnit& irrAnchorRegions,
-    const set<string>& targetUnits, const ReferenceContigInfo& contigInfo)
-{
-    std::ofstream tableStream;
-    tableStream.open(tablePath.c_str());
+// Tables are written in blocks of this size
+static const size_t kTableBlockSize = 1 << 20;
 
+static void openTable(const string& tablePath, std::ofstream& tableStream)
+{
+    tableStream.open(tablePath.c_str(), std::ios::binary);
     if (!tableStream.is_open())
     {
         throw std::runtime_error("Failed to open output file " + tablePath + " for writing (" + strerror(errno) + ")");
     }
+}
 
-    tableStream << std::setprecision(2) << std::fixed;
-    tableStream << "contig\tstart\tend\tmotif\tnum_anc_irrs\tnorm_num_anc_irrs\thet_str_size" << std::endl;
-    for (const auto& unit : targetUnits)
+static void writeTableBlock(fmt::memory_buffer& block, std::ofstream& tableStream)
+{
+    tableStream.write(block.data(), block.size());
+    block.clear();
+}
+
+static void closeTable(const string& tablePath, fmt::memory_buffer& block, std::ofstream& tableStream)
+{
+    writeTableBlock(block, tableStream);
+    tableStream.close();
+    if (!tableStream)
     {
-        if (irrAnchorRegions.find(unit) == irrAnchorRegions.end())
-        {
-            continue;
-        }
+        throw std::runtime_error("Failed to write " + tablePath);
+    }
+}
 
-        vector<RegionWithCount> mergedRegionsWithAnchors = irrAnchorRegions.at(unit);
-        sortAndMerge(mergedRegionsWithAnchors);
+// Plain tables list the regions of each motif in turn while compressed tables are sorted by position for indexing
+static void outputLocusTable(const string& tablePath, const StrProfile& profile, bool isCompressed, int numThreads)
+{
+    std::ofstream tableStream;
+    std::unique_ptr<IndexedTableWriter> indexedTableWriter;
+    if (isCompressed)
+    {
+        indexedTableWriter.reset(new IndexedTableWriter(tablePath, numThreads));
+    }
+    else
+    {
+        openTable(tablePath, tableStream);
+    }
 
-        for (const auto& region : mergedRegionsWithAnchors)
+    vector<std::pair<const string*, const RegionWithCount*>> unitsAndRegions;
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        for (const auto& region : motifAndRecord.second.regionsWithIrrAnchors)
         {
-            if (region.contigId() == -1)
+            if (region.contigId() != -1)
             {
-                continue;
+                unitsAndRegions.emplace_back(&motifAndRecord.first, &region);
             }
+        }
+    }
 
-            const string& contigName = contigInfo.getContigName(region.contigId());
-            const int numIrrs = region.feature().value();
-            const double normNumIrrs = depthNormalize(sampleStats.depth(), numIrrs);
+    if (isCompressed)
+    {
+        std::stable_sort(
+            unitsAndRegions.begin(), unitsAndRegions.end(),
+            [](const std::pair<const string*, const RegionWithCount*>& unitAndRegion,
+               const std::pair<const string*, const RegionWithCount*>& otherUnitAndRegion) {
+                const RegionWithCount& region = *unitAndRegion.second;
+                const RegionWithCount& otherRegion = *otherUnitAndRegion.second;
+                return std::make_tuple(region.contigId(), region.start(), region.end())
+                    < std::make_tuple(otherRegion.contigId(), otherRegion.start(), otherRegion.end());
+            });
+    }
 
-            const int numUnitsSpanned
-                = getNumUnitsSpanned(sampleStats.depth(), sampleStats.meanReadLength(), unit.length(), numIrrs);
-            tableStream << contigName << "\t" << region.start() << "\t" << region.end() << "\t" << unit << "\t"
-                        << numIrrs << "\t" << normNumIrrs << "\t" << numUnitsSpanned << std::endl;
+    fmt::memory_buffer block;
+    const auto writeBlock = [&]() {
+        if (indexedTableWriter)
+        {
+            indexedTableWriter->write(block.data(), block.size());
+            block.clear();
+        }
+        else
+        {
+            writeTableBlock(block, tableStream);
+        }
+    };
+
+    fmt::format_to(block, "contig\tstart\tend\tmotif\tnum_anc_irrs\tnorm_num_anc_irrs\thet_str_size\n");
+    for (const auto& unitAndRegion : unitsAndRegions)
+    {
+        const string& unit = *unitAndRegion.first;
+        const RegionWithCount& region = *unitAndRegion.second;
+        const int numIrrs = region.feature().value();
+        const double normNumIrrs = depthNormalize(profile.depth, numIrrs);
+        const int numUnitsSpanned = getNumUnitsSpanned(profile.depth, profile.readLength, unit.length(), numIrrs);
+        fmt::format_to(
+            block, "{}\t{}\t{}\t{}\t{}\t{:.2f}\t{}\n", profile.contigInfo.getContigName(region.contigId()),
+            region.start(), region.end(), unit, numIrrs, normNumIrrs, numUnitsSpanned);
+        if (block.size() >= kTableBlockSize)
+        {
+            writeBlock();
         }
     }
 
-    tableStream.close();
+    if (indexedTableWriter)
+    {
+        writeBlock();
+        indexedTableWriter->close();
+    }
+    else
+    {
+        closeTable(tablePath, block, tableStream);
+    }
 }
 
-void outputMotifTable(
-    const string& tablePath, const SampleRunStats& sampleStats, const RegionsByUnit& irrAnchorRegions,
-    const RegionsByUnit& irrRegions, const set<string>& targetUnits, const ReferenceContigInfo& contigInfo)
+static void outputMotifTable(const string& tablePath, const StrProfile& profile)
 {
     std::ofstream tableStream;
-    tableStream.open(tablePath.c_str());
+    openTable(tablePath, tableStream);
 
-    if (!tableStream.is_open())
+    fmt::memory_buffer block;
+    fmt::format_to(block, "motif\tnum_paired_irrs\tnorm_num_paired_irrs\n");
+    for (const auto& motifAndRecord : profile.motifRecords)
     {
-        throw std::runtime_error("Failed to open output file " + tablePath + " for writing (" + strerror(errno) + ")");
+        const int irrPairCount = motifAndRecord.second.irrPairCount;
+        if (irrPairCount == 0)
+        {
+            continue;
+        }
+
+        const double normIrrPairCount = depthNormalize(profile.depth, irrPairCount);
+        fmt::format_to(block, "{}\t{}\t{:.2f}\n", motifAndRecord.first, irrPairCount, normIrrPairCount);
     }
 
-    tableStream << std::setprecision(2) << std::fixed;
-    tableStream << "motif\tnum_paired_irrs\tnorm_num_paired_irrs" << std::endl;
-    for (const auto& unit : targetUnits)
+    closeTable(tablePath, block, tableStream);
+}
+
+static void outputProfile(const string& profileEncoding, const ProfileWorkflowParameters& parameters)
+{
+    if (!parameters.pathToProfileBundle().empty())
     {
-        int ancIrrCount = 0;
-        if (irrAnchorRegions.find(unit) != irrAnchorRegions.end())
-        {
-            ancIrrCount = irrAnchorRegions.at(unit).size();
-        }
+        appendToProfileBundle(parameters.pathToProfileBundle(), parameters.sampleId(), profileEncoding);
+        spdlog::info("Appended profile of {} to {}", parameters.sampleId(), parameters.pathToProfileBundle());
+        return;
+    }
 
-        const int irrPairCount = (static_cast<int>(irrRegions.at(unit).size()) - ancIrrCount) / 2;
-        if (irrPairCount == 0)
+    if (parameters.compressProfile())
+    {
+        writeBgzfFile(parameters.profilePath(), profileEncoding, parameters.numThreads());
+        return;
+    }
+
+    std::ofstream profileFile(parameters.profilePath(), std::ios::binary);
+    profileFile.write(profileEncoding.data(), profileEncoding.size());
+    profileFile.close();
+    if (!profileFile)
+    {
+        throw std::runtime_error("Failed to write " + parameters.profilePath());
+    }
+}
+
+static void copyTable(const string& sourcePath, const string& targetPath)
+{
+    std::ifstream source(sourcePath, std::ios::binary);
+    std::ofstream target(targetPath, std::ios::binary);
+    target << source.rdbuf();
+    target.close();
+    if (!source || !target)
+    {
+        throw std::runtime_error("Failed to copy " + sourcePath + " to " + targetPath);
+    }
+}
+
+// Returns the type of the read and the type of its previously added mate if there is one; the motif of in-repeat
+// reads is computed into the given string so that its storage can be reused across reads
+static std::pair<ReadType, boost::optional<ReadType>> addRead(
+    const Read& read, const ProfileWorkflowParameters& parameters, PairCollector& pairCollector, string& motif)
+{
+    const ReadType readType = classifyRead(
+        parameters.motifSizeRange(), parameters.maxMapqOfInrepeatRead(), parameters.minMapqOfAnchorRead(), read, motif);
+    if (readType == ReadType::kIrrRead)
+    {
+        return { readType, pairCollector.addIrr(read, motif) };
+    }
+    else if (readType == ReadType::kAnchorRead)
+    {
+        return { readType, pairCollector.addAnchor(read) };
+    }
+    else
+    {
+        return { readType, pairCollector.addOtherRead(read) };
+    }
+}
+
+// Writes the profile and the tables concurrently; the tables are derived from the profile, so anchor regions are
+// merged and counts are computed only once. Returns the encoded profile
+static string outputProfileAndTables(
+    const SampleRunStats& stats, PairCollector& pairCollector, const ReferenceContigInfo& contigInfo,
+    const string& inputFingerprint, const ProfileWorkflowParameters& parameters)
+{
+    auto targetUnits = getTargetRepeatUnits(pairCollector.irrRegions(), parameters.motifSizeRange());
+    StrProfile profile = createStrProfile(
+        stats, pairCollector.anchorRegions(), pairCollector.irrRegions(), targetUnits, contigInfo,
+        parameters.binSize());
+    profile.inputFingerprint = inputFingerprint;
+
+    string profileEncoding;
+    const std::function<void()> writers[] = {
+        [&]() {
+            profileEncoding = encodeStrProfile(profile, parameters.profileFormat());
+            outputProfile(profileEncoding, parameters);
+        },
+        [&]() {
+            outputLocusTable(
+                parameters.pathToLocusTable(), profile, parameters.compressLocusTable(), parameters.numThreads());
+        },
+        [&]() { outputMotifTable(parameters.pathToMotifTable(), profile); }
+    };
+    const size_t numWriters = sizeof(writers) / sizeof(writers[0]);
+    processOnThreads(numWriters, static_cast<int>(numWriters), [&](WorkQueue& queue) {
+        size_t writerIndex;
+        while (queue.tryClaim(writerIndex))
         {
-            continue;
+            writers[writerIndex]();
         }
+    });
+
+    return profileEncoding;
+}
 
-        const double normIrrPairCount = depthNormalize(sampleStats.depth(), irrPairCount);
-        tableStream << unit << "\t" << irrPairCount << "\t" << normIrrPairCount << std::endl;
+static int runProfileWorkflowOnSidecar(const ProfileWorkflowParameters& parameters)
+{
+    spdlog::info("Sidecar with informative reads: {}", parameters.pathToInputSidecar());
+    const ReadSidecar sidecar = loadReadSidecar(parameters.pathToInputSidecar());
+    if (parameters.motifSizeRange().end() > sidecar.longestMotif)
+    {
+        throw std::invalid_argument(
+            "Sidecar " + parameters.pathToInputSidecar() + " only covers motifs up to "
+            + std::to_string(sidecar.longestMotif) + " bp");
     }
-    tableStream.close();
+
+    PairCollector pairCollector(sidecar.contigInfo);
+    if (parameters.pathToReadLog())
+    {
+        pairCollector.enableReadLogging(*parameters.pathToReadLog());
+    }
+
+    string motif;
+    for (const auto& fragment : sidecar.fragments)
+    {
+        addRead(fragment.first, parameters, pairCollector, motif);
+        addRead(fragment.second, parameters, pairCollector, motif);
+    }
+    pairCollector.finishReadLogging();
+    spdlog::info("Recomputed profile from {} fragments", sidecar.fragments.size());
+
+    outputProfileAndTables(sidecar.stats, pairCollector, sidecar.contigInfo, sidecar.inputFingerprint, parameters);
+    return 0;
 }
 
+// Set on SIGTERM; the analysis is checkpointed and stopped once the current read is processed
+static volatile std::sig_atomic_t isTerminationRequested = 0;
+static void requestTermination(int) { isTerminationRequested = 1; }
+
+// Exit status of a run stopped by SIGTERM, as if it was killed by the signal
+static const int kTerminatedRunExitCode = 128 + SIGTERM;
+
 int runProfileWorkflow(const ProfileWorkflowParameters& parameters)
 {
     assertValidity(parameters);
+    if (!parameters.pathToInputSidecar().empty())
+    {
+        return runProfileWorkflowOnSidecar(parameters);
+    }
+
     spdlog::info("File with reads: {}", parameters.pathToReads());
 
     HtsFileStreamer readStreamer(parameters.pathToReads(), parameters.pathToReference());
 
+    // Read logs, sidecars, and evidence bamlets are not cached, so runs writing them always stream the file
+    const bool writesUncachedOutputs
+        = parameters.pathToReadLog() || parameters.pathToSidecar() || parameters.pathToEvidenceBam();
+    const bool usesCache = !parameters.pathToCache().empty() && !writesUncachedOutputs;
+    const bool usesCheckpoints = parameters.checkpointInterval() != 0 || parameters.resume();
+
+    // The fingerprint is recorded in every profile; the checksum of the entire file requested by --fingerprint-content
+    // reads the file once more, so it is only included when the fingerprint is part of a key of the cache or of
+    // checkpoints or is recorded in a sidecar
+    const bool needsContentChecksum
+        = parameters.hashInputContent() && (usesCache || usesCheckpoints || parameters.pathToSidecar());
+    const string inputFingerprint
+        = computeInputFingerprint(parameters.pathToReads(), readStreamer.headerText(), needsContentChecksum);
+    spdlog::info("Fingerprint of {}: {}", parameters.pathToReads(), inputFingerprint);
+
+    std::unique_ptr<ProfileResultCache> cache;
+    string cacheKey;
+    if (usesCache)
+    {
+        cache.reset(new ProfileResultCache(parameters.pathToCache()));
+        cacheKey = computeProfileCacheKey(inputFingerprint, parameters);
+        const auto cachedOutputs = cache->find(cacheKey);
+        if (cachedOutputs)
+        {
+            spdlog::info("Reusing outputs cached in {} under {}", parameters.pathToCache(), cacheKey);
+            outputProfile(cachedOutputs->profileEncoding, parameters);
+            copyTable(cachedOutputs->pathToLocusTable, parameters.pathToLocusTable());
+            if (parameters.compressLocusTable())
+            {
+                indexTable(parameters.pathToLocusTable());
+            }
+            copyTable(cachedOutputs->pathToMotifTable, parameters.pathToMotifTable());
+            return 0;
+        }
+    }
+
     const ReferenceContigInfo& referenceContigInfo = readStreamer.contigInfo();
     SampleRunStatsCalculator statsCalculator(referenceContigInfo);
-
     PairCollector pairCollector(referenceContigInfo);
-    if (parameters.pathToReadLog())
+    const string runKey = usesCheckpoints ? computeProfileCacheKey(inputFingerprint, parameters) : string();
+    int64_t numReads = 0;
+
+    if (parameters.resume() && fs::exists(parameters.pathToCheckpoint()))
     {
-        pairCollector.enableReadLogging(*parameters.pathToReadLog());
+        const ProfileCheckpoint checkpoint
+            = loadProfileCheckpoint(parameters.pathToCheckpoint(), runKey, statsCalculator, pairCollector);
+        if (static_cast<bool>(parameters.pathToReadLog()) != (checkpoint.readLogSize >= 0))
+        {
+            throw std::invalid_argument("Reads must be logged by both the interrupted and the resumed run");
+        }
+
+        readStreamer.restorePosition(checkpoint.streamPosition);
+        numReads = checkpoint.numReads;
+        if (parameters.pathToReadLog())
+        {
+            pairCollector.enableReadLogging(*parameters.pathToReadLog(), checkpoint.readLogSize);
+        }
+        spdlog::info("Resuming analysis after {} reads from {}", numReads, parameters.pathToCheckpoint());
+    }
+    else
+    {
+        if (parameters.resume())
+        {
+            spdlog::info("No checkpoint found at {}; analyzing all reads", parameters.pathToCheckpoint());
+        }
+
+        if (parameters.estimateStatsFromIndex())
+        {
+            if (statsCalculator.tryLoadingIndexStats(parameters.pathToReads(), parameters.pathToReference()))
+            {
+                const auto indexStats = statsCalculator.estimate();
+                spdlog::info(
+                    "Estimated read length {} and depth {} from index of about {} primary reads",
+                    indexStats->meanReadLength(), indexStats->depth(), statsCalculator.numIndexedReads());
+            }
+            else
+            {
+                spdlog::info("Read counts are not available from index; sample statistics are computed from all reads");
+            }
+        }
+
+        if (parameters.pathToReadLog())
+        {
+            pairCollector.enableReadLogging(*parameters.pathToReadLog());
+        }
+    }
+
+    std::unique_ptr<ReadSidecarWriter> sidecarWriter;
+    if (parameters.pathToSidecar())
+    {
+        const int longestMotif = std::max(kLongestSidecarMotif, parameters.motifSizeRange().end());
+        sidecarWriter.reset(
+            new ReadSidecarWriter(*parameters.pathToSidecar(), referenceContigInfo, inputFingerprint, longestMotif));
+    }
+
+    std::unique_ptr<EvidenceBamWriter> evidenceBamWriter;
+    if (parameters.pathToEvidenceBam())
+    {
+        evidenceBamWriter.reset(new EvidenceBamWriter(
+            parameters.pathToReads(), parameters.pathToReference(), readStreamer.header(),
+            *parameters.pathToEvidenceBam(), parameters.numThreads()));
     }
 
+    const auto saveCheckpoint = [&]() {
+        ProfileCheckpoint checkpoint;
+        checkpoint.numReads = numReads;
+        checkpoint.streamPosition = readStreamer.position();
+        checkpoint.readLogSize = parameters.pathToReadLog() ? pairCollector.readLogSize() : -1;
+        saveProfileCheckpoint(parameters.pathToCheckpoint(), runKey, checkpoint, statsCalculator, pairCollector);
+    };
+
+    // The clock is only checked every so many reads to keep it out of the per-read cost
+    const int64_t kCheckpointCheckStride = 100000;
+    const bool isCheckpointing = parameters.checkpointInterval() != 0;
+    const std::chrono::seconds checkpointInterval(parameters.checkpointInterval());
+    auto nextCheckpointTime = std::chrono::steady_clock::now() + checkpointInterval;
+    if (isCheckpointing)
+    {
+        std::signal(SIGTERM, requestTermination);
+    }
+
+    // The read and its motif are reused across iterations, so steady-state reads are classified without allocating
+    Read read;
+    string motif;
+    const int64_t kProgressReportStride = 10000000;
     while (readStreamer.trySeekingToNextPrimaryAlignment())
     {
         statsCalculator.inspect(readStreamer.currentReadContigId(), readStreamer.currentReadLength());
+        if (++numReads % kProgressReportStride == 0)
+        {
+            if (statsCalculator.numIndexedReads() != 0)
+            {
+                const int percentDone = static_cast<int>(100 * numReads / statsCalculator.numIndexedReads());
+                spdlog::info(
+                    "Processed {} of about {} reads ({}%)", numReads, statsCalculator.numIndexedReads(),
+                    std::min(percentDone, 100));
+            }
+            else
+            {
+                spdlog::info("Processed {} reads", numReads);
+            }
+        }
 
-        Read read = readStreamer.decodeRead();
-
-        string motif;
-        const ReadType readType = classifyRead(
-            parameters.motifSizeRange(), parameters.maxMapqOfInrepeatRead(), parameters.minMapqOfAnchorRead(), read,
-            motif);
-        if (readType == ReadType::kIrrRead)
+        readStreamer.decodeRead(read);
+        const auto readAndMateTypes = addRead(read, parameters, pairCollector, motif);
+        if (evidenceBamWriter)
         {
-            pairCollector.addIrr(read, motif);
+            evidenceBamWriter->add(readStreamer.currentAlignment(), readAndMateTypes.first, readAndMateTypes.second);
         }
-        else if (readType == ReadType::kAnchorRead)
+        if (sidecarWriter)
         {
-            pairCollector.addAnchor(read);
+            sidecarWriter->add(read);
         }
-        else
+
+        if (isCheckpointing)
         {
-            pairCollector.addOtherRead(read);
+            if (isTerminationRequested)
+            {
+                saveCheckpoint();
+                spdlog::warn(
+                    "Stopped by SIGTERM after {} reads; saved checkpoint to {}", numReads,
+                    parameters.pathToCheckpoint());
+                return kTerminatedRunExitCode;
+            }
+
+            if (numReads % kCheckpointCheckStride == 0 && std::chrono::steady_clock::now() >= nextCheckpointTime)
+            {
+                saveCheckpoint();
+                nextCheckpointTime = std::chrono::steady_clock::now() + checkpointInterval;
+                spdlog::info("Saved checkpoint after {} reads to {}", numReads, parameters.pathToCheckpoint());
+            }
         }
     }
 
+    if (isCheckpointing)
+    {
+        std::signal(SIGTERM, SIG_DFL);
+    }
+
     const auto stats = statsCalculator.estimate();
     assert(stats);
+    pairCollector.finishReadLogging();
 
-    auto targetUnits = getTargetRepeatUnits(pairCollector.irrRegions(), parameters.motifSizeRange());
-    outputProfile(
-        parameters.profilePath(), *stats, pairCollector.anchorRegions(), pairCollector.irrRegions(), targetUnits,
-        referenceContigInfo);
-    outputLocusTable(
-        parameters.pathToLocusTable(), *stats, pairCollector.anchorRegions(), targetUnits, referenceContigInfo);
-    outputMotifTable(
-        parameters.pathToMotifTable(), *stats, pairCollector.anchorRegions(), pairCollector.irrRegions(), targetUnits,
-        referenceContigInfo);
+    if (evidenceBamWriter)
+    {
+        evidenceBamWriter->finish();
+        spdlog::info("Wrote {} alignments to {}", evidenceBamWriter->numRecords(), *parameters.pathToEvidenceBam());
+    }
+
+    if (sidecarWriter)
+    {
+        sidecarWriter->finish(*stats);
+        spdlog::info("Wrote {} fragments to {}", sidecarWriter->numFragments(), *parameters.pathToSidecar());
+    }
+
+    const string profileEncoding
+        = outputProfileAndTables(*stats, pairCollector, referenceContigInfo, inputFingerprint, parameters);
+
+    if (cache)
+    {
+        cache->store(cacheKey, profileEncoding, parameters.pathToLocusTable(), parameters.pathToMotifTable());
+        spdlog::info("Cached outputs in {} under {}", parameters.pathToCache(), cacheKey);
+    }
+
+    if (isCheckpointing || parameters.resume())
+    {
+        std::remove(parameters.pathToCheckpoint().c_str());
+    }
     return 0;
 }
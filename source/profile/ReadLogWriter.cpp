@@ -0,0 +1,274 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ReadLogWriter.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using std::string;
+
+static const size_t kRingCapacity = 1 << 14;
+static const size_t kBufferSize = 1 << 20;
+
+ReadLogWriter::ReadLogWriter(const string& path, ReferenceContigInfo contigInfo, int64_t sizeOfExistingLog)
+    : path_(path)
+    , contigInfo_(std::move(contigInfo))
+    , ring_(kRingCapacity)
+    , numPushedRecords_(0)
+    , numConsumedRecords_(0)
+    , numFlushedRecords_(0)
+    , fileSize_(0)
+    , isFlushRequested_(false)
+    , isClosing_(false)
+    , hasFailed_(false)
+{
+    if (sizeOfExistingLog >= 0 && truncate(path.c_str(), sizeOfExistingLog) != 0)
+    {
+        throw std::runtime_error("Failed to truncate " + path + " (" + strerror(errno) + ")");
+    }
+
+    if (sizeOfExistingLog >= 0)
+    {
+        logStream_.open(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        logStream_.seekp(0, std::ios::end);
+    }
+    else
+    {
+        logStream_.open(path.c_str(), std::ios::binary);
+    }
+
+    if (!logStream_.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing (" + strerror(errno) + ")");
+    }
+
+    if (sizeOfExistingLog < 0)
+    {
+        buffer_ = "pair_type\tmotif\tread_type\tread_pos\tmate_type\tmate_pos\tname\n";
+    }
+    fileSize_ = std::max<int64_t>(sizeOfExistingLog, 0);
+    buffer_.reserve(kBufferSize + 1024);
+
+    writerThread_ = std::thread(&ReadLogWriter::writeRecords, this);
+}
+
+ReadLogWriter::~ReadLogWriter()
+{
+    if (writerThread_.joinable())
+    {
+        isClosing_.store(true, std::memory_order_release);
+        writerThread_.join();
+    }
+}
+
+void ReadLogWriter::logIrrPair(
+    const string& fragName, const GenomicRegion& readRegion, const string& readUnit, const GenomicRegion& mateRegion,
+    const string& mateUnit)
+{
+    Record record;
+    record.isIrrPair = true;
+    record.fragName = fragName;
+    record.unit = readUnit;
+    record.mateUnit = mateUnit;
+    record.region = readRegion;
+    record.mateRegion = mateRegion;
+    push(record);
+}
+
+void ReadLogWriter::logAnchoredIrr(
+    const string& fragName, const string& unit, const GenomicRegion& irrRegion, const GenomicRegion& anchorRegion)
+{
+    Record record;
+    record.fragName = fragName;
+    record.unit = unit;
+    record.region = irrRegion;
+    record.mateRegion = anchorRegion;
+    push(record);
+}
+
+void ReadLogWriter::push(Record& record)
+{
+    const uint64_t numPushedRecords = numPushedRecords_.load(std::memory_order_relaxed);
+    while (numPushedRecords - numConsumedRecords_.load(std::memory_order_acquire) == kRingCapacity)
+    {
+        // The writer thread stops consuming records once it fails
+        if (hasFailed_.load(std::memory_order_acquire))
+        {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+        std::this_thread::yield();
+    }
+
+    ring_[numPushedRecords % kRingCapacity] = std::move(record);
+    numPushedRecords_.store(numPushedRecords + 1, std::memory_order_release);
+}
+
+int64_t ReadLogWriter::flush()
+{
+    const uint64_t numPushedRecords = numPushedRecords_.load(std::memory_order_relaxed);
+    isFlushRequested_.store(true, std::memory_order_release);
+    while (numFlushedRecords_.load(std::memory_order_acquire) != numPushedRecords
+           || isFlushRequested_.load(std::memory_order_acquire))
+    {
+        if (hasFailed_.load(std::memory_order_acquire))
+        {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+        std::this_thread::yield();
+    }
+
+    return fileSize_.load(std::memory_order_acquire);
+}
+
+void ReadLogWriter::close()
+{
+    if (writerThread_.joinable())
+    {
+        isClosing_.store(true, std::memory_order_release);
+        writerThread_.join();
+    }
+
+    if (hasFailed_.load(std::memory_order_acquire))
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+static void appendRegion(const GenomicRegion& region, const ReferenceContigInfo& contigInfo, string& buffer)
+{
+    if (region.contigId() == -1)
+    {
+        buffer += "unaligned";
+        return;
+    }
+
+    buffer += contigInfo.getContigName(region.contigId());
+    buffer += ':';
+    buffer += std::to_string(region.start());
+    buffer += '-';
+    buffer += std::to_string(region.end());
+}
+
+void ReadLogWriter::formatRecord(const Record& record)
+{
+    if (!record.isIrrPair)
+    {
+        buffer_ += "anchored_irr\t";
+        buffer_ += record.unit;
+        buffer_ += "\tirr\t";
+        appendRegion(record.region, contigInfo_, buffer_);
+        buffer_ += "\tanchor\t";
+        appendRegion(record.mateRegion, contigInfo_, buffer_);
+    }
+    else
+    {
+        // Pairs are reported with the lexicographically smaller unit first
+        const bool isReadFirst = record.unit <= record.mateUnit;
+        const string& firstUnit = isReadFirst ? record.unit : record.mateUnit;
+        const string& secondUnit = isReadFirst ? record.mateUnit : record.unit;
+        buffer_ += "irr_pair\t";
+        buffer_ += firstUnit;
+        if (firstUnit != secondUnit)
+        {
+            buffer_ += '_';
+            buffer_ += secondUnit;
+        }
+        buffer_ += "\tirr\t";
+        appendRegion(isReadFirst ? record.region : record.mateRegion, contigInfo_, buffer_);
+        buffer_ += "\tirr\t";
+        appendRegion(isReadFirst ? record.mateRegion : record.region, contigInfo_, buffer_);
+    }
+
+    buffer_ += '\t';
+    buffer_ += record.fragName;
+    buffer_ += '\n';
+}
+
+void ReadLogWriter::writeBuffer()
+{
+    logStream_.write(buffer_.data(), buffer_.size());
+    if (!logStream_)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+    fileSize_.fetch_add(buffer_.size(), std::memory_order_release);
+    buffer_.clear();
+}
+
+void ReadLogWriter::writeRecords()
+{
+    try
+    {
+        uint64_t numConsumedRecords = 0;
+        while (true)
+        {
+            const uint64_t numPushedRecords = numPushedRecords_.load(std::memory_order_acquire);
+            if (numConsumedRecords != numPushedRecords)
+            {
+                formatRecord(ring_[numConsumedRecords % kRingCapacity]);
+                numConsumedRecords_.store(++numConsumedRecords, std::memory_order_release);
+                if (buffer_.size() >= kBufferSize)
+                {
+                    writeBuffer();
+                }
+                continue;
+            }
+
+            if (isClosing_.load(std::memory_order_acquire)
+                && numConsumedRecords == numPushedRecords_.load(std::memory_order_acquire))
+            {
+                break;
+            }
+
+            // The request is cleared before the records are published, so requests made afterwards are not lost
+            if (isFlushRequested_.exchange(false, std::memory_order_acq_rel))
+            {
+                writeBuffer();
+                logStream_.flush();
+                numFlushedRecords_.store(numConsumedRecords, std::memory_order_release);
+                if (!logStream_)
+                {
+                    throw std::runtime_error("Failed to write " + path_);
+                }
+                continue;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        writeBuffer();
+        logStream_.close();
+        if (!logStream_)
+        {
+            throw std::runtime_error("Failed to write " + path_);
+        }
+    }
+    catch (const std::exception&)
+    {
+        hasFailed_.store(true, std::memory_order_release);
+    }
+}
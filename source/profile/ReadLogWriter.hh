@@ -0,0 +1,94 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Writer of the read log that formats and writes logged pairs on a dedicated thread. Pairs are handed over through a
+// single-producer single-consumer ring of fixed capacity, so logging a pair costs the pairing thread one move of the
+// record and no locking; the writer thread accumulates formatted lines and writes them in large blocks.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "region/GenomicRegion.hh"
+#include "region/ReferenceContigInfo.hh"
+
+class ReadLogWriter
+{
+public:
+    // Appends to an existing log truncated to the given size if it is not negative
+    ReadLogWriter(const std::string& path, ReferenceContigInfo contigInfo, int64_t sizeOfExistingLog = -1);
+    ~ReadLogWriter();
+
+    ReadLogWriter(const ReadLogWriter&) = delete;
+    ReadLogWriter& operator=(const ReadLogWriter&) = delete;
+
+    void logIrrPair(
+        const std::string& fragName, const GenomicRegion& readRegion, const std::string& readUnit,
+        const GenomicRegion& mateRegion, const std::string& mateUnit);
+    void logAnchoredIrr(
+        const std::string& fragName, const std::string& unit, const GenomicRegion& irrRegion,
+        const GenomicRegion& anchorRegion);
+
+    // Waits until all logged pairs are written to the file and returns the size of the file
+    int64_t flush();
+    // Writes the remaining pairs and closes the file
+    void close();
+
+private:
+    struct Record
+    {
+        bool isIrrPair = false;
+        std::string fragName;
+        std::string unit;
+        std::string mateUnit;
+        GenomicRegion region = GenomicRegion(-1, 0, 0);
+        GenomicRegion mateRegion = GenomicRegion(-1, 0, 0);
+    };
+
+    void push(Record& record);
+    void formatRecord(const Record& record);
+    void writeBuffer();
+    void writeRecords();
+
+    std::string path_;
+    ReferenceContigInfo contigInfo_;
+    std::ofstream logStream_;
+
+    std::vector<Record> ring_;
+    // Number of records pushed by the pairing thread and consumed by the writer thread
+    std::atomic<uint64_t> numPushedRecords_;
+    std::atomic<uint64_t> numConsumedRecords_;
+    // Number of records written to the file when the last flush was requested
+    std::atomic<uint64_t> numFlushedRecords_;
+    std::atomic<int64_t> fileSize_;
+    std::atomic<bool> isFlushRequested_;
+    std::atomic<bool> isClosing_;
+    std::atomic<bool> hasFailed_;
+
+    // Owned by the writer thread
+    std::string buffer_;
+    std::thread writerThread_;
+};
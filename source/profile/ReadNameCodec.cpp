@@ -0,0 +1,173 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "profile/ReadNameCodec.hh"
+
+#include <stdexcept>
+
+using std::string;
+using std::to_string;
+
+static const uint64_t kUnstructuredNameFlag = uint64_t(1) << 63;
+static const size_t kMaxPrefixes = 64;
+static const int kPrefixShift = 40;
+static const int kLaneShift = 32;
+static const uint64_t kMaxLane = 0xFF;
+static const uint64_t kMaxTile = 0xFFFFFFFF;
+static const uint64_t kMaxCoordinate = 0xFFFFFFFF;
+
+// Parses decimal numbers without leading zeros so that the packed value decodes to the original text
+static bool tryParsingField(const string& name, size_t start, size_t end, uint64_t maxValue, uint64_t& value)
+{
+    const size_t kMaxDigits = 10;
+    const size_t numDigits = end - start;
+    if (numDigits == 0 || numDigits > kMaxDigits || (numDigits > 1 && name[start] == '0'))
+    {
+        return false;
+    }
+
+    value = 0;
+    for (size_t index = start; index != end; ++index)
+    {
+        if (name[index] < '0' || name[index] > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (name[index] - '0');
+    }
+
+    return value <= maxValue;
+}
+
+bool ReadNameCodec::tryFindingPrefix(const string& name, size_t prefixLength, uint64_t& prefixIndex)
+{
+    // Names of a file share a handful of prefixes that usually come in long runs, so the last match is tried first
+    const auto matches = [&](size_t index) {
+        return prefixes_[index].length() == prefixLength && name.compare(0, prefixLength, prefixes_[index]) == 0;
+    };
+
+    if (lastPrefixIndex_ < prefixes_.size() && matches(lastPrefixIndex_))
+    {
+        prefixIndex = lastPrefixIndex_;
+        return true;
+    }
+
+    for (size_t index = 0; index != prefixes_.size(); ++index)
+    {
+        if (matches(index))
+        {
+            prefixIndex = lastPrefixIndex_ = index;
+            return true;
+        }
+    }
+
+    if (prefixes_.size() == kMaxPrefixes)
+    {
+        return false;
+    }
+
+    prefixes_.push_back(name.substr(0, prefixLength));
+    prefixIndex = lastPrefixIndex_ = prefixes_.size() - 1;
+    return true;
+}
+
+bool ReadNameCodec::tryPacking(const string& name, ReadNameKey& key)
+{
+    // Fields are parsed from the end of the name: y, x, tile, and lane
+    const uint64_t maxValues[] = { kMaxCoordinate, kMaxCoordinate, kMaxTile, kMaxLane };
+    uint64_t values[4];
+    size_t fieldEnd = name.length();
+    for (int fieldIndex = 0; fieldIndex != 4; ++fieldIndex)
+    {
+        const size_t colonIndex = fieldEnd == 0 ? string::npos : name.rfind(':', fieldEnd - 1);
+        if (colonIndex == string::npos
+            || !tryParsingField(name, colonIndex + 1, fieldEnd, maxValues[fieldIndex], values[fieldIndex]))
+        {
+            return false;
+        }
+        fieldEnd = colonIndex;
+    }
+
+    uint64_t prefixIndex = 0;
+    if (fieldEnd == 0 || !tryFindingPrefix(name, fieldEnd, prefixIndex))
+    {
+        return false;
+    }
+
+    key.high = (prefixIndex << kPrefixShift) | (values[3] << kLaneShift) | values[2];
+    key.low = (values[1] << 32) | values[0];
+    return true;
+}
+
+ReadNameKey ReadNameCodec::encode(const string& name)
+{
+    ReadNameKey key;
+    if (tryPacking(name, key))
+    {
+        return key;
+    }
+
+    const auto nameAndKey = unstructuredKeys_.find(name);
+    if (nameAndKey != unstructuredKeys_.end())
+    {
+        return nameAndKey->second;
+    }
+
+    key = { kUnstructuredNameFlag, nextUnstructuredId_++ };
+    unstructuredKeys_.emplace(name, key);
+    unstructuredNames_.emplace(key, name);
+    return key;
+}
+
+string ReadNameCodec::decode(const ReadNameKey& key) const
+{
+    if (key.high & kUnstructuredNameFlag)
+    {
+        const auto keyAndName = unstructuredNames_.find(key);
+        if (keyAndName == unstructuredNames_.end())
+        {
+            throw std::logic_error("Read name key " + to_string(key.low) + " is not in use");
+        }
+        return keyAndName->second;
+    }
+
+    const uint64_t prefixIndex = key.high >> kPrefixShift;
+    const uint64_t lane = (key.high >> kLaneShift) & kMaxLane;
+    const uint64_t tile = key.high & kMaxTile;
+    const uint64_t x = key.low >> 32;
+    const uint64_t y = key.low & kMaxCoordinate;
+    return prefixes_.at(prefixIndex) + ":" + to_string(lane) + ":" + to_string(tile) + ":" + to_string(x) + ":"
+        + to_string(y);
+}
+
+void ReadNameCodec::release(const ReadNameKey& key)
+{
+    if (key.high & kUnstructuredNameFlag)
+    {
+        const auto keyAndName = unstructuredNames_.find(key);
+        if (keyAndName != unstructuredNames_.end())
+        {
+            unstructuredKeys_.erase(keyAndName->second);
+            unstructuredNames_.erase(keyAndName);
+        }
+    }
+}
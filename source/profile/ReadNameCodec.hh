@@ -0,0 +1,77 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Fixed-size keys for pairing reads by name. Illumina names of the form
+//
+//   <instrument>:<run>:<flowcell>:<lane>:<tile>:<x>:<y>
+//
+// are packed into 16 bytes: the instrument, run, and flowcell are replaced by the index of the prefix in a small
+// dictionary and the numeric fields are stored as integers. Names that do not follow this structure (or have numeric
+// fields that would not decode to the same text) are assigned sequential keys through a table of such names.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ReadNameKey
+{
+    uint64_t high;
+    uint64_t low;
+
+    bool operator==(const ReadNameKey& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const ReadNameKey& other) const { return !(*this == other); }
+};
+
+struct ReadNameKeyHash
+{
+    size_t operator()(const ReadNameKey& key) const
+    {
+        const uint64_t hash = (key.high * 0x9E3779B97F4A7C15ULL) ^ key.low;
+        return static_cast<size_t>(hash ^ (hash >> 29));
+    }
+};
+
+class ReadNameCodec
+{
+public:
+    // Packs Illumina names; other names are entered into the table of unstructured names
+    ReadNameKey encode(const std::string& name);
+    std::string decode(const ReadNameKey& key) const;
+    // Removes the name of the key from the table of unstructured names once the key is no longer in use
+    void release(const ReadNameKey& key);
+
+    size_t numUnstructuredNames() const { return unstructuredNames_.size(); }
+
+private:
+    bool tryPacking(const std::string& name, ReadNameKey& key);
+    bool tryFindingPrefix(const std::string& name, size_t prefixLength, uint64_t& prefixIndex);
+
+    std::vector<std::string> prefixes_;
+    size_t lastPrefixIndex_ = 0;
+    uint64_t nextUnstructuredId_ = 0;
+    std::unordered_map<std::string, ReadNameKey> unstructuredKeys_;
+    std::unordered_map<ReadNameKey, std::string, ReadNameKeyHash> unstructuredNames_;
+};
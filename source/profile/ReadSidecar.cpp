@@ -0,0 +1,234 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ReadSidecar.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "reads/IrrFinder.hh"
+
+using std::pair;
+using std::string;
+using std::to_string;
+using std::vector;
+
+static const char kMagic[] = { 'E', 'H', 'D', 'N', 'S', 'C', 'A', 'R' };
+static const uint64_t kFormatVersion = 1;
+static const uint64_t kEndRecord = 0;
+static const uint64_t kFragmentRecord = 1;
+static const size_t kFlushThreshold = 1 << 20;
+
+static void writeMate(
+    int contigId, size_t pos, size_t mapq, size_t flag, const string& bases, const string& quals,
+    BinaryEncoder& encoder)
+{
+    encoder.writeSignedVarint(contigId);
+    encoder.writeVarint(pos);
+    encoder.writeVarint(mapq);
+    encoder.writeVarint(flag);
+    encoder.writeString(bases);
+    encoder.writeString(quals);
+}
+
+static Read readMate(const string& name, BinaryDecoder& decoder)
+{
+    Read read;
+    read.name = name;
+    read.contigId = static_cast<int>(decoder.readSignedVarint());
+    read.pos = decoder.readVarint();
+    read.mapq = decoder.readVarint();
+    read.flag = decoder.readVarint();
+    read.bases = decoder.readString();
+    read.quals = decoder.readString();
+    return read;
+}
+
+ReadSidecarWriter::ReadSidecarWriter(
+    const string& path, const ReferenceContigInfo& contigInfo, const string& inputFingerprint, int longestMotif)
+    : path_(path)
+    , sidecarStream_(path, std::ios::binary)
+    , candidateMotifSizeRange_(1, longestMotif)
+{
+    if (!sidecarStream_.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing (" + strerror(errno) + ")");
+    }
+
+    encoder_.writeBytes(kMagic, sizeof(kMagic));
+    encoder_.writeVarint(kFormatVersion);
+    encoder_.writeString(inputFingerprint);
+    encoder_.writeVarint(longestMotif);
+    encoder_.writeVarint(contigInfo.numContigs());
+    for (int contigId = 0; contigId != contigInfo.numContigs(); ++contigId)
+    {
+        encoder_.writeString(contigInfo.getContigName(contigId));
+        encoder_.writeVarint(contigInfo.getContigSize(contigId));
+    }
+}
+
+void ReadSidecarWriter::add(const Read& read)
+{
+    const bool isCandidate = HasFrequentPeriod(read.bases, candidateMotifSizeRange_);
+
+    const auto candidateMate = pendingCandidates_.find(read.name);
+    if (candidateMate != pendingCandidates_.end())
+    {
+        writeFragment(candidateMate->second, read, isCandidate);
+        pendingCandidates_.erase(candidateMate);
+        return;
+    }
+
+    const auto otherMate = pendingMates_.find(read.name);
+    if (otherMate != pendingMates_.end())
+    {
+        if (isCandidate)
+        {
+            const MateAlignment& alignment = otherMate->second;
+            Read mate;
+            mate.name = read.name;
+            mate.contigId = alignment.contigId;
+            mate.pos = alignment.pos;
+            mate.mapq = alignment.mapq;
+            mate.flag = alignment.flag;
+            writeFragment(mate, read, true);
+        }
+        pendingMates_.erase(otherMate);
+        return;
+    }
+
+    if (isCandidate)
+    {
+        pendingCandidates_.emplace(read.name, read);
+    }
+    else
+    {
+        pendingMates_.emplace(read.name, MateAlignment{ read.contigId, read.pos, read.mapq, read.flag });
+    }
+}
+
+// Bases and qualities of a mate that is not a candidate are not needed to classify the fragment
+void ReadSidecarWriter::writeFragment(const Read& firstMate, const Read& secondMate, bool includeSecondMateBases)
+{
+    static const string kNoBases;
+
+    encoder_.writeVarint(kFragmentRecord);
+    encoder_.writeString(secondMate.name);
+    writeMate(
+        firstMate.contigId, firstMate.pos, firstMate.mapq, firstMate.flag, firstMate.bases, firstMate.quals, encoder_);
+    writeMate(
+        secondMate.contigId, secondMate.pos, secondMate.mapq, secondMate.flag,
+        includeSecondMateBases ? secondMate.bases : kNoBases, includeSecondMateBases ? secondMate.quals : kNoBases,
+        encoder_);
+    ++numFragments_;
+
+    if (encoder_.buffer().size() >= kFlushThreshold)
+    {
+        flush();
+    }
+}
+
+void ReadSidecarWriter::flush()
+{
+    sidecarStream_.write(encoder_.buffer().data(), encoder_.buffer().size());
+    encoder_.clear();
+    if (!sidecarStream_)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+void ReadSidecarWriter::finish(const SampleRunStats& stats)
+{
+    encoder_.writeVarint(kEndRecord);
+    encoder_.writeVarint(stats.meanReadLength());
+    encoder_.writeDouble(stats.depth());
+    flush();
+
+    pendingCandidates_.clear();
+    pendingMates_.clear();
+    sidecarStream_.close();
+    if (!sidecarStream_)
+    {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+ReadSidecar loadReadSidecar(const string& path)
+{
+    std::ifstream sidecarFile(path, std::ios::binary);
+    if (!sidecarFile)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+
+    std::ostringstream contents;
+    contents << sidecarFile.rdbuf();
+    const string bytes = contents.str();
+
+    if (bytes.size() < sizeof(kMagic) || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0)
+    {
+        throw std::runtime_error(path + " is not a sidecar of informative reads");
+    }
+
+    BinaryDecoder decoder(bytes.data() + sizeof(kMagic), bytes.data() + bytes.size());
+    const uint64_t version = decoder.readVarint();
+    if (version != kFormatVersion)
+    {
+        throw std::runtime_error("Unsupported version of sidecar format " + to_string(version));
+    }
+
+    string inputFingerprint = decoder.readString();
+    const auto longestMotif = static_cast<int>(decoder.readVarint());
+    const uint64_t numContigs = decoder.readVarint();
+    vector<pair<string, int64_t>> contigNamesAndSizes;
+    for (uint64_t contigIndex = 0; contigIndex != numContigs; ++contigIndex)
+    {
+        string contigName = decoder.readString();
+        const auto contigSize = static_cast<int64_t>(decoder.readVarint());
+        contigNamesAndSizes.emplace_back(std::move(contigName), contigSize);
+    }
+
+    vector<pair<Read, Read>> fragments;
+    while (decoder.readVarint() == kFragmentRecord)
+    {
+        const string name = decoder.readString();
+        Read firstMate = readMate(name, decoder);
+        Read secondMate = readMate(name, decoder);
+        firstMate.mateContigId = secondMate.contigId;
+        firstMate.matePos = secondMate.pos;
+        secondMate.mateContigId = firstMate.contigId;
+        secondMate.matePos = firstMate.pos;
+        fragments.emplace_back(std::move(firstMate), std::move(secondMate));
+    }
+
+    const auto readLength = static_cast<int>(decoder.readVarint());
+    const double depth = decoder.readDouble();
+    if (!decoder.atEnd())
+    {
+        throw std::runtime_error("Unexpected trailing data in " + path);
+    }
+
+    return { ReferenceContigInfo(std::move(contigNamesAndSizes)), std::move(inputFingerprint), longestMotif,
+             SampleRunStats(readLength, depth), std::move(fragments) };
+}
@@ -0,0 +1,98 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Sidecar files of informative reads that allow recomputing a profile with different motif size and MAPQ thresholds
+// without streaming the file with reads again. A sidecar consists of
+//
+//   - an 8-byte magic string followed by the format version,
+//   - the fingerprint of the file with reads, the longest motif covered by the sidecar, and the reference contigs,
+//   - a record for each fragment with a candidate in-repeat read holding the fragment name and both mates (contig,
+//     position, MAPQ, flag, and, for candidate reads, bases and qualities) in the order they appear in the file,
+//   - an end record with the read length and depth of the sample.
+//
+// Candidate reads pass HasFrequentPeriod for motifs up to the longest covered motif regardless of their MAPQ, so every
+// in-repeat read under any thresholds within this motif size is a candidate. Mates of candidates are recorded
+// whatever their type, which makes the recorded fragments a superset of fragments that contribute to a profile.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/BinaryCoding.hh"
+#include "common/Interval.hh"
+#include "profile/SampleRunStats.hh"
+#include "reads/Read.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Sidecars cover motifs up to this length unless longer motifs are profiled
+const int kLongestSidecarMotif = 50;
+
+struct ReadSidecar
+{
+    ReferenceContigInfo contigInfo;
+    std::string inputFingerprint;
+    int longestMotif;
+    SampleRunStats stats;
+    std::vector<std::pair<Read, Read>> fragments;
+};
+
+ReadSidecar loadReadSidecar(const std::string& path);
+
+class ReadSidecarWriter
+{
+public:
+    ReadSidecarWriter(
+        const std::string& path, const ReferenceContigInfo& contigInfo, const std::string& inputFingerprint,
+        int longestMotif);
+
+    // Adds a primary read; fragments are written once both mates were added. Reads that must wait for their mates are
+    // copied, so the caller can reuse the read
+    void add(const Read& read);
+    // Writes the end record; reads whose mates were not encountered are dropped
+    void finish(const SampleRunStats& stats);
+    int64_t numFragments() const { return numFragments_; }
+
+private:
+    // Alignment of a read that is not a candidate; only these fields are needed to classify it
+    struct MateAlignment
+    {
+        int contigId;
+        size_t pos;
+        size_t mapq;
+        size_t flag;
+    };
+
+    void writeFragment(const Read& firstMate, const Read& secondMate, bool includeSecondMateBases);
+    void flush();
+
+    std::string path_;
+    std::ofstream sidecarStream_;
+    Interval candidateMotifSizeRange_;
+    BinaryEncoder encoder_;
+    std::unordered_map<std::string, Read> pendingCandidates_;
+    std::unordered_map<std::string, MateAlignment> pendingMates_;
+    int64_t numFragments_ = 0;
+};
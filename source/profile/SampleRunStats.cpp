@@ -22,10 +22,14 @@
 #include "SampleRunStats.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <stdexcept>
 
+#include "io/HtsFileStreamer.hh"
+
 using boost::optional;
+using std::string;
 using std::vector;
 
 bool SampleRunStats::operator==(const SampleRunStats& other) const
@@ -39,22 +43,57 @@ std::ostream& operator<<(std::ostream& out, const SampleRunStats& stats)
     return out;
 }
 
+// Depth is estimated from contigs with ids 0 to 22, which are the autosomes and chrX in the usual contig order
+static const int kNumContigsToConsider = 23;
+
 SampleRunStatsCalculator::SampleRunStatsCalculator(ReferenceContigInfo contigInfo)
     : contigInfo_(std::move(contigInfo))
-    , totalReadCount(0)
-    , sumOfReadLengths(0)
+    , readCountsOfContigs_(std::min(contigInfo_.numContigs(), kNumContigsToConsider), 0)
 {
 }
 
-void SampleRunStatsCalculator::inspect(int contigId, int readLength)
+bool SampleRunStatsCalculator::tryLoadingIndexStats(
+    const string& pathToReads, const string& pathToReference, int numSampledReads)
 {
-    ++totalReadCount;
-    sumOfReadLengths += readLength;
-    static int kNumContigsToConsider = 22;
-    if (contigId <= kNumContigsToConsider)
+    // Reads are sampled from a separate stream, so the file can be streamed for the analysis independently
+    HtsFileStreamer sampledReads(pathToReads, pathToReference);
+    const vector<int64_t> indexedReadCounts = sampledReads.loadIndexedReadCounts();
+    if (indexedReadCounts.empty())
     {
-        ++contigIdToReadCount[contigId];
+        return false;
+    }
+
+    int64_t numReads = 0;
+    int64_t sumOfReadLengths = 0;
+    while (numReads != numSampledReads && sampledReads.trySeekingToNextPrimaryAlignment())
+    {
+        ++numReads;
+        sumOfReadLengths += sampledReads.currentReadLength();
+    }
+
+    if (numReads == 0)
+    {
+        return false;
+    }
+
+    // Secondary and supplementary alignments skipped while sampling are counted by the index too
+    const double primaryFraction = numReads / static_cast<double>(sampledReads.position().numRecordsRead);
+    numIndexedReads_ = 0;
+    for (size_t contigId = 0; contigId != indexedReadCounts.size(); ++contigId)
+    {
+        const auto readCount = static_cast<int64_t>(std::llround(indexedReadCounts[contigId] * primaryFraction));
+        if (contigId < readCountsOfContigs_.size())
+        {
+            readCountsOfContigs_[contigId] = readCount;
+        }
+        numIndexedReads_ += readCount;
     }
+
+    // Only the ratio of the totals matters for the mean read length
+    totalReadCount_ = numReads;
+    sumOfReadLengths_ = sumOfReadLengths;
+    usesIndexStats_ = true;
+    return true;
 }
 
 static double median(vector<double> numbers)
@@ -79,24 +118,23 @@ static double median(vector<double> numbers)
 
 optional<SampleRunStats> SampleRunStatsCalculator::estimate() const
 {
-    if (totalReadCount == 0)
+    if (totalReadCount_ == 0)
     {
         return boost::none;
     }
 
-    const auto meanReadLength = static_cast<int>(sumOfReadLengths / totalReadCount);
+    const auto meanReadLength = static_cast<int>(sumOfReadLengths_ / totalReadCount_);
 
     vector<double> meanDepths;
-    for (const auto& contigIdAndReadCount : contigIdToReadCount)
+    for (size_t contigId = 0; contigId != readCountsOfContigs_.size(); ++contigId)
     {
-        const auto contigId = contigIdAndReadCount.first;
-        // Skip unaligned reads
-        if (contigId == -1)
+        // Contigs without reads are not considered
+        const int64_t readCount = readCountsOfContigs_[contigId];
+        if (readCount == 0)
         {
             continue;
         }
 
-        const auto readCount = contigIdAndReadCount.second;
         const auto contigLength = contigInfo_.getContigSize(contigId);
         const auto medianDepth = readCount * meanReadLength / static_cast<double>(contigLength);
 
@@ -107,3 +145,32 @@ optional<SampleRunStats> SampleRunStatsCalculator::estimate() const
 
     return SampleRunStats(meanReadLength, medianDepth);
 }
+
+void SampleRunStatsCalculator::saveState(BinaryEncoder& encoder) const
+{
+    encoder.writeVarint(usesIndexStats_ ? 1 : 0);
+    encoder.writeVarint(numIndexedReads_);
+    encoder.writeVarint(totalReadCount_);
+    encoder.writeVarint(sumOfReadLengths_);
+    encoder.writeVarint(readCountsOfContigs_.size());
+    for (int64_t readCount : readCountsOfContigs_)
+    {
+        encoder.writeVarint(readCount);
+    }
+}
+
+void SampleRunStatsCalculator::restoreState(BinaryDecoder& decoder)
+{
+    usesIndexStats_ = decoder.readVarint() != 0;
+    numIndexedReads_ = static_cast<int64_t>(decoder.readVarint());
+    totalReadCount_ = static_cast<int64_t>(decoder.readVarint());
+    sumOfReadLengths_ = static_cast<int64_t>(decoder.readVarint());
+    if (decoder.readVarint() != readCountsOfContigs_.size())
+    {
+        throw std::runtime_error("Saved read counts do not match the contigs of the reads");
+    }
+    for (auto& readCount : readCountsOfContigs_)
+    {
+        readCount = static_cast<int64_t>(decoder.readVarint());
+    }
+}
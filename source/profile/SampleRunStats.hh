@@ -23,11 +23,11 @@
 
 #include <iostream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <boost/optional.hpp>
 
+#include "common/BinaryCoding.hh"
 #include "region/ReferenceContigInfo.hh"
 
 class SampleRunStats
@@ -51,20 +51,57 @@ private:
 
 std::ostream& operator<<(std::ostream& out, const SampleRunStats& stats);
 
-// Computes read and coverage statistics for each locus from reads aligning to the flanks
+// Computes mean read length and median depth of the leading contigs. By default every primary read is inspected as
+// it is streamed. Alternatively, read counts of contigs are taken from the index of the file, so that the statistics
+// are available before the reads are streamed. The index counts include secondary and supplementary alignments and
+// are scaled by the fraction of primary alignments among the first records, so depths estimated from the index are
+// approximate for files whose secondary and supplementary alignments are unevenly spread.
 class SampleRunStatsCalculator
 {
 public:
     explicit SampleRunStatsCalculator(ReferenceContigInfo contigInfo);
 
-    void inspect(int contigId, int readLength);
+    // Takes read counts of contigs from the index and estimates the mean read length and the fraction of primary
+    // alignments from the first records of the file; returns false if the file has no index recording read counts
+    bool tryLoadingIndexStats(
+        const std::string& pathToReads, const std::string& pathToReference, int numSampledReads = 10000);
+    bool usesIndexStats() const { return usesIndexStats_; }
+
+    // Counts a primary read; reads are ignored once the statistics were loaded from the index
+    void inspect(int contigId, int readLength)
+    {
+        if (!usesIndexStats_)
+        {
+            countRead(contigId, readLength);
+        }
+    }
+
+    // Estimated number of primary reads in the file if the statistics were loaded from the index and zero otherwise
+    int64_t numIndexedReads() const { return numIndexedReads_; }
 
     boost::optional<SampleRunStats> estimate() const;
 
+    // Saves and restores the counters, e.g. to resume an interrupted run
+    void saveState(BinaryEncoder& encoder) const;
+    void restoreState(BinaryDecoder& decoder);
+
 private:
+    void countRead(int contigId, int readLength)
+    {
+        ++totalReadCount_;
+        sumOfReadLengths_ += readLength;
+        if (0 <= contigId && contigId < static_cast<int>(readCountsOfContigs_.size()))
+        {
+            ++readCountsOfContigs_[contigId];
+        }
+    }
+
     ReferenceContigInfo contigInfo_;
 
-    std::unordered_map<int, int64_t> contigIdToReadCount;
-    int64_t totalReadCount;
-    int64_t sumOfReadLengths;
+    // Read counts of the contigs considered for depth estimation
+    std::vector<int64_t> readCountsOfContigs_;
+    int64_t totalReadCount_ = 0;
+    int64_t sumOfReadLengths_ = 0;
+    bool usesIndexStats_ = false;
+    int64_t numIndexedReads_ = 0;
 };
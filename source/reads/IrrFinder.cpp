@@ -29,6 +29,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "common/ScratchArena.hh"
 #include "common/SequenceUtils.hh"
 #include "reads/Purity.hh"
 
@@ -39,6 +40,8 @@ using std::to_string;
 using std::unordered_map;
 using std::vector;
 
+static const double kMinMatchFrequency = 0.8;
+
 int32_t MaxMatchesAtOffset(int32_t offset, const std::string& bases)
 {
     if (bases.length() < offset)
@@ -90,7 +93,11 @@ int SmallestFrequentPeriod(double minFrequency, const string& bases, const Inter
 
 char ExtractConsensusBase(int32_t offset, int32_t period, const std::string& bases)
 {
-    unordered_map<char, int32_t> char_frequency;
+    // The table lives in a scratch arena to avoid heap allocations; ties are still broken by its iteration order
+    using CharFrequencyAllocator = ScratchAllocator<std::pair<const char, int32_t>>;
+    ScratchArena arena;
+    unordered_map<char, int32_t, std::hash<char>, std::equal_to<char>, CharFrequencyAllocator> char_frequency(
+        0, std::hash<char>(), std::equal_to<char>(), CharFrequencyAllocator(arena));
     for (int32_t index = offset; index < bases.length(); index += period)
     {
         ++char_frequency[bases[index]];
@@ -112,72 +119,146 @@ char ExtractConsensusBase(int32_t offset, int32_t period, const std::string& bas
     return consensus_char;
 }
 
-string ExtractConsensusRepeatUnit(double period, const string& bases)
+static void extractConsensusRepeatUnit(double period, const string& bases, string& repeat_unit)
 {
-    string repeat_unit;
+    repeat_unit.clear();
     for (int32_t offset = 0; offset != period; ++offset)
         repeat_unit += ExtractConsensusBase(offset, period, bases);
+}
 
+string ExtractConsensusRepeatUnit(double period, const string& bases)
+{
+    string repeat_unit;
+    extractConsensusRepeatUnit(period, bases, repeat_unit);
     return repeat_unit;
 }
 
-string MinimialUnitUnderShift(const string& unit)
+// Compares the rotations of the unit starting at the given indexes without materializing them
+static bool isRotationSmaller(const string& unit, size_t index, size_t other_index)
 {
-    string minimal_unit = unit;
-    const string double_unit = unit + unit;
-    for (int32_t index = 0; index != unit.length(); ++index)
+    for (size_t offset = 0; offset != unit.length(); ++offset)
     {
-        string current_unit = double_unit.substr(index, unit.length());
-        if (current_unit < minimal_unit)
-            minimal_unit = current_unit;
+        const char base = unit[(index + offset) % unit.length()];
+        const char other_base = unit[(other_index + offset) % unit.length()];
+        if (base != other_base)
+        {
+            return base < other_base;
+        }
     }
-    return minimal_unit;
+
+    return false;
 }
 
-string ComputeCanonicalRepeatUnit(const string& unit)
+static void minimalUnitUnderShift(const string& unit, string& minimal_unit)
 {
-    const string minimal_unit = MinimialUnitUnderShift(unit);
+    size_t minimal_index = 0;
+    for (size_t index = 1; index < unit.length(); ++index)
+    {
+        if (isRotationSmaller(unit, index, minimal_index))
+            minimal_index = index;
+    }
 
-    const string unit_rc = reverseComplement(unit);
-    const string minimal_unit_rc = MinimialUnitUnderShift(unit_rc);
+    minimal_unit.assign(unit, minimal_index, string::npos);
+    minimal_unit.append(unit, 0, minimal_index);
+}
 
-    if (minimal_unit_rc < minimal_unit)
-        return minimal_unit_rc;
+string MinimialUnitUnderShift(const string& unit)
+{
+    string minimal_unit;
+    minimalUnitUnderShift(unit, minimal_unit);
     return minimal_unit;
 }
 
-string ComputeCanonicalRepeatUnit(double minFrequency, const string& bases, const Interval& motifSizeRange)
+static void computeCanonicalRepeatUnit(const string& unit, string& canonical_unit)
+{
+    thread_local string unit_rc;
+    thread_local string minimal_unit_rc;
+    reverseComplement(unit, unit_rc);
+    minimalUnitUnderShift(unit_rc, minimal_unit_rc);
+
+    minimalUnitUnderShift(unit, canonical_unit);
+    if (minimal_unit_rc < canonical_unit)
+        canonical_unit = minimal_unit_rc;
+}
+
+string ComputeCanonicalRepeatUnit(const string& unit)
+{
+    string canonical_unit;
+    computeCanonicalRepeatUnit(unit, canonical_unit);
+    return canonical_unit;
+}
+
+// Intermediate motifs are kept in per-thread buffers so that classifying a read does not allocate once the buffers
+// have grown to the longest motif
+static void
+computeCanonicalRepeatUnit(double minFrequency, const string& bases, const Interval& motifSizeRange, string& unit)
 {
     const int period = SmallestFrequentPeriod(minFrequency, bases, motifSizeRange);
     if (period == -1)
     {
-        return "";
+        unit.clear();
+        return;
     }
-    string motif = ExtractConsensusRepeatUnit(period, bases);
+
+    thread_local string motif;
+    thread_local string reduced_motif;
+    extractConsensusRepeatUnit(period, bases, motif);
     const double kPerfectMatchFrequency = 1.0;
     const int32_t reducedPeriod = SmallestFrequentPeriod(kPerfectMatchFrequency, motif);
     if (reducedPeriod != -1 && reducedPeriod != period)
     {
-        motif = ExtractConsensusRepeatUnit(reducedPeriod, motif);
+        extractConsensusRepeatUnit(reducedPeriod, motif, reduced_motif);
+        motif.swap(reduced_motif);
     }
-    return ComputeCanonicalRepeatUnit(motif);
+    computeCanonicalRepeatUnit(motif, unit);
+}
+
+string ComputeCanonicalRepeatUnit(double minFrequency, const string& bases, const Interval& motifSizeRange)
+{
+    string unit;
+    computeCanonicalRepeatUnit(minFrequency, bases, motifSizeRange, unit);
+    return unit;
 }
 
 bool IsInrepeatRead(const string& bases, const string& quals, string& unit, const Interval& motifSizeRange)
 {
-    const double min_frequency = 0.8;
-    unit = ComputeCanonicalRepeatUnit(min_frequency, bases, motifSizeRange);
+    computeCanonicalRepeatUnit(kMinMatchFrequency, bases, motifSizeRange, unit);
     if (unit.empty() || unit == "N")
     {
         return false;
     }
 
-    const vector<string> units = { unit };
-    const vector<vector<string>> units_shifts = ShiftUnits(units);
-
-    double score = MatchRepeatRc(units_shifts, bases, quals);
+    double score = MatchUnitShiftsRc(unit, bases, quals);
     score /= bases.length();
 
     const double min_score = 0.90;
     return score >= min_score;
 }
+
+bool HasFrequentPeriod(const string& bases, const Interval& motifSizeRange)
+{
+    const int smallestPeriod = std::max(motifSizeRange.start(), 1);
+    const int largestPeriod = std::min(motifSizeRange.end(), static_cast<int>(bases.length() / 2));
+    for (int offset = smallestPeriod; offset <= largestPeriod; ++offset)
+    {
+        // Same frequency computation as in MatchFrequencyAtOffset, stopping once the frequency cannot be reached
+        const int32_t max_matches = MaxMatchesAtOffset(offset, bases);
+        int32_t num_mismatches = 0;
+        bool is_frequent = true;
+        for (size_t position = 0; is_frequent && position != bases.length() - offset; ++position)
+        {
+            if (bases[position] != bases[position + offset])
+            {
+                ++num_mismatches;
+                is_frequent = (double)(max_matches - num_mismatches) / max_matches >= kMinMatchFrequency;
+            }
+        }
+
+        if (is_frequent)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -41,3 +41,7 @@ std::string ComputeCanonicalRepeatUnit(
 bool IsInrepeatRead(
     const std::string& bases, const std::string& quals, std::string& unit,
     const Interval& motifSizeRange = Interval(1, 20));
+
+// Necessary condition for IsInrepeatRead that does not depend on base qualities: the bases match themselves shifted by
+// some period within the motif size range; if it fails, the read is not an in-repeat read for any narrower range
+bool HasFrequentPeriod(const std::string& bases, const Interval& motifSizeRange = Interval(1, 20));
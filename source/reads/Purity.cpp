@@ -30,6 +30,27 @@
 using std::string;
 using std::vector;
 
+static const size_t kBaseQualOffset = 33;
+static const double kMatchScore = 1.0;
+static const double kLowqualMismatchScore = 0.5;
+static const double kMismatchPenalty = -1.0;
+
+static double scoreBase(char base, char unit_base, char qual, size_t min_baseq)
+{
+    if (base == unit_base)
+    {
+        return kMatchScore;
+    }
+    else if (qual - kBaseQualOffset < min_baseq)
+    {
+        return kLowqualMismatchScore;
+    }
+    else
+    {
+        return kMismatchPenalty;
+    }
+}
+
 double
 MatchRepeatRc(const vector<vector<string>>& units_shifts, const string& bases, const string& quals, size_t min_baseq)
 {
@@ -44,6 +65,46 @@ MatchRepeatRc(const vector<vector<string>>& units_shifts, const string& bases, c
     return std::max(forward_score, reverse_score);
 }
 
+// Scores the bases against the unit shifted by the offset, unit by unit, as MatchRepeat does for a single shift
+static double
+matchUnitShift(const string& unit, size_t offset, const string& bases, const string& quals, size_t min_baseq)
+{
+    const size_t unit_len = unit.length();
+    double score = 0;
+    for (size_t pos = 0; pos < bases.length(); pos += unit_len)
+    {
+        const size_t end = std::min(pos + unit_len, bases.length());
+        double match_count = 0;
+        for (size_t index = pos; index != end; ++index)
+        {
+            const char unit_base = unit[(offset + index - pos) % unit_len];
+            match_count += scoreBase(bases[index], unit_base, quals[index], min_baseq);
+        }
+        score += match_count;
+    }
+
+    return score;
+}
+
+double MatchUnitShiftsRc(const string& unit, const string& bases, const string& quals, size_t min_baseq)
+{
+    // Reverse-complemented reads are kept in per-thread buffers that only grow with the read length
+    thread_local string bases_rc;
+    thread_local string quals_rc;
+    reverseComplement(bases, bases_rc);
+    quals_rc.resize(quals.length());
+    std::reverse_copy(quals.begin(), quals.end(), quals_rc.begin());
+
+    double max_score = std::numeric_limits<double>::lowest();
+    for (size_t offset = 0; offset != unit.length(); ++offset)
+    {
+        max_score = std::max(max_score, matchUnitShift(unit, offset, bases, quals, min_baseq));
+        max_score = std::max(max_score, matchUnitShift(unit, offset, bases_rc, quals_rc, min_baseq));
+    }
+
+    return max_score;
+}
+
 double MatchRepeat(
     const vector<vector<string>>& units_shifts, const string& bases, const string& quals, size_t& match_offset,
     size_t min_baseq)
@@ -112,11 +173,6 @@ double MatchUnits(
     string::const_iterator quals_first, string::const_iterator quals_last, size_t min_baseq)
 {
     double max_match_count = std::numeric_limits<double>::lowest();
-    const size_t kBaseQualOffset = 33;
-    const double kMatchScore = 1.0;
-    const double kLowqualMismatchScore = 0.5;
-    const double kMismatchPenalty = -1.0;
-
     for (const string& unit : units)
     {
         string::const_iterator unit_first = unit.begin();
@@ -126,18 +182,7 @@ double MatchUnits(
         double match_count = 0;
         while (bases_first_copy != bases_last)
         {
-            if (*bases_first_copy == *unit_first)
-            {
-                match_count += kMatchScore;
-            }
-            else if (*quals_first_copy - kBaseQualOffset < min_baseq)
-            {
-                match_count += kLowqualMismatchScore;
-            }
-            else
-            {
-                match_count += kMismatchPenalty;
-            }
+            match_count += scoreBase(*bases_first_copy, *unit_first, *quals_first_copy, min_baseq);
 
             ++bases_first_copy;
             ++quals_first_copy;
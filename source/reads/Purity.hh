@@ -29,6 +29,10 @@ double MatchRepeatRc(
     const std::vector<std::vector<std::string>>& units_shifts, const std::string& bases, const std::string& quals,
     size_t min_baseq = 20);
 
+// Same score as MatchRepeatRc(ShiftUnits({ unit }), ...) computed without materializing the shifts or allocating
+double MatchUnitShiftsRc(
+    const std::string& unit, const std::string& bases, const std::string& quals, size_t min_baseq = 20);
+
 double MatchRepeat(
     const std::vector<std::vector<std::string>>& units_shifts, const std::string& bases, const std::string& quals,
     size_t& match_offset, size_t min_baseq = 20);
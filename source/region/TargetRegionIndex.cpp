@@ -0,0 +1,130 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "region/TargetRegionIndex.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+TargetRegionIndex::TargetRegionIndex(int numContigs, const vector<GenomicRegion>& targets)
+    : intervalsByContig_(numContigs)
+{
+    for (const auto& target : targets)
+    {
+        if (target.contigId() < 0 || target.contigId() >= numContigs)
+        {
+            throw std::logic_error("Target region refers to an unknown contig");
+        }
+        intervalsByContig_[target.contigId()].emplace_back(target.start(), target.end());
+    }
+
+    // Overlapping intervals are combined, so both starts and ends of the remaining intervals are sorted
+    for (auto& intervals : intervalsByContig_)
+    {
+        std::sort(intervals.begin(), intervals.end());
+        vector<pair<int64_t, int64_t>> disjointIntervals;
+        for (const auto& interval : intervals)
+        {
+            if (!disjointIntervals.empty() && interval.first <= disjointIntervals.back().second)
+            {
+                disjointIntervals.back().second = std::max(disjointIntervals.back().second, interval.second);
+            }
+            else
+            {
+                disjointIntervals.push_back(interval);
+            }
+        }
+        intervals = std::move(disjointIntervals);
+    }
+}
+
+bool TargetRegionIndex::overlaps(int contigId, int64_t start, int64_t end) const
+{
+    if (contigId < 0 || contigId >= static_cast<int>(intervalsByContig_.size()))
+    {
+        return false;
+    }
+
+    // The first interval ending at or after the start of the region is the only candidate for an overlap
+    const auto& intervals = intervalsByContig_[contigId];
+    const auto candidate = std::lower_bound(
+        intervals.begin(), intervals.end(), start,
+        [](const pair<int64_t, int64_t>& interval, int64_t position) { return interval.second < position; });
+    return candidate != intervals.end() && candidate->first <= end;
+}
+
+size_t TargetRegionIndex::numIntervals() const
+{
+    size_t numIntervals = 0;
+    for (const auto& intervals : intervalsByContig_)
+    {
+        numIntervals += intervals.size();
+    }
+
+    return numIntervals;
+}
+
+TargetRegionIndex loadTargetRegionIndex(const string& path, const ReferenceContigInfo& contigInfo)
+{
+    std::ifstream bedFile(path);
+    if (!bedFile)
+    {
+        throw std::runtime_error("Unable to read target regions from " + path);
+    }
+
+    vector<GenomicRegion> targets;
+    string line;
+    while (std::getline(bedFile, line))
+    {
+        if (line.empty() || line[0] == '#' || line.compare(0, 5, "track") == 0 || line.compare(0, 7, "browser") == 0)
+        {
+            continue;
+        }
+
+        std::istringstream decoder(line);
+        string contigName;
+        int64_t start;
+        int64_t end;
+        if (!(decoder >> contigName >> start >> end) || end < start)
+        {
+            throw std::runtime_error("Unable to decode target region " + line);
+        }
+
+        int contigId;
+        try
+        {
+            contigId = contigInfo.getContigId(contigName);
+        }
+        catch (const std::logic_error&)
+        {
+            continue;
+        }
+        targets.emplace_back(contigId, start, end);
+    }
+
+    return TargetRegionIndex(contigInfo.numContigs(), targets);
+}
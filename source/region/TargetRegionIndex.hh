@@ -0,0 +1,53 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "region/GenomicRegion.hh"
+#include "region/ReferenceContigInfo.hh"
+
+// Target regions of each contig kept as sorted disjoint intervals, so overlaps are found by binary search
+class TargetRegionIndex
+{
+public:
+    TargetRegionIndex(int numContigs, const std::vector<GenomicRegion>& targets);
+
+    // Regions overlap targets if they share at least one position with them (as in GenomicRegion::overlaps());
+    // unaligned regions do not overlap any targets
+    bool overlaps(int contigId, int64_t start, int64_t end) const;
+    bool overlaps(const GenomicRegion& region) const
+    {
+        return overlaps(region.contigId(), region.start(), region.end());
+    }
+
+    size_t numIntervals() const;
+
+private:
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> intervalsByContig_;
+};
+
+// Loads the first three columns of a BED file; targets on contigs missing from the reference are skipped
+TargetRegionIndex loadTargetRegionIndex(const std::string& path, const ReferenceContigInfo& contigInfo);
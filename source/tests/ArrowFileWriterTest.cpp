@@ -0,0 +1,83 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/ArrowFileWriter.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::string;
+
+static int32_t readInt32(const string& bytes, size_t offset)
+{
+    int32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+TEST_CASE("Arrow files are framed by magic strings and footer", "[arrow]")
+{
+    const string path = "ArrowFileWriterTest.arrow";
+    {
+        ArrowFileWriter writer(path, { { "name", ArrowType::kUtf8 }, { "count", ArrowType::kInt32, true } }, 2);
+        writer.appendUtf8("first");
+        writer.appendInt32(1);
+        writer.appendUtf8("second");
+        writer.appendNull();
+        writer.appendUtf8("third");
+        writer.appendInt32(3);
+        writer.finish();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    const string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    REQUIRE(bytes.size() % 8 == 2);
+    REQUIRE(bytes.compare(0, 8, string("ARROW1\0\0", 8)) == 0);
+    REQUIRE(bytes.compare(bytes.size() - 6, 6, "ARROW1") == 0);
+
+    // Messages are prefixed with a continuation marker and the stream is terminated by a zero-length message
+    REQUIRE(readInt32(bytes, 8) == -1);
+    const int32_t footerLength = readInt32(bytes, bytes.size() - 10);
+    const size_t footerOffset = bytes.size() - 10 - footerLength;
+    REQUIRE(readInt32(bytes, footerOffset - 8) == -1);
+    REQUIRE(readInt32(bytes, footerOffset - 4) == 0);
+    REQUIRE(bytes.find("second") != string::npos);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Values must match the schema of Arrow files", "[arrow]")
+{
+    const string path = "ArrowFileWriterTest.arrow";
+    ArrowFileWriter writer(path, { { "name", ArrowType::kUtf8 }, { "count", ArrowType::kInt32 } });
+    REQUIRE_THROWS_AS(writer.appendInt32(1), std::logic_error);
+    writer.appendUtf8("first");
+    REQUIRE_THROWS_AS(writer.appendNull(), std::logic_error);
+    REQUIRE_THROWS_AS(writer.finish(), std::logic_error);
+
+    std::remove(path.c_str());
+}
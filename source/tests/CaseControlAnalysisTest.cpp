@@ -0,0 +1,104 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/CaseControlAnalysis.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+TEST_CASE("Rank-sum p-value is computed with normal approximation", "[case-control analysis]")
+{
+    RankSumTest test({ true, true, false, false });
+
+    const vector<pair<int, double>> counts = { { 0, 10.0 }, { 1, 8.0 }, { 3, 1.0 } };
+    REQUIRE(test.computePvalue(counts) == Approx(0.06066763));
+}
+
+TEST_CASE("Tied counts receive average ranks", "[case-control analysis]")
+{
+    RankSumTest test({ true, true, false, false });
+
+    const vector<pair<int, double>> counts = { { 1, 3.0 }, { 2, 3.0 } };
+    REQUIRE(test.computePvalue(counts) == Approx(0.5));
+    REQUIRE(test.computePvalue({}) == Approx(0.5));
+}
+
+TEST_CASE("P-values of rows tested in several batches are corrected for all tests", "[case-control analysis]")
+{
+    const int kNumCases = 20;
+    const int kNumMotifs = 5000;
+    SampleIdToSampleParameters parametersForSamples;
+    SampleIdToSampleStatus sampleStatuses;
+    SampleToIrrPairCount irrPairCounts;
+    vector<pair<int, double>> cohortCounts;
+    for (int sampleIndex = 0; sampleIndex != 2 * kNumCases; ++sampleIndex)
+    {
+        const SampleId sampleId = "sample" + std::to_string(100 + sampleIndex);
+        parametersForSamples.emplace(sampleId, SampleParameters(150, 40));
+        sampleStatuses.emplace(sampleId, sampleIndex < kNumCases ? SampleStatus::kCase : SampleStatus::kControl);
+        if (sampleIndex < kNumCases)
+        {
+            irrPairCounts.emplace(sampleId, 5);
+            cohortCounts.emplace_back(sampleIndex, 5.0);
+        }
+    }
+    const CohortSamples samples(parametersForSamples, sampleStatuses);
+    const double pvalue = RankSumTest(samples.isCase()).computePvalue(cohortCounts);
+
+    const string pathToLocusTable = "CaseControlAnalysisTest.locus.tsv";
+    const string pathToMotifTable = "CaseControlAnalysisTest.motif.tsv";
+    const ReferenceContigInfo contigInfo({});
+    CaseControlTableWriter writer(contigInfo, samples, pathToLocusTable, pathToMotifTable, 5, 5, 2);
+    for (int motifIndex = 0; motifIndex != kNumMotifs; ++motifIndex)
+    {
+        writer.addMotif("CAG" + std::to_string(10000 + motifIndex), &irrPairCounts, nullptr);
+    }
+    writer.finish();
+
+    std::ifstream motifTable(pathToMotifTable);
+    string line;
+    std::getline(motifTable, line);
+    int numRows = 0;
+    while (std::getline(motifTable, line))
+    {
+        REQUIRE(line.compare(0, 8, "CAG" + std::to_string(10000 + numRows)) == 0);
+        const char* pvalueStart = line.c_str() + line.find('\t') + 1;
+        char* correctedPvalueStart;
+        REQUIRE(std::strtod(pvalueStart, &correctedPvalueStart) == pvalue);
+        REQUIRE(std::strtod(correctedPvalueStart + 1, nullptr) == Approx(pvalue * kNumMotifs));
+        ++numRows;
+    }
+    REQUIRE(numRows == kNumMotifs);
+    REQUIRE(!std::ifstream(pathToMotifTable + ".tmp"));
+
+    std::remove(pathToLocusTable.c_str());
+    std::remove(pathToMotifTable.c_str());
+}
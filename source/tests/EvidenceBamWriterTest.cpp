@@ -0,0 +1,109 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/EvidenceBamWriter.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::string;
+using std::vector;
+
+static bam1_t* parseRecord(bam_hdr_t* header, string samLine)
+{
+    kstring_t line = { samLine.size(), samLine.size() + 1, &samLine[0] };
+    bam1_t* record = bam_init1();
+    REQUIRE(sam_parse1(&line, header, record) >= 0);
+    return record;
+}
+
+static void addRecord(
+    EvidenceBamWriter& writer, bam_hdr_t* header, const string& samLine, ReadType readType,
+    boost::optional<ReadType> mateType)
+{
+    bam1_t* record = parseRecord(header, samLine);
+    writer.add(record, readType, mateType);
+    bam_destroy1(record);
+}
+
+// Names and positions of the records of a BAM file
+static vector<string> listRecords(const string& path)
+{
+    samFile* filePtr = sam_open(path.c_str(), "r");
+    REQUIRE(filePtr);
+    bam_hdr_t* header = sam_hdr_read(filePtr);
+    bam1_t* record = bam_init1();
+    vector<string> records;
+    while (sam_read1(filePtr, header, record) >= 0)
+    {
+        records.push_back(string(bam_get_qname(record)) + ":" + std::to_string(record->core.pos + 1));
+    }
+    bam_destroy1(record);
+    bam_hdr_destroy(header);
+    sam_close(filePtr);
+    return records;
+}
+
+static vector<string> writeEvidenceBam(const string& path, size_t memoryBudget)
+{
+    const string headerText = "@SQ\tSN:chr1\tLN:100\n";
+    bam_hdr_t* header = sam_hdr_parse(headerText.size(), headerText.c_str());
+
+    const string irr = "\t=\t1\t0\tCGGCGGCGGC\t*";
+    {
+        EvidenceBamWriter writer("unused.bam", "unused.fa", header, path, 1, memoryBudget);
+        // An IRR pair, an anchored IRR with the anchor after the IRR, an IRR paired with an uninformative read, and
+        // an IRR whose mate is missing
+        addRecord(writer, header, "irrPair\t65\tchr1\t30\t0\t10M" + irr, ReadType::kIrrRead, boost::none);
+        addRecord(writer, header, "anchored\t65\tchr1\t20\t0\t10M" + irr, ReadType::kIrrRead, boost::none);
+        addRecord(writer, header, "other\t65\tchr1\t40\t0\t10M" + irr, ReadType::kIrrRead, boost::none);
+        addRecord(writer, header, "unpaired\t65\tchr1\t50\t0\t10M" + irr, ReadType::kIrrRead, boost::none);
+        addRecord(writer, header, "irrPair\t129\tchr1\t10\t0\t10M" + irr, ReadType::kIrrRead, ReadType::kIrrRead);
+        addRecord(
+            writer, header, "anchored\t129\tchr1\t60\t60\t10M" + irr, ReadType::kAnchorRead, ReadType::kIrrRead);
+        addRecord(writer, header, "other\t129\tchr1\t5\t60\t10M" + irr, ReadType::kOtherRead, ReadType::kIrrRead);
+        writer.finish();
+        REQUIRE(writer.numRecords() == 4);
+    }
+    bam_hdr_destroy(header);
+
+    return listRecords(path);
+}
+
+TEST_CASE("Evidence bamlets do not depend on the memory budget", "[evidence bamlet]")
+{
+    const string path = "EvidenceBamWriterTest.bam";
+    const vector<string> expectedRecords = { "irrPair:10", "anchored:20", "irrPair:30", "anchored:60" };
+
+    REQUIRE(writeEvidenceBam(path, kDefaultEvidenceBamMemoryBudget) == expectedRecords);
+
+    // Every record is spilled as soon as it is added
+    REQUIRE(writeEvidenceBam(path, 1) == expectedRecords);
+    REQUIRE(!std::ifstream(path + ".chunk0.tmp"));
+    REQUIRE(!std::ifstream(path + ".irrs.tmp"));
+
+    std::remove(path.c_str());
+    std::remove((path + ".bai").c_str());
+}
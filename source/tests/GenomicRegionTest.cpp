@@ -20,6 +20,7 @@
 // limitations under the License.
 
 #include "region/GenomicRegion.hh"
+#include "region/TargetRegionIndex.hh"
 
 #include "thirdparty/catch2/catch.hpp"
 
@@ -142,3 +143,19 @@ TEST_CASE("Unaligned regions can be decoded", "[manipulating regions]")
     GenomicRegion expectedRegion(-1, 0, 0);
     REQUIRE(region == expectedRegion);
 }
+
+TEST_CASE("Target region index finds regions sharing positions with targets", "[target regions]")
+{
+    const vector<GenomicRegion> targets = { { 1, 500, 600 }, { 0, 100, 200 }, { 0, 150, 300 }, { 0, 1000, 1100 } };
+    const TargetRegionIndex index(3, targets);
+
+    REQUIRE(index.numIntervals() == 3);
+    REQUIRE(index.overlaps(GenomicRegion(0, 250, 260)));
+    REQUIRE(index.overlaps(GenomicRegion(0, 50, 100)));
+    REQUIRE(index.overlaps(GenomicRegion(0, 300, 1000)));
+    REQUIRE(index.overlaps(GenomicRegion(0, 0, 5000)));
+    REQUIRE_FALSE(index.overlaps(GenomicRegion(0, 301, 999)));
+    REQUIRE_FALSE(index.overlaps(GenomicRegion(0, 1101, 1200)));
+    REQUIRE_FALSE(index.overlaps(GenomicRegion(2, 100, 200)));
+    REQUIRE_FALSE(index.overlaps(GenomicRegion(-1, 0, 0)));
+}
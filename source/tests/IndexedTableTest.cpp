@@ -0,0 +1,77 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/IndexedTable.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+extern "C"
+{
+#include "htslib/kstring.h"
+#include "htslib/tbx.h"
+}
+
+using std::string;
+using std::vector;
+
+static vector<string> queryTable(const string& path, const string& region)
+{
+    htsFile* filePtr = hts_open(path.c_str(), "r");
+    tbx_t* indexPtr = tbx_index_load(path.c_str());
+    hts_itr_t* iteratorPtr = tbx_itr_querys(indexPtr, region.c_str());
+
+    vector<string> rows;
+    kstring_t row = { 0, 0, nullptr };
+    while (iteratorPtr && tbx_itr_next(filePtr, indexPtr, iteratorPtr, &row) >= 0)
+    {
+        rows.emplace_back(row.s, row.l);
+    }
+
+    free(row.s);
+    tbx_itr_destroy(iteratorPtr);
+    tbx_destroy(indexPtr);
+    hts_close(filePtr);
+    return rows;
+}
+
+TEST_CASE("Rows of indexed tables are found by region", "[indexed table]")
+{
+    const string path = "IndexedTableTest.tsv.gz";
+    const string table = "contig\tstart\tend\tmotif\n"
+                         "chr1\t100\t200\tCAG\n"
+                         "chr1\t5000\t5100\tAT\n"
+                         "chr2\t100\t150\tCCG\n";
+
+    IndexedTableWriter writer(path, 2);
+    writer.write(table.data(), table.size());
+    writer.close();
+
+    REQUIRE(queryTable(path, "chr1:150-160") == vector<string>{ "chr1\t100\t200\tCAG" });
+    REQUIRE(queryTable(path, "chr1:300-4000").empty());
+    REQUIRE(queryTable(path, "chr2") == vector<string>{ "chr2\t100\t150\tCCG" });
+
+    std::remove(path.c_str());
+    std::remove((path + ".tbi").c_str());
+}
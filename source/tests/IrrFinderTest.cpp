@@ -219,3 +219,15 @@ TEST_CASE("Reads made Ns are not inrepeat reads", "[Determining motif]")
     string unit;
     REQUIRE(!IsInrepeatRead(n_bases, quals, unit));
 }
+
+TEST_CASE("Reads without frequent period are not inrepeat reads for any motif size", "[Determining motif]")
+{
+    const string irr = "CCGCCGCCGCCGACGCCGCCGCCGCCGCCG";
+    REQUIRE(HasFrequentPeriod(irr, Interval(1, 20)));
+    REQUIRE(HasFrequentPeriod(irr, Interval(3, 3)));
+    REQUIRE(!HasFrequentPeriod(irr, Interval(1, 2)));
+
+    const string nonrepeat = "ACGTTGCAAGCTAGGCTTACCGATGCAATC";
+    REQUIRE(!HasFrequentPeriod(nonrepeat, Interval(1, 50)));
+    REQUIRE(!HasFrequentPeriod("", Interval(1, 20)));
+}
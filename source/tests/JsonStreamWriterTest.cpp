@@ -0,0 +1,75 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/JsonStreamWriter.hh"
+
+#include <sstream>
+
+#include "thirdparty/catch2/catch.hpp"
+#include "thirdparty/nlohmann_json/json.hpp"
+
+using Json = nlohmann::json;
+
+TEST_CASE("Streamed JSON matches serialized document", "[json stream writer]")
+{
+    Json document;
+    document["Counts"]["CAG"]["chr1:100-200"]["sample\t1"] = 5;
+    document["Counts"]["CAG"]["unaligned"]["sample2"] = 7;
+    document["Empty"] = Json::object();
+    document["Missing"] = nullptr;
+    document["Parameters"]["Depths"]["sample2"] = 31.70;
+
+    std::ostringstream out;
+    JsonStreamWriter writer(out, 4);
+    writer.startObject();
+    writer.key("Counts");
+    writer.startObject();
+    writer.key("CAG");
+    writer.startObject();
+    writer.key("chr1:100-200");
+    writer.startObject();
+    writer.key("sample\t1");
+    writer.value(5);
+    writer.endObject();
+    writer.key("unaligned");
+    writer.startObject();
+    writer.key("sample2");
+    writer.value(7);
+    writer.endObject();
+    writer.endObject();
+    writer.endObject();
+    writer.key("Empty");
+    writer.startObject();
+    writer.endObject();
+    writer.key("Missing");
+    writer.null();
+    writer.key("Parameters");
+    writer.startObject();
+    writer.key("Depths");
+    writer.startObject();
+    writer.key("sample2");
+    writer.value(31.70);
+    writer.endObject();
+    writer.endObject();
+    writer.endObject();
+
+    REQUIRE(out.str() == document.dump(4));
+}
@@ -0,0 +1,160 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MergeWorkflow.hh"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "thirdparty/catch2/catch.hpp"
+
+#include "io/StrProfile.hh"
+#include "merge/MergeParameters.hh"
+
+namespace fs = boost::filesystem;
+
+using std::pair;
+using std::string;
+using std::vector;
+
+using Json = nlohmann::json;
+
+// Writes a reference and the profiles of three samples to a temporary directory. The regions of sample0 and sample1
+// are too far apart to be merged, but the region of sample2 lies between them and bridges them into one region.
+class MergeTestData
+{
+public:
+    MergeTestData()
+        : directory_(fs::temp_directory_path() / fs::unique_path())
+    {
+        fs::create_directories(directory_);
+        std::ofstream(pathToReference()) << ">chr1\n" << string(5000, 'A') << "\n";
+
+        const vector<int64_t> regionStarts = { 1000, 2100, 1550 };
+        for (int sampleIndex = 0; sampleIndex != 3; ++sampleIndex)
+        {
+            StrProfile profile(ReferenceContigInfo(vector<pair<string, int64_t>>{ { "chr1", 5000 } }));
+            profile.readLength = 150;
+            profile.depth = 30 + sampleIndex;
+            MotifRecord& record = profile.motifRecords["CAG"];
+            record.anchoredIrrCount = sampleIndex + 1;
+            record.irrPairCount = sampleIndex;
+            record.regionsWithIrrAnchors.emplace_back(
+                0, regionStarts[sampleIndex], regionStarts[sampleIndex] + 100, CountFeature(sampleIndex + 1));
+            writeStrProfile(profile, StrProfileFormat::kJson, pathToSampleProfile(sampleIndex));
+        }
+    }
+
+    ~MergeTestData() { fs::remove_all(directory_); }
+
+    string pathToReference() const { return (directory_ / "reference.fa").string(); }
+    string pathToSampleProfile(int sampleIndex) const
+    {
+        return (directory_ / ("sample" + std::to_string(sampleIndex) + ".str_profile.json")).string();
+    }
+
+    // Each manifest entry is a pair of a sample id and a path to a profile
+    string writeManifest(const string& name, const vector<pair<string, string>>& entries) const
+    {
+        const string path = (directory_ / (name + ".manifest.tsv")).string();
+        std::ofstream manifestFile(path);
+        for (const auto& entry : entries)
+        {
+            manifestFile << entry.first << "\tcase\t" << entry.second << "\n";
+        }
+        return path;
+    }
+
+    // Returns the path to the multisample profile
+    string merge(const string& name, const string& pathToManifest, MergeWorkflowOptions options = {}) const
+    {
+        const string outputPrefix = (directory_ / name).string();
+        const MergeWorkflowParameters parameters(pathToReference(), outputPrefix, pathToManifest, 2, 20, options);
+        runMergeWorkflow(parameters);
+        return parameters.pathToMultisampleProfile();
+    }
+
+private:
+    fs::path directory_;
+};
+
+static Json loadJson(const string& path)
+{
+    Json json;
+    std::ifstream(path) >> json;
+    return json;
+}
+
+TEST_CASE("Adding samples to a multisample profile matches merging all samples", "[merge workflow]")
+{
+    const MergeTestData data;
+    const vector<pair<string, string>> allSamples = { { "sample0", data.pathToSampleProfile(0) },
+                                                      { "sample1", data.pathToSampleProfile(1) },
+                                                      { "sample2", data.pathToSampleProfile(2) } };
+    const string pathToFullManifest = data.writeManifest("full", allSamples);
+    const string pathToBaseManifest = data.writeManifest("base", { allSamples[0], allSamples[1] });
+
+    for (size_t memoryBudget : { size_t(0), size_t(1) })
+    {
+        MergeWorkflowOptions options;
+        options.memoryBudget = memoryBudget;
+        const Json fullProfile = loadJson(data.merge("full", pathToFullManifest, options));
+
+        options.pathToBaseProfile = data.merge("base", pathToBaseManifest, options);
+        REQUIRE(loadJson(options.pathToBaseProfile)["Counts"]["CAG"]["RegionsWithIrrAnchors"].size() == 2);
+        const Json incrementalProfile = loadJson(data.merge("incremental", pathToFullManifest, options));
+
+        REQUIRE(fullProfile["Counts"]["CAG"]["RegionsWithIrrAnchors"].size() == 1);
+        REQUIRE(incrementalProfile == fullProfile);
+    }
+}
+
+TEST_CASE("Samples present in more than one input are rejected", "[merge workflow]")
+{
+    const MergeTestData data;
+    const string firstShard = data.merge(
+        "shard1",
+        data.writeManifest(
+            "shard1", { { "sample0", data.pathToSampleProfile(0) }, { "sample1", data.pathToSampleProfile(1) } }));
+    const string secondShard = data.merge(
+        "shard2",
+        data.writeManifest(
+            "shard2", { { "sample1", data.pathToSampleProfile(1) }, { "sample2", data.pathToSampleProfile(2) } }));
+
+    // Counts of sample1 would otherwise be added twice
+    const string pathToManifest = data.writeManifest("cohort", { { "shard1", firstShard }, { "shard2", secondShard } });
+    for (size_t memoryBudget : { size_t(0), size_t(1) })
+    {
+        MergeWorkflowOptions options;
+        options.memoryBudget = memoryBudget;
+        REQUIRE_THROWS_AS(data.merge("cohort", pathToManifest, options), std::runtime_error);
+    }
+
+    MergeWorkflowOptions options;
+    options.pathToBaseProfile = firstShard;
+    REQUIRE_THROWS_AS(
+        data.merge("cohort", data.writeManifest("update", { { "shard2", secondShard } }), options), std::runtime_error);
+}
@@ -0,0 +1,122 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/MultisampleStore.hh"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+TEST_CASE("Multisample store supports motif, sample, and region lookups", "[multisample store]")
+{
+    const string path = "MultisampleStoreTest.bin";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 10000 }, { "chr2", 5000 } });
+    SampleIdToSampleParameters parametersForSamples;
+    parametersForSamples.emplace("s1", SampleParameters(150, 30.0));
+    parametersForSamples.emplace("s2", SampleParameters(100, 40.5));
+
+    const SampleToIrrPairCount cagPairCounts = { { "s1", 3 } };
+    const vector<RegionWithSampleCount> cagRegions
+        = { RegionWithSampleCount(0, 100, 200, SampleCountFeature({ { "s1", 2 }, { "s2", 5 } })),
+            RegionWithSampleCount(0, 2000, 4000, SampleCountFeature({ { "s2", 1 } })),
+            RegionWithSampleCount(-1, 0, 0, SampleCountFeature({ { "s1", 7 } })) };
+    const vector<RegionWithSampleCount> ggccccRegions
+        = { RegionWithSampleCount(0, 150, 300, SampleCountFeature({ { "s2", 4 } })),
+            RegionWithSampleCount(1, 10, 20, SampleCountFeature({ { "s1", 9 } })) };
+
+    {
+        MultisampleStoreWriter writer(contigInfo, parametersForSamples, path);
+        writer.addMotif("CAG", &cagPairCounts, &cagRegions);
+        writer.addMotif("GGCCCC", nullptr, &ggccccRegions);
+        writer.finish();
+    }
+
+    MultisampleStore store(path);
+    REQUIRE(store.numSamples() == 2);
+    REQUIRE(store.sampleId(store.findSample("s2")) == "s2");
+    REQUIRE(store.sampleParameters(store.findSample("s2")).depth == 40.5);
+    REQUIRE(store.findSample("s3") == -1);
+
+    REQUIRE(store.numMotifs() == 2);
+    const int cagIndex = store.findMotif("CAG");
+    REQUIRE(store.motif(cagIndex) == "CAG");
+    REQUIRE(store.findMotif("AT") == -1);
+    REQUIRE(store.getIrrPairCounts(cagIndex, {}) == cagPairCounts);
+
+    vector<RegionWithSampleCount> expectedCagRegions = { cagRegions[2], cagRegions[0], cagRegions[1] };
+    REQUIRE(store.getRegions(cagIndex, {}) == expectedCagRegions);
+
+    vector<bool> selectedSamples(2, false);
+    selectedSamples[store.findSample("s1")] = true;
+    const auto overlappingRegions = store.getOverlappingRegions(GenomicRegion(0, 180, 3000), selectedSamples);
+    REQUIRE(overlappingRegions.size() == 1);
+    REQUIRE(overlappingRegions.front().first == cagIndex);
+    REQUIRE(overlappingRegions.front().second.feature().value() == SampleCountFeature({ { "s1", 2 } }).value());
+
+    REQUIRE(store.getOverlappingRegions(GenomicRegion(0, 180, 3000), {}).size() == 3);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Multisample store rejects counts of samples outside of the sample table", "[multisample store]")
+{
+    const string path = "MultisampleStoreCorruptionTest.bin";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 10000 } });
+    SampleIdToSampleParameters parametersForSamples;
+    parametersForSamples.emplace("s1", SampleParameters(150, 30.0));
+
+    const SampleToIrrPairCount cagPairCounts = { { "s1", 3 } };
+    const vector<RegionWithSampleCount> cagRegions
+        = { RegionWithSampleCount(0, 100, 200, SampleCountFeature({ { "s1", 2 } })) };
+
+    {
+        MultisampleStoreWriter writer(contigInfo, parametersForSamples, path);
+        writer.addMotif("CAG", &cagPairCounts, &cagRegions);
+        writer.finish();
+    }
+
+    {
+        std::fstream storeFile(path, std::ios::in | std::ios::out | std::ios::binary);
+        StoreHeader header;
+        storeFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+        StoredMotif motif;
+        storeFile.seekg(header.motifTableOffset);
+        storeFile.read(reinterpret_cast<char*>(&motif), sizeof(motif));
+
+        const uint32_t invalidSampleIndex = header.numSamples;
+        storeFile.seekp(motif.irrPairCountsOffset + offsetof(StoredCount, sampleIndex));
+        storeFile.write(reinterpret_cast<const char*>(&invalidSampleIndex), sizeof(invalidSampleIndex));
+    }
+
+    MultisampleStore store(path);
+    REQUIRE_THROWS_AS(store.getIrrPairCounts(store.findMotif("CAG"), {}), std::runtime_error);
+    REQUIRE(store.getRegions(store.findMotif("CAG"), {}) == cagRegions);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,67 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/OutlierAnalysis.hh"
+
+#include <utility>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::vector;
+
+TEST_CASE("Cases with counts far above the cohort are outliers", "[outlier analysis]")
+{
+    vector<bool> isCase(100, false);
+    isCase[3] = true;
+    isCase[7] = true;
+    OutlierScorer scorer(isCase);
+
+    const vector<pair<int, double>> counts = { { 3, 50.0 }, { 7, 0.5 }, { 10, 2.0 } };
+    const OutlierScore score = scorer.score(counts, 1);
+    REQUIRE(score.highCaseCounts == vector<pair<int, double>>{ { 3, 50.0 } });
+    REQUIRE(score.topCaseZscore > 40);
+
+    const OutlierScore repeatedScore = scorer.score(counts, 1);
+    REQUIRE(repeatedScore.topCaseZscore == score.topCaseZscore);
+}
+
+TEST_CASE("Uniform counts produce no outliers", "[outlier analysis]")
+{
+    vector<bool> isCase = { true, false, false, false };
+    OutlierScorer scorer(isCase);
+
+    const vector<pair<int, double>> counts = { { 0, 5.0 }, { 1, 5.0 }, { 2, 5.0 }, { 3, 5.0 } };
+    const OutlierScore score = scorer.score(counts, 42);
+    REQUIRE(score.highCaseCounts.empty());
+    REQUIRE(score.topCaseZscore == -1);
+}
+
+TEST_CASE("Controls are never reported as outliers", "[outlier analysis]")
+{
+    vector<bool> isCase(20, true);
+    isCase[0] = false;
+    OutlierScorer scorer(isCase);
+
+    const OutlierScore score = scorer.score({ { 0, 100.0 } }, 42);
+    REQUIRE(score.highCaseCounts.empty());
+}
@@ -0,0 +1,76 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/ProfileBundle.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::string;
+using std::vector;
+
+static void truncateFile(const string& path, int numBytesToRemove)
+{
+    std::ifstream file(path, std::ios::binary);
+    string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(contents.data(), contents.size() - numBytesToRemove);
+}
+
+TEST_CASE("Profiles appended to a bundle can be read by sample id", "[profile bundle]")
+{
+    const string path = "ProfileBundleTest.bundle";
+    std::remove(path.c_str());
+
+    appendToProfileBundle(path, "sample1", "{\"Depth\": 30.0}\n");
+    appendToProfileBundle(path, "sample2", string("EHDNSTRB\x01\x00", 10));
+    appendToProfileBundle(path, "sample1", "{\"Depth\": 31.0}\n");
+
+    {
+        ProfileBundleReader bundle(path);
+        REQUIRE(bundle.sampleIds() == vector<string>({ "sample1", "sample2" }));
+        REQUIRE(bundle.readProfile("sample1") == "{\"Depth\": 31.0}\n");
+        REQUIRE(bundle.readProfile("sample2") == string("EHDNSTRB\x01\x00", 10));
+        REQUIRE_FALSE(bundle.contains("sample3"));
+        REQUIRE_THROWS(bundle.readProfile("sample3"));
+    }
+
+    // Profiles written completely before an interrupted append are recovered
+    appendToProfileBundle(path, "sample3", "{\"Depth\": 32.0}\n");
+    truncateFile(path, 3);
+    REQUIRE(ProfileBundleReader(path).sampleIds() == vector<string>({ "sample1", "sample2", "sample3" }));
+
+    appendToProfileBundle(path, "sample4", string(1000, 'A'));
+    truncateFile(path, 200);
+    REQUIRE(ProfileBundleReader(path).sampleIds() == vector<string>({ "sample1", "sample2", "sample3" }));
+
+    appendToProfileBundle(path, "sample5", "{}");
+    ProfileBundleReader bundle(path);
+    REQUIRE(bundle.sampleIds() == vector<string>({ "sample1", "sample2", "sample3", "sample5" }));
+    REQUIRE(bundle.readProfile("sample5") == "{}");
+
+    std::remove(path.c_str());
+}
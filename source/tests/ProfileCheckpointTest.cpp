@@ -0,0 +1,119 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ProfileCheckpoint.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "profile/ProfileParameters.hh"
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+static Read makeRead(const string& name, int contigId, size_t pos)
+{
+    Read read;
+    read.name = name;
+    read.contigId = contigId;
+    read.pos = pos;
+    read.mateContigId = -1;
+    read.matePos = 0;
+    read.mapq = 60;
+    read.flag = 0;
+    return read;
+}
+
+TEST_CASE("Runs resumed from a checkpoint continue with the saved state", "[profile checkpoint]")
+{
+    const string path = "ProfileCheckpointTest.checkpoint";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 1000 }, { "chr2", 2000 } });
+
+    SampleRunStatsCalculator statsCalculator(contigInfo);
+    PairCollector pairCollector(contigInfo);
+    statsCalculator.inspect(0, 100);
+    statsCalculator.inspect(1, 100);
+    pairCollector.addIrr(makeRead("frag1", 0, 100), "CAG");
+    pairCollector.addAnchor(makeRead("frag1", 0, 50));
+    pairCollector.addIrr(makeRead("frag2", 1, 500), "CAG");
+    pairCollector.addOtherRead(makeRead("frag3", 1, 700));
+
+    ProfileCheckpoint checkpoint;
+    checkpoint.numReads = 6;
+    checkpoint.streamPosition.virtualOffset = 123456;
+    checkpoint.streamPosition.numRecordsRead = 7;
+    saveProfileCheckpoint(path, "key", checkpoint, statsCalculator, pairCollector);
+
+    SampleRunStatsCalculator resumedStatsCalculator(contigInfo);
+    PairCollector resumedPairCollector(contigInfo);
+    REQUIRE_THROWS(loadProfileCheckpoint(path, "other key", resumedStatsCalculator, resumedPairCollector));
+
+    const ProfileCheckpoint resumedCheckpoint
+        = loadProfileCheckpoint(path, "key", resumedStatsCalculator, resumedPairCollector);
+    REQUIRE(resumedCheckpoint.numReads == 6);
+    REQUIRE(resumedCheckpoint.streamPosition.virtualOffset == 123456);
+    REQUIRE(resumedCheckpoint.streamPosition.numRecordsRead == 7);
+    REQUIRE(resumedCheckpoint.readLogSize == -1);
+
+    // Mates of reads cached before the checkpoint are paired after it
+    for (PairCollector* collector : { &pairCollector, &resumedPairCollector })
+    {
+        collector->addIrr(makeRead("frag2", 1, 600), "CAG");
+        collector->addAnchor(makeRead("frag3", 1, 800));
+    }
+
+    REQUIRE(*resumedStatsCalculator.estimate() == *statsCalculator.estimate());
+    REQUIRE(resumedPairCollector.anchorRegions() == pairCollector.anchorRegions());
+    REQUIRE(resumedPairCollector.irrRegions() == pairCollector.irrRegions());
+    REQUIRE(resumedPairCollector.irrRegions().at("CAG").size() == 3);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Runs writing sidecars or evidence bamlets cannot be resumed", "[profile checkpoint]")
+{
+    const string pathToReads = "ProfileCheckpointTest.bam";
+    const string pathToReference = "ProfileCheckpointTest.fa";
+    std::ofstream(pathToReads).close();
+    std::ofstream(pathToReference).close();
+
+    const auto makeParameters = [&](bool writeSidecar, bool writeEvidenceBam, bool resume) {
+        ProfileWorkflowOptions options;
+        options.writeSidecar = writeSidecar;
+        options.resume = resume;
+        options.writeEvidenceBam = writeEvidenceBam;
+        return ProfileWorkflowParameters(
+            "ProfileCheckpointTest", false, pathToReads, pathToReference, Interval(2, 20), 50, 40, options);
+    };
+
+    REQUIRE_NOTHROW(assertValidity(makeParameters(false, false, true)));
+    REQUIRE_NOTHROW(assertValidity(makeParameters(true, true, false)));
+    REQUIRE_THROWS_AS(assertValidity(makeParameters(true, false, true)), std::invalid_argument);
+    REQUIRE_THROWS_AS(assertValidity(makeParameters(false, true, true)), std::invalid_argument);
+
+    std::remove(pathToReads.c_str());
+    std::remove(pathToReference.c_str());
+}
@@ -41,6 +41,17 @@ TEST_CASE("Unit matches to itself", "[calculating purity scores]")
     REQUIRE(MatchUnits(units, bases.begin(), bases.end(), quals.begin(), quals.end()) == Approx(6.0));
 }
 
+TEST_CASE("Scores of unit shifts agree with scores of materialized shifts", "[calculating purity scores]")
+{
+    const string quals = "((PPPPPP((PPP";
+    const string bases = "AATCGTCGACGTN";
+    for (const string unit : { "ACG", "AAG", "CG", "T", "ACGTA" })
+    {
+        const vector<vector<string>> units_shifts = ShiftUnits({ unit });
+        REQUIRE(MatchUnitShiftsRc(unit, bases, quals) == MatchRepeatRc(units_shifts, bases, quals));
+    }
+}
+
 /*
 TEST(TestUnitMatching, MatchesMultipleUnits) {
 string quals = "PPPPPP";
@@ -0,0 +1,114 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ReadLogWriter.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+static string readFile(const string& path)
+{
+    std::ifstream file(path);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+TEST_CASE("Read logs are written in the order pairs are logged", "[read log writer]")
+{
+    const string path = "ReadLogWriterTest.tsv";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 1000 } });
+    const string header = "pair_type\tmotif\tread_type\tread_pos\tmate_type\tmate_pos\tname\n";
+    const string irrPairLine = "irr_pair\tAC_CAG\tirr\tchr1:5-6\tirr\tunaligned\tfrag1\n";
+    const string anchoredIrrLine = "anchored_irr\tCAG\tirr\tchr1:10-11\tanchor\tchr1:20-21\tfrag2\n";
+
+    ReadLogWriter writer(path, contigInfo);
+    writer.logIrrPair("frag1", GenomicRegion(-1, 0, 0), "CAG", GenomicRegion(0, 5, 6), "AC");
+    REQUIRE(writer.flush() == static_cast<int64_t>(header.size() + irrPairLine.size()));
+    REQUIRE(readFile(path) == header + irrPairLine);
+
+    writer.logAnchoredIrr("frag2", "CAG", GenomicRegion(0, 10, 11), GenomicRegion(0, 20, 21));
+    writer.close();
+    REQUIRE(readFile(path) == header + irrPairLine + anchoredIrrLine);
+
+    // Resumed logs drop the lines written after the size was recorded
+    ReadLogWriter resumedWriter(path, contigInfo, header.size());
+    resumedWriter.logAnchoredIrr("frag2", "CAG", GenomicRegion(0, 10, 11), GenomicRegion(0, 20, 21));
+    resumedWriter.close();
+    REQUIRE(readFile(path) == header + anchoredIrrLine);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Read logs hold all pairs logged faster than they are written", "[read log writer]")
+{
+    const string path = "ReadLogWriterTest.tsv";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 1000 } });
+
+    const int numPairs = 100000;
+    ReadLogWriter writer(path, contigInfo);
+    for (int pairIndex = 0; pairIndex != numPairs; ++pairIndex)
+    {
+        writer.logAnchoredIrr(std::to_string(pairIndex), "CAG", GenomicRegion(0, 10, 11), GenomicRegion(0, 20, 21));
+    }
+    writer.close();
+
+    std::ifstream log(path);
+    string line;
+    int numLines = 0;
+    bool isLogInOrder = true;
+    while (std::getline(log, line))
+    {
+        const string fragName = line.substr(line.rfind('\t') + 1);
+        isLogInOrder = isLogInOrder && (numLines == 0 || fragName == std::to_string(numLines - 1));
+        ++numLines;
+    }
+    REQUIRE(isLogInOrder);
+    REQUIRE(numLines == numPairs + 1);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Logging pairs fails once the read log cannot be written", "[read log writer]")
+{
+    // Writes to /dev/full fail with ENOSPC, so the writer thread stops consuming records
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 1000 } });
+    ReadLogWriter writer("/dev/full", contigInfo);
+
+    const auto logPairs = [&]() {
+        for (int pairIndex = 0; pairIndex != 1000000; ++pairIndex)
+        {
+            writer.logAnchoredIrr(
+                std::to_string(pairIndex), "CAG", GenomicRegion(0, 10, 11), GenomicRegion(0, 20, 21));
+        }
+    };
+    REQUIRE_THROWS_AS(logPairs(), std::runtime_error);
+}
@@ -0,0 +1,72 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "profile/ReadNameCodec.hh"
+
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::string;
+using std::vector;
+
+TEST_CASE("Illumina read names are packed into keys that decode to the names", "[read name codec]")
+{
+    ReadNameCodec codec;
+    const string name = "A00123:456:HXXXXDSXX:1:1101:12345:67890";
+    const ReadNameKey key = codec.encode(name);
+
+    REQUIRE(codec.decode(key) == name);
+    REQUIRE(codec.encode(name) == key);
+    REQUIRE(codec.encode("A00123:456:HXXXXDSXX:1:1101:12345:67891") != key);
+    REQUIRE(codec.encode("A00123:456:HYYYYDSXX:1:1101:12345:67890") != key);
+    REQUIRE(codec.numUnstructuredNames() == 0);
+}
+
+TEST_CASE("Other read names are assigned keys until they are released", "[read name codec]")
+{
+    ReadNameCodec codec;
+    const vector<string> names
+        = { "StrA_allele2_12_360_0:0:0_0:0:0_da", "A00123:456:HXXXXDSXX:1:1101:012345:67890",
+            "A00123:456:HXXXXDSXX:1:1101:12345:99999999999", ":1:1101:12345:67890", "1:1101:12345:67890" };
+
+    vector<ReadNameKey> keys;
+    for (const auto& name : names)
+    {
+        keys.push_back(codec.encode(name));
+    }
+
+    REQUIRE(codec.numUnstructuredNames() == names.size());
+    for (size_t index = 0; index != names.size(); ++index)
+    {
+        REQUIRE(codec.encode(names[index]) == keys[index]);
+        REQUIRE(codec.decode(keys[index]) == names[index]);
+    }
+
+    for (const auto& key : keys)
+    {
+        codec.release(key);
+    }
+    REQUIRE(codec.numUnstructuredNames() == 0);
+    REQUIRE_THROWS(codec.decode(keys.front()));
+}
@@ -0,0 +1,92 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/ReadSidecar.hh"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+static Read makeRead(const string& name, const string& bases, int contigId, size_t pos, size_t mapq, size_t flag)
+{
+    Read read;
+    read.name = name;
+    read.bases = bases;
+    read.quals = string(bases.length(), 'F');
+    read.contigId = contigId;
+    read.pos = pos;
+    read.mateContigId = -1;
+    read.matePos = 0;
+    read.mapq = mapq;
+    read.flag = flag;
+    return read;
+}
+
+TEST_CASE("Sidecars keep fragments with candidate in-repeat reads", "[read sidecar]")
+{
+    const string path = "ReadSidecarTest.sidecar";
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 1000 }, { "chr2", 2000 } });
+    const string repeat(60, 'A');
+    const string nonrepeat = "ACGTTGCAAGCTAGGCTTACCGATGCAATCGGATCCTAGAGTCTCAGCATGCTGACCTAG";
+
+    ReadSidecarWriter writer(path, contigInfo, "fingerprint", kLongestSidecarMotif);
+    // Anchored IRR whose anchor precedes the IRR, a pair of IRRs, and a fragment without candidates
+    writer.add(makeRead("frag1", nonrepeat, 0, 100, 60, 0x41));
+    writer.add(makeRead("frag2", repeat, 1, 500, 0, 0x41));
+    writer.add(makeRead("frag3", nonrepeat, 0, 200, 60, 0x41));
+    writer.add(makeRead("frag2", repeat, 1, 600, 0, 0x81));
+    writer.add(makeRead("frag3", nonrepeat, 0, 300, 60, 0x81));
+    writer.add(makeRead("frag1", repeat, -1, 0, 0, 0x85));
+    // Candidate whose mate is missing
+    writer.add(makeRead("frag4", repeat, 1, 700, 0, 0x41));
+    writer.finish(SampleRunStats(60, 35.5));
+    REQUIRE(writer.numFragments() == 2);
+
+    const ReadSidecar sidecar = loadReadSidecar(path);
+    REQUIRE(sidecar.inputFingerprint == "fingerprint");
+    REQUIRE(sidecar.longestMotif == kLongestSidecarMotif);
+    REQUIRE(sidecar.contigInfo.numContigs() == 2);
+    REQUIRE(sidecar.contigInfo.getContigName(1) == "chr2");
+    REQUIRE(sidecar.stats == SampleRunStats(60, 35.5));
+    REQUIRE(sidecar.fragments.size() == 2);
+
+    const Read& repeatMate = sidecar.fragments[0].first;
+    REQUIRE(repeatMate.name == "frag2");
+    REQUIRE(repeatMate.bases == repeat);
+    REQUIRE((repeatMate.contigId == 1 && repeatMate.pos == 500 && repeatMate.matePos == 600));
+
+    // Only alignments of mates that are not candidates are kept
+    const Read& anchor = sidecar.fragments[1].first;
+    const Read& unalignedRepeat = sidecar.fragments[1].second;
+    REQUIRE(anchor.name == "frag1");
+    REQUIRE(anchor.bases.empty());
+    REQUIRE((anchor.contigId == 0 && anchor.pos == 100 && anchor.mapq == 60 && anchor.flag == 0x41));
+    REQUIRE((unalignedRepeat.contigId == -1 && unalignedRepeat.flag == 0x85 && unalignedRepeat.bases == repeat));
+
+    std::remove(path.c_str());
+}
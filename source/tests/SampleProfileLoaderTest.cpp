@@ -0,0 +1,201 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/SampleProfileLoader.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "thirdparty/catch2/catch.hpp"
+
+#include "io/StrProfile.hh"
+
+namespace fs = boost::filesystem;
+
+using std::pair;
+using std::string;
+using std::vector;
+
+using Json = nlohmann::json;
+
+// Profile with binned counts, a fingerprint, a record with empty counts, and a motif outside of the unit range
+static const char* kProfileJson = R"({
+    "AT": {"AnchoredIrrCount": 4, "IrrPairCount": 1, "RegionsWithIrrAnchors": {"chr1:300-400": 4}, "RepeatUnit": "AT"},
+    "BinSize": 1000,
+    "CAG": {
+        "AnchoredIrrCount": 6,
+        "IrrAnchorBins": {"chr2:0-1000": 3, "chr1:0-1000": 2, "unaligned": 1},
+        "IrrPairCount": 2,
+        "RegionsWithIrrAnchors": {"chr2:100-250": 3, "chr1:500-600": 1, "chr1:900-950": 1, "unaligned": 1},
+        "RepeatUnit": "CAG"
+    },
+    "Depth": 31.5,
+    "GGCCCC": {"AnchoredIrrCount": 0, "IrrAnchorBins": {}, "IrrPairCount": 0, "RegionsWithIrrAnchors": {},
+               "RepeatUnit": "GGCCCC"},
+    "InputFingerprint": "size=1024;mtime=1;header=0a1b2c3d",
+    "ReadLength": 150
+})";
+
+static void writeFile(const string& path, const string& contents) { std::ofstream(path) << contents; }
+
+// Loads a profile as the merge did before profiles were streamed: the profile is parsed into a JSON document and
+// decoded into an STR profile, whose records are then added to multisample profiles
+static SampleProfile loadFromDocument(
+    const string& profileJson, const SampleId& sampleId, const ReferenceContigInfo& contigInfo,
+    const ProfileLoadingParameters& parameters)
+{
+    const StrProfile profile = decodeFromJson(Json::parse(profileJson));
+
+    SampleProfile sampleProfile;
+    for (const auto& motifAndRecord : profile.motifRecords)
+    {
+        const string& motif = motifAndRecord.first;
+        if (motif.length() < parameters.shortestUnit || parameters.longestUnit < motif.length())
+        {
+            continue;
+        }
+
+        const MotifRecord& record = motifAndRecord.second;
+        for (const auto& region : parameters.useBins ? record.irrAnchorBins : record.regionsWithIrrAnchors)
+        {
+            const int contigId = region.contigId() == -1
+                ? -1
+                : contigInfo.getContigId(profile.contigInfo.getContigName(region.contigId()));
+            SampleCountFeature sampleCount({ { sampleId, region.feature().value() } });
+            sampleProfile.anchoredIrrProfile[motif].emplace_back(contigId, region.start(), region.end(), sampleCount);
+        }
+
+        if (record.irrPairCount != 0)
+        {
+            sampleProfile.irrPairProfile[motif].emplace(sampleId, record.irrPairCount);
+        }
+    }
+
+    if (parameters.useBins)
+    {
+        sampleProfile.binSize = profile.binSize;
+        for (auto& motifAndBins : sampleProfile.anchoredIrrProfile)
+        {
+            std::sort(motifAndBins.second.begin(), motifAndBins.second.end());
+        }
+    }
+    else
+    {
+        normalize(sampleProfile.anchoredIrrProfile);
+    }
+
+    sampleProfile.parametersForSamples.emplace(sampleId, SampleParameters(profile.readLength, profile.depth));
+    return sampleProfile;
+}
+
+TEST_CASE("Streamed JSON profiles match profiles decoded from a document", "[sample profile loader]")
+{
+    const fs::path directory = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(directory);
+    const string path = (directory / "sample.str_profile.json").string();
+    writeFile(path, kProfileJson);
+
+    // Contigs are listed in another order than in the profile, so contig ids have to be translated
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr2", 5000 }, { "chr1", 10000 } });
+    const ManifestEntry sampleInfo("sample", SampleStatus::kCase, path);
+
+    for (bool useBins : { false, true })
+    {
+        const ProfileLoadingParameters parameters(3, 6, useBins);
+        ProfileBundleCache bundles;
+        const auto streamedProfile = loadSampleProfile(sampleInfo, contigInfo, parameters, bundles);
+        const SampleProfile expectedProfile = loadFromDocument(kProfileJson, "sample", contigInfo, parameters);
+
+        if (useBins)
+        {
+            for (auto& motifAndBins : streamedProfile->anchoredIrrProfile)
+            {
+                std::sort(motifAndBins.second.begin(), motifAndBins.second.end());
+            }
+        }
+
+        REQUIRE(streamedProfile->anchoredIrrProfile.at("CAG").size() == 3);
+        REQUIRE(streamedProfile->anchoredIrrProfile == expectedProfile.anchoredIrrProfile);
+        REQUIRE(streamedProfile->irrPairProfile == expectedProfile.irrPairProfile);
+        REQUIRE(streamedProfile->binSize == expectedProfile.binSize);
+        REQUIRE(streamedProfile->parametersForSamples.at("sample").readLength == 150);
+        REQUIRE(streamedProfile->parametersForSamples.at("sample").depth == 31.5);
+    }
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Multisample profiles with empty counts contribute only sample parameters", "[sample profile loader]")
+{
+    const fs::path directory = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(directory);
+    const string path = (directory / "shard.multisample_profile.json").string();
+    writeFile(
+        path,
+        R"({"Counts": {}, "Parameters": {"Depths": {"s1": 30.0, "s2": 40.0}, "ReadLengths": {"s1": 150, "s2": 100}}})");
+
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 10000 } });
+    ProfileBundleCache bundles;
+    const auto profile = loadSampleProfile(
+        ManifestEntry("shard", SampleStatus::kControl, path), contigInfo, ProfileLoadingParameters(3, 6), bundles);
+
+    REQUIRE(profile->anchoredIrrProfile.empty());
+    REQUIRE(profile->irrPairProfile.empty());
+    REQUIRE(profile->parametersForSamples.size() == 2);
+    REQUIRE(profile->parametersForSamples.at("s2").readLength == 100);
+    REQUIRE(profile->parametersForSamples.at("s2").depth == 40.0);
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Parallel loader returns profiles in manifest order", "[sample profile loader]")
+{
+    const fs::path directory = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(directory);
+
+    Manifest manifest;
+    for (int sampleIndex = 0; sampleIndex != 3; ++sampleIndex)
+    {
+        const string sampleId = "sample" + std::to_string(sampleIndex);
+        const string path = (directory / (sampleId + ".str_profile.json")).string();
+        writeFile(path, R"({"ReadLength": 150, "Depth": )" + std::to_string(30 + sampleIndex) + "}");
+        manifest.emplace_back(sampleId, SampleStatus::kCase, path);
+    }
+
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 10000 } });
+    // There are more threads than samples, so some threads find no profile to load
+    ParallelSampleProfileLoader profileLoader(manifest, contigInfo, ProfileLoadingParameters(3, 6), 8);
+    for (const auto& sampleInfo : manifest)
+    {
+        const auto profile = profileLoader.next();
+        REQUIRE(profile->parametersForSamples.size() == 1);
+        REQUIRE(profile->parametersForSamples.begin()->first == sampleInfo.sample);
+    }
+    REQUIRE_THROWS_AS(profileLoader.next(), std::logic_error);
+
+    fs::remove_all(directory);
+}
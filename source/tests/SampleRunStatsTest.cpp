@@ -0,0 +1,132 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profile/SampleRunStats.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "htslib/sam.h"
+
+#include "io/HtsFileStreamer.hh"
+#include "thirdparty/catch2/catch.hpp"
+
+namespace fs = boost::filesystem;
+
+using std::pair;
+using std::string;
+using std::vector;
+
+TEST_CASE("Depth is the median depth of contigs with reads", "[sample run stats]")
+{
+    const ReferenceContigInfo contigInfo(
+        vector<pair<string, int64_t>>{ { "chr1", 1000 }, { "chr2", 2000 }, { "chr3", 3000 }, { "chr4", 500 } });
+    SampleRunStatsCalculator calculator(contigInfo);
+    REQUIRE(!calculator.estimate());
+
+    // Depths of 10x, 5x, and 20x on the first three contigs; unaligned reads only count towards read length
+    for (int readIndex = 0; readIndex != 100; ++readIndex)
+    {
+        calculator.inspect(0, 100);
+        calculator.inspect(1, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(2, 100);
+        calculator.inspect(-1, 100);
+    }
+
+    REQUIRE(calculator.numIndexedReads() == 0);
+    REQUIRE(*calculator.estimate() == SampleRunStats(100, 10.0));
+}
+
+static void writeBam(const string& pathToSam, const string& pathToBam)
+{
+    samFile* samFilePtr = sam_open(pathToSam.c_str(), "r");
+    samFile* bamFilePtr = sam_open(pathToBam.c_str(), "wb");
+    bam_hdr_t* headerPtr = sam_hdr_read(samFilePtr);
+    bam1_t* alignmentPtr = bam_init1();
+    REQUIRE(sam_hdr_write(bamFilePtr, headerPtr) == 0);
+    while (sam_read1(samFilePtr, headerPtr, alignmentPtr) >= 0)
+    {
+        REQUIRE(sam_write1(bamFilePtr, headerPtr, alignmentPtr) >= 0);
+    }
+    bam_destroy1(alignmentPtr);
+    bam_hdr_destroy(headerPtr);
+    sam_close(bamFilePtr);
+    sam_close(samFilePtr);
+}
+
+static SampleRunStats streamStats(const string& pathToReads, SampleRunStatsCalculator& calculator)
+{
+    HtsFileStreamer reads(pathToReads, "");
+    while (reads.trySeekingToNextPrimaryAlignment())
+    {
+        calculator.inspect(reads.currentReadContigId(), reads.currentReadLength());
+    }
+
+    return *calculator.estimate();
+}
+
+TEST_CASE("Index counts are scaled by the fraction of primary alignments", "[sample run stats]")
+{
+    const fs::path directory = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(directory);
+    const string pathToSam = (directory / "reads.sam").string();
+    const string pathToBam = (directory / "reads.bam").string();
+    std::ofstream(pathToSam) << "@HD\tVN:1.6\tSO:coordinate\n"
+                                "@SQ\tSN:chr1\tLN:40\n"
+                                "r1\t0\tchr1\t1\t60\t10M\t*\t0\t0\tACGTACGTAC\t*\n"
+                                "r2\t0\tchr1\t5\t60\t10M\t*\t0\t0\tACGTACGTAC\t*\n"
+                                "r1\t256\tchr1\t10\t0\t10M\t*\t0\t0\tACGTACGTAC\t*\n"
+                                "r2\t2048\tchr1\t20\t60\t10M\t*\t0\t0\tACGTACGTAC\t*\n"
+                                "r3\t0\tchr1\t30\t60\t10M\t*\t0\t0\tACGTACGTAC\t*\n";
+    writeBam(pathToSam, pathToBam);
+    const ReferenceContigInfo contigInfo(vector<pair<string, int64_t>>{ { "chr1", 40 } });
+
+    SampleRunStatsCalculator streamingCalculator(contigInfo);
+    REQUIRE(!streamingCalculator.tryLoadingIndexStats(pathToBam, ""));
+    const SampleRunStats streamedStats = streamStats(pathToBam, streamingCalculator);
+    REQUIRE(streamedStats == SampleRunStats(10, 0.75));
+
+    REQUIRE(sam_index_build(pathToBam.c_str(), 0) == 0);
+
+    // The index counts all five alignments; sampling the whole file shows that three of them are primary
+    SampleRunStatsCalculator indexCalculator(contigInfo);
+    REQUIRE(indexCalculator.tryLoadingIndexStats(pathToBam, ""));
+    REQUIRE(indexCalculator.numIndexedReads() == 3);
+    REQUIRE(*indexCalculator.estimate() == streamedStats);
+    REQUIRE(streamStats(pathToBam, indexCalculator) == streamedStats);
+
+    // The first record alone suggests that all alignments are primary
+    SampleRunStatsCalculator sampledCalculator(contigInfo);
+    REQUIRE(sampledCalculator.tryLoadingIndexStats(pathToBam, "", 1));
+    REQUIRE(*sampledCalculator.estimate() == SampleRunStats(10, 1.25));
+
+    fs::remove_all(directory);
+}
@@ -0,0 +1,79 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge/SpilledAnchoredIrrProfile.hh"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+
+static void checkOutOfCoreMerge(size_t maxOpenRuns)
+{
+    MultisampleAnchoredIrrProfile expectedProfile;
+    // A budget of one byte spills every sample into its own run
+    SpilledAnchoredIrrProfile spilledProfile("SpilledAnchoredIrrProfileTest.run", 1, maxOpenRuns);
+
+    for (int sampleIndex = 0; sampleIndex != 20; ++sampleIndex)
+    {
+        const string sampleId = "sample" + std::to_string(sampleIndex);
+        MultisampleAnchoredIrrProfile sampleProfile;
+        for (int regionIndex = 0; regionIndex != 10; ++regionIndex)
+        {
+            const int contigId = regionIndex % 3 - 1;
+            const int64_t start = contigId == -1 ? 0 : (sampleIndex * 397 + regionIndex * 1009) % 5000;
+            const int64_t end = contigId == -1 ? 0 : start + 150;
+            const Motif motif = regionIndex % 2 ? "CAG" : "GGCCCC";
+            add(sampleId, motif, GenomicRegion(contigId, start, end), sampleIndex + regionIndex, sampleProfile);
+            add(sampleId, motif, GenomicRegion(contigId, start, end), sampleIndex + regionIndex, expectedProfile);
+        }
+        normalize(sampleProfile);
+        spilledProfile.add(sampleProfile);
+    }
+    normalize(expectedProfile);
+
+    map<Motif, vector<RegionWithSampleCount>> observedProfile;
+    spilledProfile.merge([&observedProfile](const Motif& motif, const vector<RegionWithSampleCount>& regions) {
+        REQUIRE(observedProfile.find(motif) == observedProfile.end());
+        observedProfile.emplace(motif, regions);
+    });
+
+    REQUIRE(observedProfile.size() == expectedProfile.size());
+    for (const auto& motifAndRegions : observedProfile)
+    {
+        REQUIRE(motifAndRegions.second == expectedProfile[motifAndRegions.first]);
+    }
+    REQUIRE(std::fopen("SpilledAnchoredIrrProfileTest.run0.tmp", "r") == nullptr);
+}
+
+TEST_CASE("Out-of-core merge matches in-memory merge", "[spilled profile]") { checkOutOfCoreMerge(64); }
+
+TEST_CASE("Out-of-core merge combines runs in several passes", "[spilled profile]")
+{
+    // Twenty runs merged at most three at a time are combined into longer runs over several passes
+    checkOutOfCoreMerge(3);
+}
@@ -0,0 +1,159 @@
+//
+// ExpansionHunter Denovo
+// Copyright 2016-2019 Illumina, Inc.
+// All rights reserved.
+//
+// Author: Egor Dolzhenko <edolzhenko@illumina.com>,
+//         Michael Eberle <meberle@illumina.com>
+//
+// Licensed under the PolyForm Strict License 1.0.0
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://polyformproject.org/licenses/strict/1.0.0
+//
+// As far as the law allows, the software comes as is, without
+// any warranty or condition, and the licensor will not be liable
+// to you for any damages arising out of these terms or the use
+// or nature of the software, under any kind of legal claim.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/BinaryStrProfile.hh"
+#include "io/StrProfile.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "thirdparty/catch2/catch.hpp"
+
+#include "common/BinaryCoding.hh"
+#include "io/CompressedFile.hh"
+
+using std::string;
+using std::vector;
+
+TEST_CASE("Integers survive binary encoding", "[binary coding]")
+{
+    BinaryEncoder encoder;
+    encoder.writeVarint(0);
+    encoder.writeVarint(300);
+    encoder.writeVarint(UINT64_MAX);
+    encoder.writeSignedVarint(-12345);
+    encoder.writeDouble(37.81827259111333);
+    encoder.writeString("chr1");
+
+    const string& buffer = encoder.buffer();
+    BinaryDecoder decoder(buffer.data(), buffer.data() + buffer.size());
+    REQUIRE(decoder.readVarint() == 0);
+    REQUIRE(decoder.readVarint() == 300);
+    REQUIRE(decoder.readVarint() == UINT64_MAX);
+    REQUIRE(decoder.readSignedVarint() == -12345);
+    REQUIRE(decoder.readDouble() == 37.81827259111333);
+    REQUIRE(decoder.readString() == "chr1");
+    REQUIRE(decoder.atEnd());
+    REQUIRE_THROWS(decoder.readVarint());
+}
+
+TEST_CASE("Binary STR profiles can be converted to JSON and back", "[str profile formats]")
+{
+    ReferenceContigInfo contigInfo({ { "chr1", 1000 }, { "chr2", 2000 }, { "chr3", 3000 } });
+    StrProfile profile(contigInfo);
+    profile.readLength = 150;
+    profile.depth = 31.7;
+
+    MotifRecord& ccgRecord = profile.motifRecords["CCG"];
+    ccgRecord.anchoredIrrCount = 7;
+    ccgRecord.irrPairCount = 3;
+    ccgRecord.regionsWithIrrAnchors = { { -1, 0, 0, CountFeature(2) },
+                                        { 2, 100, 900, CountFeature(4) },
+                                        { 2, 50, 60, CountFeature(1) } };
+
+    MotifRecord& unusualRecord = profile.motifRecords["AACN"];
+    unusualRecord.irrPairCount = 12;
+
+    const string binaryEncoding = encodeAsBinary(profile);
+    REQUIRE(hasBinaryStrProfileMagic(binaryEncoding.data(), binaryEncoding.size()));
+
+    const StrProfile decodedProfile = decodeFromBinary(binaryEncoding);
+    REQUIRE(decodedProfile.contigInfo.numContigs() == 1);
+    REQUIRE(decodedProfile.contigInfo.getContigSize(0) == 3000);
+    REQUIRE(encodeAsJson(decodedProfile) == encodeAsJson(profile));
+
+    const StrProfile profileFromJson = decodeFromJson(encodeAsJson(profile));
+    REQUIRE(encodeAsJson(decodeFromBinary(encodeAsBinary(profileFromJson))) == encodeAsJson(profile));
+}
+
+TEST_CASE("Anchored IRRs are counted in reference bins", "[str profile formats]")
+{
+    const vector<RegionWithCount> anchors = { { 1, 1500, 1650, CountFeature(1) },
+                                                   { 0, 999, 1100, CountFeature(1) },
+                                                   { -1, 0, 0, CountFeature(1) },
+                                                   { 1, 1999, 2100, CountFeature(1) },
+                                                   { -1, 0, 0, CountFeature(1) } };
+
+    const vector<RegionWithCount> expectedBins
+        = { { -1, 0, 0, CountFeature(2) }, { 0, 0, 1000, CountFeature(1) }, { 1, 1000, 2000, CountFeature(2) } };
+    REQUIRE(computeIrrAnchorBins(anchors, 1000) == expectedBins);
+
+    ReferenceContigInfo contigInfo({ { "chr1", 5000 }, { "chr2", 5000 } });
+    StrProfile profile(contigInfo);
+    profile.binSize = 1000;
+    profile.motifRecords["AAG"].irrAnchorBins = expectedBins;
+
+    const StrProfile decodedProfile = decodeFromBinary(encodeAsBinary(profile));
+    REQUIRE(decodedProfile.binSize == 1000);
+    REQUIRE(encodeAsJson(decodedProfile) == encodeAsJson(profile));
+    REQUIRE(decodeFromJson(encodeAsJson(profile)).motifRecords["AAG"].irrAnchorBins == expectedBins);
+}
+
+TEST_CASE("Input fingerprints are kept in both profile formats", "[str profile formats]")
+{
+    ReferenceContigInfo contigInfo({ { "chr1", 5000 } });
+    StrProfile profile(contigInfo);
+    profile.inputFingerprint = "cbc4482004fafbf9";
+    profile.motifRecords["CAG"].regionsWithIrrAnchors = { { 0, 100, 200, CountFeature(3) } };
+
+    const StrProfile decodedProfile = decodeFromBinary(encodeAsBinary(profile));
+    REQUIRE(decodedProfile.inputFingerprint == profile.inputFingerprint);
+    REQUIRE(decodedProfile.binSize == 0);
+    REQUIRE(encodeAsJson(decodedProfile) == encodeAsJson(profile));
+    REQUIRE(decodeFromJson(encodeAsJson(profile)).inputFingerprint == profile.inputFingerprint);
+}
+
+TEST_CASE("Region counts of corrupted binary profiles raise format errors", "[str profile formats]")
+{
+    ReferenceContigInfo contigInfo({ { "chr1", 5000 } });
+    StrProfile profile(contigInfo);
+    profile.motifRecords["CAG"].irrPairCount = 1;
+
+    // The encoding ends with the (zero) number of regions of the only motif, which is replaced by a huge count
+    string encoding = encodeAsBinary(profile);
+    REQUIRE(encoding.back() == 0);
+    encoding.pop_back();
+    BinaryEncoder encoder;
+    encoder.writeVarint(uint64_t(1) << 60);
+    encoding += encoder.buffer();
+
+    REQUIRE_THROWS_AS(decodeFromBinary(encoding), std::runtime_error);
+}
+
+TEST_CASE("Compressed STR profiles are recognized when loaded", "[str profile formats]")
+{
+    ReferenceContigInfo contigInfo({ { "chr1", 5000 } });
+    StrProfile profile(contigInfo);
+    profile.readLength = 150;
+    profile.depth = 30.0;
+    profile.motifRecords["CAG"].regionsWithIrrAnchors = { { 0, 100, 200, CountFeature(3) } };
+
+    const string path = "StrProfileTest.str_profile.bin.gz";
+    writeBgzfFile(path, encodeAsBinary(profile), 2);
+    REQUIRE(detectStrProfileFormat(path) == StrProfileFormat::kBinary);
+
+    DecompressionThreadPool threadPool(2);
+    REQUIRE(encodeAsJson(loadStrProfile(path, &threadPool)) == encodeAsJson(profile));
+    REQUIRE(encodeAsJson(loadStrProfile(path)) == encodeAsJson(profile));
+
+    std::remove(path.c_str());
+}